@@ -23,9 +23,14 @@
 #define __AUTHENTICATOR_H__
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+
+#include <jsoncons/json.hpp>
 
 #include "IAuthenticator.hpp"
+#include "TokenExpiryScheduler.hpp"
 
 using namespace std;
 
@@ -37,6 +42,21 @@ class Authenticator : public IAuthenticator {
   string algorithm = "RS256";
   std::shared_ptr<ILogger> logger;
 
+  // claims of a token whose signature has been verified
+  struct VerifiedToken {
+    jsoncons::json claims;
+    int64_t exp;
+  };
+  static constexpr size_t MAX_CACHED_TOKENS = 1024;
+  // verified tokens by SHA-256 of the token, cleared when the key changes
+  std::unordered_map<string, std::shared_ptr<const VerifiedToken>> tokenCache;
+  // incremented with every key change, guarded by tokenCacheMutex like pubkey
+  uint64_t keyGeneration = 0;
+  std::mutex tokenCacheMutex;
+
+  TokenExpiryScheduler expiryScheduler;
+
+  std::shared_ptr<const VerifiedToken> verifiedToken(const string &authToken);
   int validateToken(KuksaChannel& channel, string authToken);
 
  public:
@@ -48,6 +68,8 @@ class Authenticator : public IAuthenticator {
   void updatePubKey(string key);
   bool isStillValid(KuksaChannel &channel);
   void resolvePermissions(KuksaChannel &channel);
+  /** Called after tokens of authorized channels have expired */
+  void setTokenExpiryHandler(TokenExpiryScheduler::ExpiryHandler handler);
 
   static string getPublicKeyFromFile(string fileName, std::shared_ptr<ILogger> logger);
 };
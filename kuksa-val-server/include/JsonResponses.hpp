@@ -80,6 +80,15 @@ namespace JsonResponses {
   void convertJSONTimeStampToISO8601(jsoncons::json& jsontarget);
 
   std::string getTimeStampZero();
+
+  /** Messages to clients are written compactly, unless pretty printing is
+   *  enabled, which is meant for debugging */
+  void setPrettyPrint(bool pretty);
+  bool isPrettyPrint();
+
+  /** Appends json as sent to clients to out */
+  void serialize(const jsoncons::json& json, std::string& out);
+  std::string serialize(const jsoncons::json& json);
 }
 
 #endif
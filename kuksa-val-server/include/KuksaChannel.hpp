@@ -23,16 +23,22 @@
 #define __KUKSA_CHANNEL_H__
 
 #include <stdint.h>
+#include <atomic>
+#include <memory>
 #include <jsoncons/json.hpp>
 #include <string>
 #include <boost/uuid/uuid_io.hpp>  
 #include <boost/functional/hash.hpp>
 #include "kuksa.grpc.pb.h"
+#include "VssAccessCache.hpp"
+#include "VssPermissionMatcher.hpp"
 
 using namespace std;
 using namespace jsoncons;
 using jsoncons::json;
 
+class VssGrpcStreamWriter;
+
 struct gRPCUUIDHasher
 {
   std::size_t operator()(const boost::uuids::uuid& k) const
@@ -60,27 +66,57 @@ class KuksaChannel {
  private:
   uint64_t connectionID;
   bool authorized = false;
+  // shared by all copies of the channel, set once its token has expired
+  std::shared_ptr<std::atomic<bool>> tokenExpired;
   bool modifyTree = false;
   string authToken;
   json permissions;
+  // compiled from permissions, shared by all copies of the channel
+  std::shared_ptr<const VssPermissionMatcher> permissionMatcher;
+  // decisions of permissionMatcher, replaced together with it
+  std::shared_ptr<VssAccessCache> accessCache;
   Type typeOfConnection;
   
  public:
 
   void setConnID(uint64_t conID) { connectionID = conID; }
-  void setAuthorized(bool isauth) { authorized = isauth; }
+  void setAuthorized(bool isauth) {
+    authorized = isauth;
+    // a new authorization does not expire with the token of an earlier one
+    tokenExpired = isauth ? std::make_shared<std::atomic<bool>>(false) : nullptr;
+  }
+  /** Marks the token of this channel and of all its copies as expired */
+  void expireToken() {
+    authorized = false;
+    if (tokenExpired) {
+      tokenExpired->store(true);
+    }
+  }
   void setAuthToken(string tok) { authToken = tok; }
-  void setPermissions(json perm) { permissions = perm; }
+  void setPermissions(json perm) {
+    permissions = perm;
+    permissionMatcher = VssPermissionMatcher::compile(permissions);
+    accessCache = std::make_shared<VssAccessCache>();
+  }
   void setType(Type type) { typeOfConnection = type; }
   void enableModifyTree (){ modifyTree = true; }
 
   uint64_t getConnID() const { return connectionID; }
-  bool isAuthorized() const { return authorized; }
+  bool isAuthorized() const { return authorized && !isTokenExpired(); }
+  bool isTokenExpired() const { return tokenExpired && tokenExpired->load(); }
+  /** Expiry state shared by the copies of an authorized channel, nullptr if not authorized */
+  std::weak_ptr<std::atomic<bool>> getTokenExpiry() const { return tokenExpired; }
   bool authorizedToModifyTree() const { return modifyTree; }
   string getAuthToken() const { return authToken; }
   json getPermissions() const { return permissions; }
+  /** nullptr if no permissions have been set */
+  const VssPermissionMatcher *getPermissionMatcher() const { return permissionMatcher.get(); }
+  /** nullptr if no permissions have been set */
+  VssAccessCache *getAccessCache() const { return accessCache.get(); }
   Type getType() const { return typeOfConnection; }
   std::shared_ptr<gRPCSubscriptionMap_t> grpcSubsMap;
+  // writes the notifications of a gRPC subscribe stream, shared by all copies
+  std::shared_ptr<VssGrpcStreamWriter> grpcWriter;
 
   KuksaChannel ( const KuksaChannel & ) = default;
   KuksaChannel (  ) = default;
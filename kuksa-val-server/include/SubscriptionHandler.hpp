@@ -22,13 +22,15 @@
 #ifndef __SUBSCRIPTIONHANDLER_H__
 #define __SUBSCRIPTIONHANDLER_H__
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <unordered_map>
 #include <string>
 #include <thread>
 #include <memory>
+#include <vector>
 
 #include <boost/uuid/uuid.hpp> 
 #include <boost/functional/hash.hpp>
@@ -42,6 +44,7 @@
 #include "IServer.hpp"
 #include "IPublisher.hpp"
 #include "VSSPath.hpp"
+#include "VssNotificationPayload.hpp"
 
 class AccessChecker;
 class Authenticator;
@@ -63,14 +66,12 @@ struct UUIDHasher
 };
 using subscriptions_t = std::unordered_map<SubscriptionId, KuksaChannel, UUIDHasher>;
 using subscription_keys_t = struct subscription_keys {
-  std::string path;
+  VSSPath path;
   std::string attribute;
 
   // constructor
-  subscription_keys(std::string path, std::string attr) {
-      this->path = path;
-      this->attribute = attr;
-  }
+  subscription_keys(VSSPath path, std::string attr)
+      : path(std::move(path)), attribute(std::move(attr)) {}
 
   // Equal operator
   bool operator==(const subscription_keys &p) const {
@@ -80,10 +81,26 @@ using subscription_keys_t = struct subscription_keys {
 
 struct SubscriptionKeyHasher {
   std::size_t operator() (const subscription_keys_t& key) const {
-    return (std::hash<VSSPath>()(VSSPath::fromVSS(key.path)) ^ std::hash<std::string>()(key.attribute));
+    return (key.path.hash() ^ std::hash<std::string>()(key.attribute));
   }
 };
 
+/** What happens to a new notification when the queue of its subscriber is full */
+enum class VssOverflowPolicy {
+  CONFLATE,     //!< replace the queued notification of the same subscription, if there is none drop the oldest
+  DROP_OLDEST,  //!< drop the oldest queued notification
+  DISCONNECT    //!< cancel all subscriptions of the subscriber and close its connection
+};
+
+/** Maps "conflate", "drop-oldest" and "disconnect" to VssOverflowPolicy. Returns false for anything else */
+bool overflowPolicyFromString(const std::string &name, VssOverflowPolicy &policy);
+
+struct SubscriberQueueConfig {
+  /** Notifications queued per client connection at most */
+  size_t capacity = 1000;
+  VssOverflowPolicy overflowPolicy = VssOverflowPolicy::CONFLATE;
+};
+
 class SubscriptionHandler : public ISubscriptionHandler {
  private:
   std::unordered_map<subscription_keys_t, subscriptions_t, SubscriptionKeyHasher> subscriptions;
@@ -92,19 +109,54 @@ class SubscriptionHandler : public ISubscriptionHandler {
   std::vector<std::shared_ptr<IPublisher>> publishers_;
   std::shared_ptr<IAuthenticator> validator;
   std::shared_ptr<IAccessChecker> checkAccess;
-  mutable std::mutex subMutex;
   mutable std::mutex accessMutex;
-  std::condition_variable c;
-  std::thread subThread;
-  bool threadRun;
-  //Tuple is UUID, channel object, vss datatye and jsoncons object for value
-  std::queue<std::tuple<SubscriptionId, KuksaChannel, std::string, jsoncons::json>> buffer;
+
+  //Tuple is UUID, channel object and the update, shared by all its subscribers
+  using Notification = std::tuple<SubscriptionId, KuksaChannel, std::shared_ptr<const VssNotificationPayload>>;
+
+  // Notifications waiting to be sent to one client connection, bounded by
+  // SubscriberQueueConfig::capacity
+  struct SubscriberQueue {
+    std::deque<Notification> pending;
+    // sequence number of pending.front()
+    uint64_t popped = 0;
+    // sequence number of the newest queued notification per subscription,
+    // only kept when conflating
+    std::unordered_map<SubscriptionId, uint64_t, UUIDHasher> newest;
+  };
+
+  // Notifications are sent by a pool of dispatch threads. Each connection is
+  // assigned to one of them, so its notifications keep their order.
+  struct DispatchShard {
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::unordered_map<ConnectionId, SubscriberQueue> subscribers;
+    bool signaled = false;
+    std::thread thread;
+  };
+  std::vector<std::unique_ptr<DispatchShard>> shards;
+  unsigned dispatchThreads;
+  SubscriberQueueConfig queueConfig;
+  std::atomic<bool> threadRun;
+
+  std::atomic<uint64_t> droppedCount{0};
+  std::atomic<uint64_t> conflatedCount{0};
+  std::atomic<uint64_t> disconnectedCount{0};
+
+  size_t shardIndex(const KuksaChannel &channel) const;
+  void enqueue(std::vector<Notification> &notifications);
+  bool push(SubscriberQueue &queue, Notification &notification);
+  void popFront(SubscriberQueue &queue);
+  void dispatchRunner(DispatchShard &shard);
+  void dispatch(Notification &notification);
 
  public:
   SubscriptionHandler(std::shared_ptr<ILogger> loggerUtil,
                       std::shared_ptr<IServer> wserver,
                       std::shared_ptr<IAuthenticator> authenticate,
-                      std::shared_ptr<IAccessChecker> checkAccess);
+                      std::shared_ptr<IAccessChecker> checkAccess,
+                      unsigned dispatchThreads = 1,
+                      SubscriberQueueConfig queueConfig = SubscriberQueueConfig());
   ~SubscriptionHandler();
 
   void addPublisher(std::shared_ptr<IPublisher> publisher){
@@ -112,16 +164,27 @@ class SubscriptionHandler : public ISubscriptionHandler {
   }
   SubscriptionId subscribe(KuksaChannel& channel,
                            std::shared_ptr<IVssDatabase> db,
-                           const std::string &path, const std::string& attr);
+                           const VSSPath &path, const std::string& attr);
   int unsubscribe(SubscriptionId subscribeID);
   int unsubscribeAll(KuksaChannel channel);
+  int unsubscribeExpired();
   int publishForVSSPath(const VSSPath path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json &value);
+  int publishForVSSPaths(const std::vector<VssSignalUpdate>& updates, const std::string& attr);
+
+
+  struct DispatchStats {
+    uint64_t dropped;
+    uint64_t conflated;
+    uint64_t disconnected;
 
+    std::string toString() const;
+  };
+  /** Notifications lost because the queue of their subscriber was full */
+  DispatchStats getDispatchStats() const;
 
   std::shared_ptr<IServer> getServer();
   int startThread();
   int stopThread();
   bool isThreadRunning() const;
-  void* subThreadRunner();
 };
 #endif
@@ -0,0 +1,96 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+/** Expires the authorization of channels when the "exp" time of their token
+ *  is reached, see KuksaChannel::expireToken.
+ *
+ *  Authorizations are kept in a hashed timer wheel with one slot per second.
+ *  A thread, started with the first authorization, advances the wheel every
+ *  second and only looks at the slot of that second. Authorizations of
+ *  channels whose copies are all gone are dropped when their slot is passed.
+ */
+
+#ifndef __TOKENEXPIRYSCHEDULER_HPP__
+#define __TOKENEXPIRYSCHEDULER_HPP__
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "KuksaChannel.hpp"
+
+class ILogger;
+
+class TokenExpiryScheduler {
+  public:
+    static constexpr int64_t SLOTS = 512;
+
+    using ExpiryHandler = std::function<void()>;
+
+    TokenExpiryScheduler(std::shared_ptr<ILogger> logger);
+    ~TokenExpiryScheduler();
+
+    /** Called after tokens have expired, e.g. to drop their subscriptions */
+    void setExpiryHandler(ExpiryHandler handler);
+
+    /** Expires the authorization of an authorized channel, and of all its
+     *  copies, at exp (seconds since epoch) */
+    void schedule(const KuksaChannel &channel, int64_t exp);
+
+    /** Expires all authorizations due at now (seconds since epoch). Done by
+     *  the thread every second. Returns the number of expired authorizations */
+    size_t advance(int64_t now);
+
+    /** Number of scheduled authorizations */
+    size_t size() const;
+
+    static int64_t now();
+
+  private:
+    struct Entry {
+      int64_t exp;
+      std::weak_ptr<std::atomic<bool>> tokenExpired;
+    };
+
+    void run();
+
+    std::shared_ptr<ILogger> logger_;
+    ExpiryHandler handler_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::vector<Entry>> wheel_;
+    int64_t lastTick_;
+    size_t size_ = 0;
+
+    std::mutex threadMutex_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+    bool running_ = false;
+};
+
+#endif
@@ -24,45 +24,94 @@
  *    - a VISS GEN2 path, i.e. Vehicle/Speed
  *    - a VISS GEN1 path, i.e. Vehicle.Speed
  *    - a JSON path, i.e $['Vehicle']['Speed']
+ *
+ *  Paths of the VSS model are interned: a VSSPath is a cheap handle to an
+ *  entry of a process wide path table, holding the GEN2 path, its hash and
+ *  a stable id. Only the tree index adds paths to the table. Parsing a path
+ *  already in the table does not allocate (up to MAX_INLINE_PATH
+ *  characters), any other path is owned by its handle and has id 0, so
+ *  clients can not grow the table. The GEN1 and JSON representations are
+ *  only built when requested.
  */
   
 #ifndef __VSSPATH_HPP__
 #define __VSSPATH_HPP__
 
+#include <stdint.h>
+#include <memory>
+#include <mutex>
 #include <string>
 
+#include <boost/utility/string_view.hpp>
+
 class VSSPath {
     public:
-        std::string getVSSPath() const;
-        std::string getVSSGen1Path() const;
-        std::string getJSONPath() const;
+        /** Entry of the path table. Never freed while interned */
+        struct Entry {
+          std::string vsspath;
+          std::size_t hash;
+          // 0 for paths not interned
+          uint32_t id;
+
+          mutable std::once_flag gen1Once;
+          mutable std::string vssgen1path;
+          mutable std::once_flag jsonOnce;
+          mutable std::string jsonpath;
+        };
+
+        const std::string &getVSSPath() const { return entry_->vsspath; }
+        const std::string &getVSSGen1Path() const;
+        const std::string &getJSONPath() const;
         std::string to_string() const;
-        bool isGen1Origin() const;
-        static VSSPath fromVSSGen2(std::string vss); //Expect Gen2 path
-        static VSSPath fromVSSGen1(std::string vssgen1); //Expect Gen1 path
-        static VSSPath fromJSON(std::string json, bool gen1); //Expect json path
-        static VSSPath fromVSS(std::string vss); //Auto decide for Gen1 or Gen2
-        inline bool operator==(const VSSPath& other) { return (vsspath == other.vsspath); };
+        bool isGen1Origin() const { return gen1_; }
+        /** Stable id of the GEN2 path within this process, 0 if not interned */
+        uint32_t id() const { return entry_->id; }
+        std::size_t hash() const { return entry_->hash; }
+
+        static VSSPath fromVSSGen2(boost::string_view vss); //Expect Gen2 path
+        static VSSPath fromVSSGen1(boost::string_view vssgen1); //Expect Gen1 path
+        static VSSPath fromJSON(boost::string_view json, bool gen1); //Expect json path
+        static VSSPath fromVSS(boost::string_view vss); //Auto decide for Gen1 or Gen2
+        /** Adds GEN2 path vss to the path table, so it gets an id. Only for
+         *  paths of the VSS model. Returns a path with id 0, if the table is
+         *  full */
+        static VSSPath internVSSGen2(boost::string_view vss);
+        /** Interned path with the given id, as a GEN2 path. Throws
+         *  std::out_of_range if no path has this id */
+        static VSSPath fromId(uint32_t id);
+
+        /** Number of interned paths */
+        static size_t internedCount();
+
+        /** Ids run from 1 to MAX_INTERNED_PATHS. The id definition of the
+         *  request schema (VSSRequestJsonSchema.hpp) uses it as maximum */
+        static constexpr size_t MAX_INTERNED_PATHS = 1 << 18;
+        static constexpr size_t MAX_INLINE_PATH = 256;
 
         inline bool operator< (const VSSPath& other) const {
-          return vsspath < other.vsspath;
+          return getVSSPath() < other.getVSSPath();
         }
 
     private:
-        std::string vsspath;
-        std::string vssgen1path;
-        std::string jsonpath;
+        const Entry *entry_;
+        // only set for paths, which are not in the table
+        std::shared_ptr<const Entry> owned_;
         bool gen1_;
 
-        static std::string gen1togen2(std::string input);
-        static std::string gen2togen1(std::string input);
-        static std::string gen2tojson(std::string input);
-        static std::string jsontogen2(std::string input);
-        
+        static std::string gen1togen2(boost::string_view input);
+        static std::string gen2togen1(boost::string_view input);
+        static std::string gen2tojson(boost::string_view input);
+        static std::string jsontogen2(boost::string_view input);
+        static VSSPath lookup(boost::string_view vss, bool gen1origin);
+        static VSSPath owned(boost::string_view vss, bool gen1origin);
 
-        VSSPath(std::string vss, std::string vssgen1, std::string jsonpath, bool gen1origin);
+        VSSPath(const Entry *entry, std::shared_ptr<const Entry> owned, bool gen1origin);
     
-    friend inline bool operator==(const VSSPath& lhs, const VSSPath& rhs) { return (lhs.vsspath == rhs.vsspath); };
+    friend inline bool operator==(const VSSPath& lhs, const VSSPath& rhs) {
+      // interned paths are equal if they share the entry
+      return lhs.entry_ == rhs.entry_ ||
+             ((lhs.entry_->id == 0 || rhs.entry_->id == 0) && lhs.entry_->vsspath == rhs.entry_->vsspath);
+    };
     friend inline bool operator!=(const VSSPath& lhs, const VSSPath& rhs) { return !(lhs == rhs); };
 
 };
@@ -75,12 +124,8 @@ namespace std {
   {
     std::size_t operator()(const VSSPath& vp) const
     {
-      using std::size_t;
-      using std::hash;
-      using std::string;
       //based on VSSPAth equality, we really only need to hash vsspath
-      return hash<std::string>()(vp.getVSSPath());
-
+      return vp.hash();
     }
   };
 
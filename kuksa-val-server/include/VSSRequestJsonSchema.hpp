@@ -35,7 +35,13 @@ static const char* SCHEMA_GET=R"(
     "title": "Get Request",
     "description": "Get the value of one or more vehicle signals and data attributes",
     "type": "object",
-    "required": ["action", "path", "requestId" ],
+    "required": ["action", "requestId" ],
+    "anyOf": [
+        { "required": ["path"] },
+        { "required": ["paths"], "properties": { "action": { "enum": [ "get" ] } } },
+        { "required": ["id"], "properties": { "action": { "enum": [ "get" ] } } },
+        { "required": ["ids"], "properties": { "action": { "enum": [ "get" ] } } }
+    ],
     "properties": {
         "action": {
             "enum": [ "get", "getMetaData" ],
@@ -48,6 +54,25 @@ static const char* SCHEMA_GET=R"(
         "path": {
             "$ref": "viss#/definitions/path"
         },
+        "paths": {
+            "description": "Gets all given paths at once. All values are read from the same state of the server.",
+            "type": "array",
+            "minItems": 1,
+            "items": {
+                "$ref": "viss#/definitions/path"
+            }
+        },
+        "id": {
+            "$ref": "viss#/definitions/id"
+        },
+        "ids": {
+            "description": "Like paths, with the ids returned by resolve.",
+            "type": "array",
+            "minItems": 1,
+            "items": {
+                "$ref": "viss#/definitions/id"
+            }
+        },
         "requestId": {
             "$ref": "viss#/definitions/requestId"
         }
@@ -62,7 +87,12 @@ static const char* SCHEMA_SET=R"(
     "title": "Set Request",
     "description": "Enables the client to set one or more values once.",
     "type": "object",
-    "required": ["action", "path", "requestId"],
+    "required": ["action", "requestId"],
+    "anyOf": [
+        { "required": ["path"] },
+        { "required": ["id"] },
+        { "required": ["values"] }
+    ],
     "properties": {
         "action": {
             "enum": [ "set" ],
@@ -75,6 +105,29 @@ static const char* SCHEMA_SET=R"(
         "path": {
             "$ref": "viss#/definitions/path"
         },
+        "id": {
+            "$ref": "viss#/definitions/id"
+        },
+        "values": {
+            "description": "Sets all given paths at once. Each entry holds a path or id and the value of the requested attribute. If one value can not be set, none is set.",
+            "type": "array",
+            "minItems": 1,
+            "items": {
+                "type": "object",
+                "anyOf": [
+                    { "required": ["path"] },
+                    { "required": ["id"] }
+                ],
+                "properties": {
+                    "path": {
+                        "$ref": "viss#/definitions/path"
+                    },
+                    "id": {
+                        "$ref": "viss#/definitions/id"
+                    }
+                }
+            }
+        },
         "requestId": {
             "$ref": "viss#/definitions/requestId"
         }
@@ -89,7 +142,11 @@ static const char* SCHEMA_SUBSCRIBE=R"(
     "title": "Subscribe Request",
     "description": "Allows the client to subscribe to time-varying signal notifications on the server.",
     "type": "object",
-    "required": ["action", "path", "requestId"],
+    "required": ["action", "requestId"],
+    "anyOf": [
+        { "required": ["path"] },
+        { "required": ["id"] }
+    ],
     "properties": {
         "action": {
             "enum": [ "subscribe" ],
@@ -98,6 +155,9 @@ static const char* SCHEMA_SUBSCRIBE=R"(
         "path": {
             "$ref": "viss#/definitions/path"
         },
+        "id": {
+            "$ref": "viss#/definitions/id"
+        },
         "attribute": {
             "enum": [ "targetValue", "value" ],
             "description": "The attributes to be fetched for the get request"
@@ -134,6 +194,71 @@ static const char* SCHEMA_UNSUBSCRIBE=R"(
 }
 )";
 
+static const char* SCHEMA_GET_HISTORY=R"(
+{
+    "$schema": "http://json-schema.org/draft-04/schema#",
+    "title": "Get History Request",
+    "description": "Get the recorded values of one or more vehicle signals within a time range",
+    "type": "object",
+    "required": ["action", "path", "requestId"],
+    "properties": {
+        "action": {
+            "enum": [ "getHistory" ],
+            "description": "The identifier for the get history request"
+        },
+        "path": {
+            "$ref": "viss#/definitions/path"
+        },
+        "startTime": {
+            "description": "Start of the time range in milliseconds since epoch, inclusive",
+            "type": "integer",
+            "minimum": 0
+        },
+        "endTime": {
+            "description": "End of the time range in milliseconds since epoch, inclusive",
+            "type": "integer",
+            "minimum": 0
+        },
+        "requestId": {
+            "$ref": "viss#/definitions/requestId"
+        }
+    }
+}
+)";
+
+static const char* SCHEMA_RESOLVE=R"(
+{
+    "$schema": "http://json-schema.org/draft-04/schema#",
+    "title": "Resolve Request",
+    "description": "Get the numeric ids of vehicle signals, to use them instead of paths in further requests",
+    "type": "object",
+    "required": ["action", "requestId"],
+    "anyOf": [
+        { "required": ["path"] },
+        { "required": ["paths"] }
+    ],
+    "properties": {
+        "action": {
+            "enum": [ "resolve" ],
+            "description": "The identifier for the resolve request"
+        },
+        "path": {
+            "$ref": "viss#/definitions/path"
+        },
+        "paths": {
+            "type": "array",
+            "minItems": 1,
+            "items": {
+                "$ref": "viss#/definitions/path"
+            }
+        },
+        "requestId": {
+            "$ref": "viss#/definitions/requestId"
+        }
+    }
+}
+)";
+
 static const char* SCHEMA_UPDATE_VSS_TREE=R"(
 {
     "$schema": "http://json-schema.org/draft-04/schema#",
@@ -187,7 +312,7 @@ static const char* SCHEMA = (R"(
 {
     "definitions": {
         "action": {
-            "enum": [ "authorize", "getMetaData", "updateMetaData", "get", "set", "subscribe", "subscription", "unsubscribe", "unsubscribeAll"],
+            "enum": [ "authorize", "getMetaData", "updateMetaData", "get", "getHistory", "resolve", "set", "subscribe", "subscription", "unsubscribe", "unsubscribeAll"],
             "description": "The type of action requested by the client and/or delivered by the server"
         },
         "requestId": {
@@ -198,6 +323,12 @@ static const char* SCHEMA = (R"(
             "description": "The path to the desired vehicle signal(s), as defined by the metadata schema.",
             "type": "string"
         },
+        "id": {
+            "description": "Numeric id of a vehicle signal as returned by resolve. Can be used instead of its path.",
+            "type": "integer",
+            "minimum": 1,
+            "maximum": 262144
+        },
         "value": {
             "description": "The data value returned by the server. This could either be a basic type, or a complex type comprised of nested name/value pairs in JSON format.",
             "type": ["number", "string", "array"]
@@ -42,6 +42,8 @@ class VSSRequestValidator {
         ~VSSRequestValidator();
 
         void validateGet(jsoncons::json &request);
+        void validateGetHistory(jsoncons::json &request);
+        void validateResolve(jsoncons::json &request);
         void validateSet(jsoncons::json &request);
         void validateSubscribe(jsoncons::json &request);
         void validateUnsubscribe(jsoncons::json &request);
@@ -54,6 +56,8 @@ class VSSRequestValidator {
     private:
         class MessageValidator;
         std::unique_ptr<VSSRequestValidator::MessageValidator> getValidator;
+        std::unique_ptr<VSSRequestValidator::MessageValidator> getHistoryValidator;
+        std::unique_ptr<VSSRequestValidator::MessageValidator> resolveValidator;
         std::unique_ptr<VSSRequestValidator::MessageValidator> setValidator;
         std::unique_ptr<VSSRequestValidator::MessageValidator> subscribeValidator;
         std::unique_ptr<VSSRequestValidator::MessageValidator> unsubscribeValidator;
@@ -0,0 +1,79 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+/** Access decisions of a channel, keyed by the interned id of the path.
+ *
+ *  A fixed number of slots is indexed by the id, a slot holds the id and the
+ *  permissions granted for it. Colliding ids replace each other. Slots are
+ *  atomic, so copies of a channel used by other threads can share the cache.
+ *  A new cache is created whenever the permissions of a channel change.
+ */
+
+#ifndef __VSSACCESSCACHE_HPP__
+#define __VSSACCESSCACHE_HPP__
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+class VssAccessCache {
+  public:
+    static constexpr size_t SLOTS = 1024;
+
+    struct Stats {
+      uint64_t hits;
+      uint64_t misses;
+
+      /** e.g. "90 hits, 10 misses (90.0% hit rate)" */
+      std::string toString() const;
+    };
+
+    VssAccessCache() = default;
+    /** Adds the counts of this cache to totalStats */
+    ~VssAccessCache();
+    VssAccessCache(const VssAccessCache &) = delete;
+    VssAccessCache &operator=(const VssAccessCache &) = delete;
+
+    /** Sets permissions and returns true if the decision for id is cached.
+     *  Paths without id (0) are never cached */
+    bool lookup(uint32_t id, uint8_t &permissions);
+    void store(uint32_t id, uint8_t permissions);
+
+    Stats stats() const;
+    /** Sum over all caches of the process released so far. A check only
+     *  counts in its own cache, which adds its counts once when destroyed */
+    static Stats totalStats();
+
+  private:
+    // (id << 2) | permissions, 0 for an empty slot
+    std::array<std::atomic<uint32_t>, SLOTS> slots_{};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    static std::atomic<uint64_t> totalHits_;
+    static std::atomic<uint64_t> totalMisses_;
+};
+
+#endif
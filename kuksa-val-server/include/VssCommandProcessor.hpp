@@ -30,6 +30,7 @@
 #include "IVssCommandProcessor.hpp"
 #include "VSSRequestValidator.hpp"
 #include "KuksaChannel.hpp"
+#include "VSSPath.hpp"
 #include "IAccessChecker.hpp"
 
 class IVssDatabase;
@@ -49,12 +50,19 @@ class VssCommandProcessor : public IVssCommandProcessor {
 
   jsoncons::json processUpdateMetaData(KuksaChannel& channel, jsoncons::json& request);
   jsoncons::json processUpdateVSSTree(KuksaChannel& channel, jsoncons::json &request);
+  jsoncons::json processMultiGet(KuksaChannel &channel, jsoncons::json &request,
+                                 const std::string &requestId, const std::string &attribute);
+  /** Sets path to the path of a signal id returned by resolve. Returns false
+   *  for unknown ids */
+  static bool pathForId(const jsoncons::json &id, VSSPath &path);
 
  public:
   jsoncons::json processGetMetaData(jsoncons::json &request);
   jsoncons::json processAuthorize(KuksaChannel& channel, const std::string & request_id,
                           const std::string & token);
   jsoncons::json processGet(KuksaChannel &channel, jsoncons::json &request);
+  jsoncons::json processGetHistory(KuksaChannel &channel, jsoncons::json &request);
+  jsoncons::json processResolve(jsoncons::json &request);
   jsoncons::json processSet(KuksaChannel &channel, jsoncons::json &request);
   jsoncons::json processSubscribe(KuksaChannel& channel, jsoncons::json &request);
   jsoncons::json processUnsubscribe(KuksaChannel &channel, jsoncons::json &request);
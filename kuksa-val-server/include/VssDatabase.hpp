@@ -22,29 +22,147 @@
 #ifndef __VSSDATABASE_HPP__
 #define __VSSDATABASE_HPP__
 
+#include <atomic>
 #include <string>
 #include <list>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <jsoncons/json.hpp>
 
 #include "IVssDatabase.hpp"
 #include "VSSPath.hpp"
+#include "VssSignalDescriptor.hpp"
+#include "VssValueStore.hpp"
 
 class IAccessChecker;
 class ISubscriptionHandler;
 class ILogger;
+class VssValuePersistence;
+struct VssCompiledModel;
+
+/** Leafs affected by merging an overlay into the VSS tree, as VSS (Gen2) paths.
+ *  structureChanged is set if nodes have been added or node types changed */
+struct VssTreeChanges {
+  std::vector<std::string> added;
+  std::vector<std::string> changed;
+  bool structureChanged = false;
+};
 
 class VssDatabase : public IVssDatabase {
 #ifdef UNIT_TEST
   friend class w3cunittest;
+  friend class VssDatabaseTestAccess;
 #endif
 
  private:
+  /** Element type of a node in the VSS tree */
+  enum class NodeType { BRANCH, SENSOR, ACTUATOR, ATTRIBUTE, UNKNOWN };
+
+  /** Node of the VSS tree. element holds the metadata of the node, without
+   *  values and children. children are the names of the child nodes, sorted
+   *  like the keys of a json object. slot holds the values of a leaf and is
+   *  nullptr for branches, as is descriptor, the compiled type and limit
+   *  checks of a leaf. Nodes are immutable and shared by all snapshots, until
+   *  a modification of the tree replaces them */
+  struct VssNode {
+    jsoncons::json element;
+    NodeType type;
+    VSSPath path;
+    std::vector<std::string> children;
+    std::shared_ptr<VssSignalSlot> slot;
+    std::shared_ptr<const VssSignalDescriptor> descriptor;
+  };
+
+  /** Immutable version of the VSS tree, given by the index of all its nodes.
+   *  Readers take the current snapshot and keep using it, even if the tree is
+   *  replaced meanwhile. Modifications copy the index, replace the nodes they
+   *  change and swap the new snapshot in */
+  struct VssTreeSnapshot {
+    // path -> node, hashed by the interned path
+    std::unordered_map<VSSPath, std::shared_ptr<const VssNode>> pathIndex;
+    // names of the top level nodes, sorted
+    std::vector<std::string> roots;
+    uint64_t version = 0;
+    // branch/wildcard path -> its leafs. Filled on demand and dropped together
+    // with the tree version it has been computed for
+    mutable std::mutex leafCacheMutex;
+    mutable std::unordered_map<std::string, std::list<VSSPath>> leafCache;
+    // requested path -> built getMetaData result, same lifetime as leafCache
+    mutable std::mutex metaDataCacheMutex;
+    mutable std::unordered_map<std::string, std::shared_ptr<const jsoncons::json>> metaDataCache;
+  };
+
+  /** Paths of the nodes replaced while building a snapshot. Used to decide
+   *  which cached results of the previous snapshot still hold */
+  struct VssReplacedNodes {
+    // nodes added or with changed metadata
+    std::vector<std::string> elements;
+    // nodes where only the list of children changed
+    std::vector<std::string> children;
+  };
+
+  struct SnapshotCache;
+
+  /** Keeps a snapshot alive while a request works on it. Usually the snapshot
+   *  is pinned in the cache of the calling thread, which costs no write to
+   *  memory shared with other threads. Otherwise it owns a reference.
+   *
+   *  The cache of a thread keeps the snapshot after the request, as long as
+   *  it is the current one. If the tree changed meanwhile, it is dropped when
+   *  the last SnapshotRef of the thread goes away. A thread not reading when
+   *  the tree changes, e.g. an idle dispatch or io thread, still holds the
+   *  superseded snapshot until its next read. So at most one old snapshot per
+   *  such thread is retained. As unchanged nodes are shared with the current
+   *  tree, this costs the copy of the path index (one hash map entry per node)
+   *  and the cached results of the old version, not a complete tree */
+  class SnapshotRef {
+    public:
+      SnapshotRef(const VssTreeSnapshot *snapshot, SnapshotCache *pinned,
+                  std::shared_ptr<const VssTreeSnapshot> owned);
+      SnapshotRef(SnapshotRef &&other);
+      SnapshotRef(const SnapshotRef &) = delete;
+      SnapshotRef &operator=(const SnapshotRef &) = delete;
+      ~SnapshotRef();
+
+      const VssTreeSnapshot &operator*() const { return *snapshot_; }
+      const VssTreeSnapshot *operator->() const { return snapshot_; }
+
+    private:
+      const VssTreeSnapshot *snapshot_;
+      SnapshotCache *pinned_;
+      std::shared_ptr<const VssTreeSnapshot> owned_;
+  };
+
+  static constexpr size_t MAX_LEAF_CACHE_ENTRIES = 1024;
+  static constexpr size_t MAX_METADATA_CACHE_ENTRIES = 1024;
+  // optimistic reads of getSignals before it excludes all sets
+  static constexpr unsigned MAX_GET_SIGNALS_RETRIES = 8;
+
   std::shared_ptr<ILogger> logger_;
-  std::mutex rwMutex_;
   std::shared_ptr<ISubscriptionHandler> subHandler_;
+  // current snapshot, guarded by snapshotMutex_. Readers only take the mutex
+  // once per thread after the tree changed, see currentSnapshot
+  std::shared_ptr<const VssTreeSnapshot> snapshot_;
+  std::mutex snapshotMutex_;
+  // changes whenever snapshot_ is replaced. Unique over all database
+  // instances, so thread caches can not mix up snapshots of different ones
+  std::atomic<uint64_t> snapshotEpoch_;
+  // serializes modifications of the tree, readers never take it
+  std::mutex writeMutex_;
+  // held exclusively while a batched set stores its values, so that readers
+  // holding it shared never see a batch half applied. Single sets hold it
+  // shared while storing, so that getSignals can exclude them, if its
+  // optimistic reads keep failing. Single gets do not take it
+  std::shared_timed_mutex batchMutex_;
+  // values of all leafs, the tree itself only holds metadata. Guarded by writeMutex_,
+  // the slots themselves are shared with the snapshots
+  VssValueStore valueStore_;
+  // optional, set once before serving requests
+  std::shared_ptr<VssValuePersistence> persistence_;
 
  public:
   VssDatabase(std::shared_ptr<ILogger> loggerUtil,
@@ -61,10 +179,13 @@ class VssDatabase : public IVssDatabase {
 
   std::list<VSSPath> getLeafPaths(const VSSPath& path) override;
 
-  void checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val) override;
+  void checkAndSanitizeType(const jsoncons::json &meta, jsoncons::json &val) override;
 
 
   void initJsonTree(const boost::filesystem::path &fileName) override;
+  /** Initializes the database from a loaded compiled model. Builds the index
+   *  from its node table and compiles each of its descriptors once */
+  void initCompiledModel(VssCompiledModel model);
   
   bool checkPathValid(const VSSPath& path);
   static bool isActor(const jsoncons::json &element);
@@ -72,19 +193,72 @@ class VssDatabase : public IVssDatabase {
   static bool isAttribute(const jsoncons::json &element);
 
 
-  void updateJsonTree(jsoncons::json& sourceTree, const jsoncons::json& jsonTree);
   void updateJsonTree(KuksaChannel& channel, jsoncons::json& value) override;
   void updateMetaData(KuksaChannel& channel, const VSSPath& path, const jsoncons::json& newTree) override;
   jsoncons::json getMetaData(const VSSPath& path) override;
   
   jsoncons::json setSignal(const VSSPath &path, const std::string& attr, jsoncons::json &value) override; //gen2 version
+  jsoncons::json setSignals(VssSetPairs &pairs, const std::string& attr) override;
   jsoncons::json getSignal(const VSSPath &path, const std::string& attr, bool as_string=false) override; //Gen2 version
+  jsoncons::json getSignals(const VssGetPairs &pairs, bool as_string=false) override;
+  jsoncons::json getHistory(const VSSPath &path, uint64_t from_ns, uint64_t to_ns, bool as_string=false) override;
 
   void applyDefaultValues(jsoncons::json &tree, VSSPath currentPath);
 
+  /** Returns a copy of the current VSS tree. With withValues, the current
+   *  values and target values of the leafs are included, as needed to
+   *  compile the model */
+  jsoncons::json getTree(bool withValues = false);
+
+  /** Restores the values recorded by persistence and records all further
+   *  sets. Needs to be called after the tree is complete, i.e. after
+   *  overlays have been applied, and before serving requests */
+  void enablePersistence(std::shared_ptr<VssValuePersistence> persistence);
+
+  /** Records the last capacity values of all leafs matching pattern (branch
+   *  or wildcard paths are expanded). Histories belong to the value store and
+   *  survive tree updates. Returns the number of leafs recorded */
+  size_t enableHistory(const VSSPath &pattern, size_t capacity);
+
+  /** Estimated memory used by the VSS tree, value store and path index in bytes */
+  size_t getMemoryFootprint();
+  static size_t jsonMemoryFootprint(const jsoncons::json &tree);
+
   private:
 
-    void checkArrayType(std::string& subdatatype, jsoncons::json &val);
+
+    static NodeType nodeTypeOf(const jsoncons::json &element);
+    static bool hasWildcard(const VSSPath &path);
+
+    SnapshotRef currentSnapshot();
+    static uint64_t nextSnapshotEpoch();
+    void initTree(jsoncons::json tree);
+    void publishTree(jsoncons::json tree);
+    void publishSnapshot(std::shared_ptr<VssTreeSnapshot> snapshot, const VssTreeSnapshot &previous,
+                         const VssReplacedNodes &replaced, bool structureChanged);
+    VssTreeChanges applyOverlay(const jsoncons::json &overlay);
+    void mergeChildren(VssTreeSnapshot &snapshot, std::vector<std::string> &names, const jsoncons::json &overlay,
+                       const std::string &parentPath, VssTreeChanges &changes, VssReplacedNodes &replaced);
+    void indexNode(VssTreeSnapshot &snapshot, const std::string &path, jsoncons::json element,
+                   std::vector<std::string> *addedLeafs);
+    void replaceNode(VssTreeSnapshot &snapshot, const VssNode &current, jsoncons::json element,
+                     std::vector<std::string> children, bool elementChanged, VssTreeChanges &changes);
+    static void removeNode(VssTreeSnapshot &snapshot, const VSSPath &path);
+    void moveValueToSlot(jsoncons::json &element, const std::string &attr, VssSignalSlot &slot,
+                         const VssSignalDescriptor &descriptor);
+    static const VssNode* findNode(const VssTreeSnapshot &snapshot, const VSSPath &path);
+    static const VssNode* findChild(const VssTreeSnapshot &snapshot, const std::string &parentPath,
+                                    const std::string &name);
+    static std::vector<const VssNode*> matchNodes(const VssTreeSnapshot &snapshot, const VSSPath &path);
+    static jsoncons::json nodeToJson(const VssTreeSnapshot &snapshot, const VssNode &node, bool withValues = false);
+    static size_t indexMemoryFootprint(const VssTreeSnapshot &snapshot);
+    static jsoncons::json buildMetaData(const VssTreeSnapshot &snapshot, const VSSPath &path);
+    std::list<VSSPath> expandLeafPaths(const VssTreeSnapshot &snapshot, const VSSPath &path);
+    static void collectLeafPaths(const VssTreeSnapshot &snapshot, const VssNode &node, bool gen1,
+                                 std::list<VSSPath> &paths);
+    static jsoncons::json signalToJson(const VssNode &node, const VSSPath &path, const std::string &attr, bool as_string);
+    static jsoncons::json sampleToJson(const VSSPath &path, const std::string &attr, const VssSample &sample,
+                                       bool as_string);
 
 };
 #endif
@@ -48,7 +48,9 @@ public:
     boost::log::sources::logger_mt lg;
   
     jsoncons::json setSignal(const VSSPath &path, const std::string& attr, jsoncons::json &value) override; //gen2 version
+    jsoncons::json setSignals(VssSetPairs &pairs, const std::string& attr) override;
     jsoncons::json getSignal(const VSSPath &path, const std::string& attr, bool as_string=false) override; //Gen2 version
+    jsoncons::json getSignals(const VssGetPairs &pairs, bool as_string=false) override;
 
 private:
 
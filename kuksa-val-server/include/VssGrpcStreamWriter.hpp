@@ -0,0 +1,92 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Writes the notifications of one gRPC subscribe stream.
+ *
+ *  A write on a gRPC stream blocks until the client takes the message. The
+ *  notifications are therefore written by a thread of the stream, so a client
+ *  not reading its stream does not stall the dispatch thread it shares with
+ *  other subscribers. Like IServer::PendingWrites for websocket connections,
+ *  pendingWrites tells the subscription handler to hold back notifications
+ *  for a slow client, where its overflow policy applies to them.
+ */
+
+#ifndef __VSSGRPCSTREAMWRITER_HPP__
+#define __VSSGRPCSTREAMWRITER_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <grpcpp/grpcpp.h>
+
+#include "kuksa.grpc.pb.h"
+
+class ILogger;
+
+class VssGrpcStreamWriter {
+  public:
+    using Stream = grpc::ServerReaderWriterInterface<kuksa::SubscribeResponse, kuksa::SubscribeRequest>;
+
+    /** context is cancelled, if a write still blocks on close. May be
+     *  nullptr, if the stream does not belong to a call. It is not used
+     *  after close */
+    VssGrpcStreamWriter(std::shared_ptr<ILogger> logger, Stream *stream, grpc::ServerContext *context);
+    ~VssGrpcStreamWriter();
+
+    /** Queues resp to be written by the thread of the stream. Returns false,
+     *  if the stream is closed or the client is gone */
+    bool write(const kuksa::SubscribeResponse &resp);
+    /** Writes resp on the calling thread, in order with the queued writes */
+    bool writeNow(const kuksa::SubscribeResponse &resp);
+    /** Responses queued or being written */
+    size_t pendingWrites() const { return pending_; }
+
+    /** Cancels the call of the stream, which ends it for the client. The
+     *  subscribe call then closes the writer */
+    void cancel();
+    /** Drops the responses still queued and stops the thread. The stream is
+     *  not used anymore afterwards */
+    void close();
+
+  private:
+    std::shared_ptr<ILogger> logger_;
+    Stream *stream_;
+
+    std::mutex mutex_;
+    // guarded by mutex_
+    grpc::ServerContext *context_;
+    std::condition_variable wakeup_;
+    std::deque<kuksa::SubscribeResponse> queue_;
+    std::atomic<size_t> pending_{0};
+    bool closed_ = false;
+    // serializes the writes of the thread with writeNow
+    std::mutex streamMutex_;
+    std::thread thread_;
+
+    void writerLoop();
+};
+
+#endif
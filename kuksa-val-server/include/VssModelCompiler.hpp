@@ -0,0 +1,77 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ **********************************************************************/
+
+#ifndef __VSSMODELCOMPILER_HPP__
+#define __VSSMODELCOMPILER_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <jsoncons/json.hpp>
+
+/** Compiled binary VSS model. The file holds the final VSS tree, i.e. the
+ *  main VSS file with all overlays merged, default and overlay values
+ *  applied, as a flat node table in pre-order plus a table of interned
+ *  strings. The type definitions of the leafs are stored once per distinct
+ *  definition, so each descriptor is compiled only once. Loading it neither
+ *  parses JSON text nor applies defaults or overlays, and the path index is
+ *  built from the node table without assembling a JSON tree.
+ *
+ *  The header carries a hash over the VSS file and all overlays the model
+ *  has been compiled from, so a stale file can be detected and regenerated.
+ */
+
+/** Node of a loaded model */
+struct VssCompiledNode {
+  static constexpr uint32_t NO_DESCRIPTOR = std::numeric_limits<uint32_t>::max();
+
+  // VSS (Gen2) path
+  std::string path;
+  // metadata and values of the node, without children
+  jsoncons::json element;
+  // names of the child nodes, sorted like the keys of a json object
+  std::vector<std::string> children;
+  // index into VssCompiledModel::descriptors, NO_DESCRIPTOR for branches
+  uint32_t descriptor;
+};
+
+struct VssCompiledModel {
+  // names of the top level nodes, sorted
+  std::vector<std::string> roots;
+  // all nodes in pre-order
+  std::vector<VssCompiledNode> nodes;
+  // distinct type definitions of the leafs, see VssSignalDescriptor::definitionOf
+  std::vector<jsoncons::json> descriptors;
+};
+
+/** Hash over the content of the VSS file and the overlays (names and content) */
+uint64_t compiledModelHash(const boost::filesystem::path &vssFile,
+                           const std::vector<boost::filesystem::path> &overlayFiles);
+
+/** Writes tree as compiled model to file. The file is replaced atomically.
+ *  Throws std::runtime_error if it can not be written */
+void writeCompiledModel(const boost::filesystem::path &file, const jsoncons::json &tree, uint64_t hash);
+
+/** Maps file into memory and reads the model from it. Returns false if the
+ *  file does not exist, is corrupt or was compiled from other sources than
+ *  given by hash */
+bool loadCompiledModel(const boost::filesystem::path &file, uint64_t hash, VssCompiledModel &model);
+
+#endif
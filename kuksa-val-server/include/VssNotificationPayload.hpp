@@ -0,0 +1,66 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** The update of one signal, as sent to all of its subscribers.
+ *
+ *  It is serialized at most once per protocol, on first use, and then shared
+ *  by all notifications for the update. The websocket message only differs
+ *  in the subscriptionId between subscribers, it is kept as SharedMessage
+ *  the subscriptionId is spliced into. gRPC subscribers all get the same
+ *  SubscribeResponse.
+ */
+
+#ifndef __VSSNOTIFICATIONPAYLOAD_HPP__
+#define __VSSNOTIFICATIONPAYLOAD_HPP__
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+#include "IServer.hpp"
+
+namespace kuksa {
+class SubscribeResponse;
+}
+
+class VssNotificationPayload {
+  public:
+    /** data holds "path" and "dp" of the signal */
+    VssNotificationPayload(std::string vssdatatype, jsoncons::json data);
+    ~VssNotificationPayload();
+
+    std::shared_ptr<const SharedMessage> websocketMessage() const;
+    const kuksa::SubscribeResponse &grpcResponse() const;
+
+  private:
+    const std::string vssdatatype_;
+    const jsoncons::json data_;
+
+    mutable std::once_flag websocketEncoded_;
+    mutable std::shared_ptr<const SharedMessage> websocketMessage_;
+    mutable std::once_flag grpcEncoded_;
+    mutable std::unique_ptr<kuksa::SubscribeResponse> grpcResponse_;
+};
+
+#endif
@@ -0,0 +1,89 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Permissions of a channel, compiled once from the "kuksa-vss" claim of
+ *  its token, e.g. {"Vehicle.Speed": "r", "Vehicle.Cabin.*": "rw"}.
+ *
+ *  A path (GEN1) gets the permissions of the key equal to it. Otherwise all
+ *  keys are tried as patterns, where '*' matches any sequence of characters,
+ *  and the last matching key in key order wins. Keys are stored in a prefix
+ *  tree up to their first '*', so only patterns sharing a prefix with the
+ *  path need to be matched. Lookups do not allocate.
+ */
+
+#ifndef __VSSPERMISSIONMATCHER_HPP__
+#define __VSSPERMISSIONMATCHER_HPP__
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+#include <jsoncons/json.hpp>
+
+class VssPermissionMatcher {
+  public:
+    enum Permission : uint8_t { NONE = 0, READ = 1, WRITE = 2 };
+
+    /** Compiles permissions given as JSON object or as string holding one.
+     *  Anything else, e.g. a malformed string, grants no permissions */
+    static std::shared_ptr<const VssPermissionMatcher> compile(const jsoncons::json &permissions);
+
+    /** Permissions granted for path, a combination of Permission flags */
+    uint8_t permissionsFor(boost::string_view path) const;
+
+    bool canRead(boost::string_view path) const { return (permissionsFor(path) & READ) != 0; }
+    bool canWrite(boost::string_view path) const { return (permissionsFor(path) & WRITE) != 0; }
+
+  private:
+    static constexpr int32_t NO_ENTRY = -1;
+
+    struct Pattern {
+      // part of the key starting with its first '*'
+      std::string glob;
+      uint32_t order;
+      uint8_t permissions;
+    };
+
+    struct Node {
+      std::vector<std::pair<char, uint32_t>> children;
+      // permissions of the key ending here, NO_ENTRY if there is none
+      int32_t exact = NO_ENTRY;
+      // patterns whose part before the first '*' ends here
+      std::vector<uint32_t> patterns;
+    };
+
+    static uint8_t parsePermissions(const std::string &value);
+    static bool globMatch(boost::string_view glob, boost::string_view path);
+
+    uint32_t child(uint32_t node, char c) const;
+    uint32_t addChild(uint32_t node, char c);
+    void add(const std::string &key, uint8_t permissions, uint32_t order, bool exact);
+
+    // nodes_[0] is the root
+    std::vector<Node> nodes_{1};
+    std::vector<Pattern> patterns_;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Type and limit checks of a leaf, compiled once from its metadata. A set
+ *  is then validated without parsing the datatype name or reading min, max
+ *  and allowed values from the JSON metadata again.
+ */
+
+#ifndef __VSSSIGNALDESCRIPTOR_HPP__
+#define __VSSSIGNALDESCRIPTOR_HPP__
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+#include "VssValueStore.hpp"
+
+class VssSignalDescriptor {
+  public:
+    /** Compiles the metadata of a leaf. Does not throw, problems in the
+     *  metadata are reported when a value is validated, as before */
+    static std::shared_ptr<const VssSignalDescriptor> compile(const jsoncons::json &meta);
+    /** The part of the metadata of a leaf compile reads. Leafs with equal
+     *  definitions can share a descriptor */
+    static jsoncons::json definitionOf(const jsoncons::json &meta);
+
+    VssDatatype datatype() const { return datatype_; }
+    const std::string &datatypeName() const { return datatypeName_; }
+
+    /** Checks whether val is a valid value for the leaf and within its
+     *  limits. val is converted to the native type in place (see
+     *  IVssDatabase::checkAndSanitizeType), the native value is returned.
+     *  Throws outOfBoundException for invalid values and genException for
+     *  unsupported datatypes */
+    VssValue sanitize(jsoncons::json &val) const { return sanitizer_(*this, val); }
+
+  private:
+    using Sanitizer = VssValue (*)(const VssSignalDescriptor &, jsoncons::json &);
+
+    /** Allowed values of a string, from "allowed" (VSS 3.0) or "enum" */
+    struct AllowedValues {
+      std::unordered_set<std::string> values;
+      // the definition as given, for error messages
+      jsoncons::json definition;
+    };
+
+    template <typename T>
+    static VssValue sanitizeNumber(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+    template <typename T>
+    static VssValue sanitizeNumberArray(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+    template <typename T>
+    static void compileNumber(VssSignalDescriptor &descriptor, const jsoncons::json &meta, Sanitizer sanitizer);
+    static VssValue sanitizeBool(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+    static VssValue sanitizeString(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+    static VssValue sanitizeArray(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+    static VssValue sanitizeUnsupported(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+    static VssValue sanitizeInvalidLimit(const VssSignalDescriptor &descriptor, jsoncons::json &val);
+
+    std::string datatypeName_;
+    VssDatatype datatype_ = VssDatatype::UNKNOWN;
+    Sanitizer sanitizer_ = &sanitizeUnsupported;
+    // limits in the native type of the leaf (of the elements for arrays),
+    // only valid if has* is set
+    bool hasMin_ = false;
+    bool hasMax_ = false;
+    VssValue min_;
+    VssValue max_;
+    std::vector<AllowedValues> allowed_;
+    // checks of elements of boolean and string arrays
+    std::shared_ptr<const VssSignalDescriptor> element_;
+    // reason why min or max can not be converted to the native type
+    std::string limitError_;
+};
+
+#endif
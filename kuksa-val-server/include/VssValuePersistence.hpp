@@ -0,0 +1,123 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ **********************************************************************/
+
+#ifndef __VSSVALUEPERSISTENCE_HPP__
+#define __VSSVALUEPERSISTENCE_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "ILogger.hpp"
+#include "VssValueStore.hpp"
+
+/** When to flush the write-ahead log to disk */
+enum class VssSyncPolicy {
+  NONE,      //!< write every syncInterval, leave flushing to the OS
+  INTERVAL,  //!< write and fdatasync every syncInterval, sets are batched in between
+  ALWAYS     //!< write and fdatasync on every set
+};
+
+/** Maps "none", "interval" and "always" to VssSyncPolicy. Returns false for anything else */
+bool syncPolicyFromString(const std::string &name, VssSyncPolicy &policy);
+
+struct VssPersistenceConfig {
+  boost::filesystem::path directory;
+  VssSyncPolicy syncPolicy = VssSyncPolicy::INTERVAL;
+  std::chrono::milliseconds syncInterval{200};
+  /** Size of the write-ahead log, after which a snapshot is written */
+  size_t compactionThreshold = 8 * 1024 * 1024;
+};
+
+/** Keeps the last known values across restarts. Every set is appended to a
+ *  write-ahead log (values.<generation>.wal). When the log gets too large, it
+ *  is compacted: a new log generation is started and a snapshot of the
+ *  complete value store (values.snapshot) is written, making all older log
+ *  generations obsolete. At startup the snapshot and all newer logs are
+ *  replayed. Torn or corrupt records at the end of a log are skipped.
+ */
+class VssValuePersistence {
+  public:
+    using RecordFunc = std::function<void(const std::string &path, VssAttribute attr, const VssSample &sample)>;
+    /** Provides all current samples, e.g. by iterating the value store */
+    using SnapshotFunc = std::function<void(const RecordFunc &record)>;
+
+    VssValuePersistence(std::shared_ptr<ILogger> loggerUtil, VssPersistenceConfig config);
+    ~VssValuePersistence();
+
+    /** Reads snapshot and logs, calling apply for every record in the order
+     *  they have been written. Returns the number of records read */
+    size_t replay(const RecordFunc &apply);
+    /** Opens a new log generation and starts the background writer */
+    void start(SnapshotFunc snapshot);
+    /** Writes all pending records and stops the background writer */
+    void stop();
+
+    /** Records a set. Records are only buffered, so this may be called while
+     *  holding the lock ordering the stores to a signal. Thread safe */
+    void append(const std::string &path, VssAttribute attr, const VssSample &sample);
+    /** Waits until appended records are on disk if the sync policy is
+     *  ALWAYS, does nothing otherwise. Call after append without holding locks */
+    void commit();
+    /** Writes pending records, syncing them according to the policy */
+    void flush();
+    /** Writes a snapshot and removes obsolete logs */
+    void compact();
+
+    uint64_t recordsWritten() const { return records_; }
+    uint64_t bytesWritten() const { return bytes_; }
+    uint64_t syncs() const { return syncs_; }
+
+  private:
+    boost::filesystem::path walPath(uint64_t generation) const;
+    boost::filesystem::path snapshotPath() const;
+    void writeRecords(const std::string &data, bool sync);
+    void flushLocked(bool sync);
+    void openLog();
+    void writerLoop();
+
+    std::shared_ptr<ILogger> logger_;
+    VssPersistenceConfig config_;
+    SnapshotFunc snapshot_;
+
+    std::mutex mutex_;                // guards buffer_ and running_
+    std::condition_variable wakeup_;
+    std::string buffer_;
+    bool running_ = false;
+
+    std::mutex fileMutex_;            // guards fd_, generation_ and walBytes_
+    int fd_ = -1;
+    uint64_t generation_ = 0;
+    size_t walBytes_ = 0;
+
+    std::mutex compactMutex_;
+    std::thread writer_;
+
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> syncs_{0};
+};
+
+#endif
@@ -0,0 +1,342 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Native storage for signal values. The VSS tree only holds metadata, every
+ *  leaf gets a slot in the value store holding the last value and targetValue
+ *  in its native VSS datatype together with the timestamp of the update.
+ */
+
+#ifndef __VSSVALUESTORE_HPP__
+#define __VSSVALUESTORE_HPP__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+enum class VssDatatype : uint8_t {
+  UNKNOWN,
+  BOOLEAN,
+  UINT8,
+  INT8,
+  UINT16,
+  INT16,
+  UINT32,
+  INT32,
+  UINT64,
+  INT64,
+  FLOAT,
+  DOUBLE,
+  STRING,
+  BOOLEAN_ARRAY,
+  UINT8_ARRAY,
+  INT8_ARRAY,
+  UINT16_ARRAY,
+  INT16_ARRAY,
+  UINT32_ARRAY,
+  INT32_ARRAY,
+  UINT64_ARRAY,
+  INT64_ARRAY,
+  FLOAT_ARRAY,
+  DOUBLE_ARRAY,
+  STRING_ARRAY
+};
+
+/** Maps VSS datatype names such as "uint8" or "float[]" to VssDatatype */
+VssDatatype datatypeFromString(const std::string &datatype);
+
+bool isArrayDatatype(VssDatatype datatype);
+
+/** True for numeric and boolean datatypes, which fit into 8 bytes */
+bool isScalarDatatype(VssDatatype datatype);
+
+/** Returns the element type of an array datatype, i.e. UINT8 for UINT8_ARRAY */
+VssDatatype elementDatatype(VssDatatype arrayDatatype);
+
+/** Maps native C++ types to their VSS datatype */
+template <typename T> struct VssNativeType;
+template <> struct VssNativeType<bool>     { static constexpr VssDatatype datatype = VssDatatype::BOOLEAN; };
+template <> struct VssNativeType<uint8_t>  { static constexpr VssDatatype datatype = VssDatatype::UINT8; };
+template <> struct VssNativeType<int8_t>   { static constexpr VssDatatype datatype = VssDatatype::INT8; };
+template <> struct VssNativeType<uint16_t> { static constexpr VssDatatype datatype = VssDatatype::UINT16; };
+template <> struct VssNativeType<int16_t>  { static constexpr VssDatatype datatype = VssDatatype::INT16; };
+template <> struct VssNativeType<uint32_t> { static constexpr VssDatatype datatype = VssDatatype::UINT32; };
+template <> struct VssNativeType<int32_t>  { static constexpr VssDatatype datatype = VssDatatype::INT32; };
+template <> struct VssNativeType<uint64_t> { static constexpr VssDatatype datatype = VssDatatype::UINT64; };
+template <> struct VssNativeType<int64_t>  { static constexpr VssDatatype datatype = VssDatatype::INT64; };
+template <> struct VssNativeType<float>    { static constexpr VssDatatype datatype = VssDatatype::FLOAT; };
+template <> struct VssNativeType<double>   { static constexpr VssDatatype datatype = VssDatatype::DOUBLE; };
+
+/** Tagged union holding a single VSS value. Scalars are stored inline, strings
+ *  in string_, numeric and boolean arrays packed contiguously in packed_ and
+ *  string arrays in strings_. datatype() tells which representation is valid.
+ *  A default constructed value is "not set".
+ */
+class VssValue {
+  public:
+    VssValue() = default;
+
+    bool isSet() const { return datatype_ != VssDatatype::UNKNOWN; }
+    VssDatatype datatype() const { return datatype_; }
+
+    template <typename T>
+    static VssValue fromScalar(T value) {
+      VssValue v;
+      v.datatype_ = VssNativeType<T>::datatype;
+      memcpy(v.scalar_, &value, sizeof(T));
+      return v;
+    }
+
+    static VssValue fromString(std::string value) {
+      VssValue v;
+      v.datatype_ = VssDatatype::STRING;
+      v.string_ = std::move(value);
+      return v;
+    }
+
+    template <typename T>
+    static VssValue fromArray(const T *data, size_t count) {
+      VssValue v;
+      v.datatype_ = arrayOf(VssNativeType<T>::datatype);
+      v.count_ = count;
+      v.packed_.resize(count * sizeof(T));
+      if (count > 0) {
+        memcpy(v.packed_.data(), data, count * sizeof(T));
+      }
+      return v;
+    }
+
+    static VssValue fromStringArray(std::vector<std::string> values) {
+      VssValue v;
+      v.datatype_ = VssDatatype::STRING_ARRAY;
+      v.count_ = values.size();
+      v.strings_ = std::move(values);
+      return v;
+    }
+
+    template <typename T>
+    T get() const {
+      static_assert(std::is_arithmetic<T>::value, "only scalars are stored inline");
+      T value;
+      memcpy(&value, scalar_, sizeof(T));
+      return value;
+    }
+
+    /** Raw 8 bytes of a scalar value, used for compact storage */
+    uint64_t scalarBits() const {
+      uint64_t bits;
+      memcpy(&bits, scalar_, sizeof(bits));
+      return bits;
+    }
+
+    static VssValue fromScalarBits(VssDatatype datatype, uint64_t bits) {
+      VssValue v;
+      v.datatype_ = datatype;
+      memcpy(v.scalar_, &bits, sizeof(bits));
+      return v;
+    }
+
+    const std::string &getString() const { return string_; }
+
+    size_t arraySize() const { return count_; }
+
+    template <typename T>
+    const T *arrayData() const {
+      return reinterpret_cast<const T *>(packed_.data());
+    }
+
+    const std::vector<std::string> &getStringArray() const { return strings_; }
+
+    /** Heap memory used by the value in bytes */
+    size_t heapSize() const;
+
+    /** Converts an already sanitized JSON value (see
+     *  IVssDatabase::checkAndSanitizeType) to its native representation */
+    static VssValue fromJson(VssDatatype datatype, const jsoncons::json &value);
+    jsoncons::json toJson() const;
+
+    /** Appends a compact binary representation of the value to out */
+    void serialize(std::string &out) const;
+    /** Reads a value written by serialize starting at pos and advances pos.
+     *  Returns false if the data is truncated or invalid */
+    static bool deserialize(const char *&pos, const char *end, VssValue &value);
+
+  private:
+    static VssDatatype arrayOf(VssDatatype datatype);
+
+    VssDatatype datatype_ = VssDatatype::UNKNOWN;
+    alignas(8) unsigned char scalar_[8] = {0};
+    size_t count_ = 0;
+    std::string string_;
+    std::vector<unsigned char> packed_;
+    std::vector<std::string> strings_;
+};
+
+/** A value together with the time it has been set */
+struct VssSample {
+  VssValue value;
+  uint64_t ts_s = 0;
+  uint32_t ts_ns = 0;
+};
+
+/** Attributes of a signal, which can be set */
+enum class VssAttribute : uint8_t { VALUE = 0, TARGET_VALUE = 1 };
+
+/** Maps "value"/"targetValue" to VssAttribute. Returns false for anything else */
+bool attributeFromString(const std::string &attr, VssAttribute &attribute);
+
+/** Fixed capacity ring buffer holding the most recent samples of a signal.
+ *  Storage is allocated once. Timestamps (ns since epoch) and values are kept
+ *  in separate arrays, so range lookups only scan timestamps. Scalar values
+ *  are stored as raw 8 bytes, strings and arrays as VssValue reusing the
+ *  heap buffers of overwritten entries. Thread safe.
+ */
+class VssSignalHistory {
+  public:
+    VssSignalHistory(VssDatatype datatype, size_t capacity);
+
+    /** Appends sample, dropping the oldest one if the buffer is full. A sample
+     *  of a different datatype clears the history, as the signal changed. A
+     *  sample older than the newest one is recorded with the timestamp of the
+     *  newest one, so timestamps are always ascending */
+    void append(const VssSample &sample);
+    /** Returns all samples with from_ns <= timestamp <= to_ns, oldest first */
+    std::vector<VssSample> query(uint64_t from_ns, uint64_t to_ns) const;
+
+    size_t capacity() const { return timestamps_.size(); }
+    size_t size() const;
+    /** Estimated memory used by the ring buffer in bytes */
+    size_t memoryFootprint() const;
+
+  private:
+    void reset(VssDatatype datatype);
+    /** Physical index of the i-th oldest sample */
+    size_t slotIndex(size_t i) const { return (head_ + timestamps_.size() - count_ + i) % timestamps_.size(); }
+
+    mutable std::mutex mutex_;
+    VssDatatype datatype_;
+    std::vector<uint64_t> timestamps_;
+    std::vector<uint64_t> scalars_;   // scalar datatypes only
+    std::vector<VssValue> values_;    // strings and arrays only
+    size_t head_ = 0;                 // next index to write
+    size_t count_ = 0;
+};
+
+/** Value store entry of a single leaf in the VSS tree. Each attribute is
+ *  guarded by a sequence lock: scalar values and timestamps are stored inline
+ *  and readers copy them without writing to shared memory, retrying if a
+ *  store happened meanwhile. So readers never wait for each other and get a
+ *  consistent value/timestamp pair. Strings and arrays are kept behind a
+ *  pointer, which is copied under a spinlock held for the copy only.
+ *  Stores to a slot are serialized by a per-slot mutex readers never take.
+ */
+class VssSignalSlot {
+  public:
+    /** Called with the stored sample before the next store to the slot starts */
+    using CommitFunc = std::function<void(const VssSample &sample)>;
+
+    explicit VssSignalSlot(VssDatatype datatype) : datatype_(datatype) {}
+
+    VssDatatype datatype() const { return datatype_; }
+    void setDatatype(VssDatatype datatype) { datatype_ = datatype; }
+
+    /** Copies the current sample of attr to sample. Returns false, if the
+     *  attribute has not been set yet */
+    bool load(VssAttribute attr, VssSample &sample) const;
+    /** Number of stores to attr so far times two. Odd while a store is in
+     *  progress. Used to detect stores between two reads */
+    uint64_t sequence(VssAttribute attr) const {
+      return cells_[static_cast<size_t>(attr)].sequence.load(std::memory_order_acquire);
+    }
+    /** Stores sample for attr and appends values to the history. committed is
+     *  called afterwards, still before any other store to this slot, so that
+     *  followers like the persistence see the stores of a slot in order */
+    void store(VssAttribute attr, const VssSample &sample, const CommitFunc &committed = nullptr);
+
+    /** History of the value attribute, nullptr if it is not recorded */
+    std::shared_ptr<VssSignalHistory> history() const;
+    void setHistory(std::shared_ptr<VssSignalHistory> history);
+
+  private:
+    struct Cell {
+      std::atomic<uint64_t> sequence{0};
+      // UNKNOWN as long as the attribute has not been set
+      std::atomic<VssDatatype> datatype{VssDatatype::UNKNOWN};
+      std::atomic<uint64_t> scalarBits{0};
+      std::atomic<uint64_t> ts_s{0};
+      std::atomic<uint32_t> ts_ns{0};
+      // strings and arrays only, guarded by pointerLock_
+      std::shared_ptr<const VssValue> value;
+    };
+
+    /** Minimal spinlock for copying shared_ptrs, held for a few instructions */
+    class PointerGuard {
+      public:
+        explicit PointerGuard(std::atomic_flag &lock) : lock_(lock) {
+          while (lock_.test_and_set(std::memory_order_acquire)) {
+          }
+        }
+        ~PointerGuard() { lock_.clear(std::memory_order_release); }
+      private:
+        std::atomic_flag &lock_;
+    };
+
+    // atomic, as the datatype may be updated while the slot is in use
+    std::atomic<VssDatatype> datatype_;
+    Cell cells_[2];
+    // serializes stores, readers never take it
+    std::mutex storeMutex_;
+    mutable std::atomic_flag pointerLock_ = ATOMIC_FLAG_INIT;
+    // written holding storeMutex_ and pointerLock_, so holding either is enough to read it
+    std::shared_ptr<VssSignalHistory> history_;
+};
+
+/** Holds one slot per leaf, keyed by VSS (Gen2) path. Slots are shared with
+ *  the path index of VssDatabase and survive rebuilding the index, so values
+ *  are kept when the tree is modified. Not thread safe, callers need to
+ *  synchronize access.
+ */
+class VssValueStore {
+  public:
+    /** Returns the slot for path, creating it on first use */
+    std::shared_ptr<VssSignalSlot> getOrCreateSlot(const std::string &path, VssDatatype datatype);
+    std::shared_ptr<VssSignalSlot> findSlot(const std::string &path) const;
+    size_t size() const { return slots_.size(); }
+    void forEachSlot(const std::function<void(const std::string &, const VssSignalSlot &)> &func) const;
+    void clear() { slots_.clear(); }
+    /** Estimated memory used by all slots in bytes, including heap allocated
+     *  strings and arrays */
+    size_t memoryFootprint() const;
+
+  private:
+    std::unordered_map<std::string, std::shared_ptr<VssSignalSlot>> slots_;
+};
+
+#endif
@@ -95,6 +95,10 @@ class WebSockHttpFlexServer : public IServer {
     void AddListener(ObserverType type,   std::shared_ptr<IVssCommandProcessor> listener);
     void RemoveListener(ObserverType type, std::shared_ptr<IVssCommandProcessor> listener);
     bool SendToConnection(ConnectionId connID, const std::string &message);
+    bool SendSharedToConnection(ConnectionId connID, std::shared_ptr<const SharedMessage> message,
+                                const std::string &subscriptionId);
+    size_t PendingWrites(ConnectionId connID);
+    void CloseConnection(ConnectionId connID);
 };
 
 
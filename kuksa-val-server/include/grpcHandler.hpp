@@ -42,8 +42,9 @@
 
 class grpcHandler{
     public:
-      static void grpc_send_object_to_stream(std::shared_ptr<ILogger> logger, const std::string& vssdatatype, const jsoncons::json& data, grpc::ServerReaderWriter<kuksa::SubscribeResponse, kuksa::SubscribeRequest>* stream );
+      static void grpc_fill_subscribe_response(const std::string& vssdatatype, const jsoncons::json& signal, kuksa::SubscribeResponse* resp);
       static void grpc_fill_value(std::shared_ptr<ILogger> logger, const std::string& vssdatatype, const jsoncons::json& data, kuksa::Value* grpcvalue, const std::string& attr = "value");
+      static void grpc_fill_signal(const std::string& vssdatatype, const jsoncons::json& signal, kuksa::Value* grpcvalue, const std::string& attr = "value");
     private:
         std::shared_ptr<grpc::Server> grpcServer;
         std::shared_ptr<VssCommandProcessor> grpcProcessor;
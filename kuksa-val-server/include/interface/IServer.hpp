@@ -37,6 +37,13 @@ enum class ObserverType {
 
 using ConnectionId = uint64_t;
 
+/** A message sent to several connections, which only differ in the
+ *  subscriptionId between head and tail */
+struct SharedMessage {
+  std::string head;
+  std::string tail;
+};
+
 class IServer {
   public:
     virtual ~IServer() {}
@@ -44,5 +51,19 @@ class IServer {
     virtual void AddListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) = 0;
     virtual void RemoveListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) = 0;
     virtual bool SendToConnection(ConnectionId connID, const std::string &message) = 0;
+    /** Sends head, subscriptionId and tail of message as one message to
+     *  connID. Servers queueing messages keep a reference to message instead
+     *  of copying it */
+    virtual bool SendSharedToConnection(ConnectionId connID, std::shared_ptr<const SharedMessage> message,
+                                        const std::string &subscriptionId) {
+      return SendToConnection(connID, message->head + subscriptionId + message->tail);
+    }
+    /** Number of messages queued for connID, which were not yet written to
+     *  the client. Servers writing synchronously always return 0 */
+    virtual size_t PendingWrites(ConnectionId /*connID*/) { return 0; }
+    /** Closes connection connID, e.g. because its client does not keep up
+     *  with its notifications. Returns immediately, messages not yet
+     *  written are dropped */
+    virtual void CloseConnection(ConnectionId /*connID*/) {}
 };
 #endif
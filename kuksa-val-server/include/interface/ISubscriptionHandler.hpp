@@ -21,6 +21,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <jsoncons/json.hpp>
 #include <boost/uuid/uuid.hpp>
 #include "IPublisher.hpp"
@@ -36,22 +37,32 @@ class IPublisher;
 
 using SubscriptionId = boost::uuids::uuid;
 
+/** A value set on a single path, as published to subscribers */
+struct VssSignalUpdate {
+  VSSPath path;
+  std::string vssdatatype;
+  jsoncons::json data;
+};
+
 class ISubscriptionHandler {
   public:
     virtual ~ISubscriptionHandler() {}
 
     virtual SubscriptionId subscribe(KuksaChannel& channel,
                                      std::shared_ptr<IVssDatabase> db,
-                                     const std::string &path, const std::string& attr) = 0;
+                                     const VSSPath &path, const std::string& attr) = 0;
     virtual int unsubscribe(SubscriptionId subscribeID) = 0;
     virtual int unsubscribeAll(KuksaChannel channel) = 0;
+    /** Drops all subscriptions of channels whose token has expired */
+    virtual int unsubscribeExpired() = 0;
     virtual int publishForVSSPath(const VSSPath path, const std::string& vssdatatype, const std::string& attr, const jsoncons::json &value) = 0;
+    /** Publishes the updates of a batched set together */
+    virtual int publishForVSSPaths(const std::vector<VssSignalUpdate>& updates, const std::string& attr) = 0;
 
     virtual std::shared_ptr<IServer> getServer() = 0;
     virtual int startThread() = 0;
     virtual int stopThread() = 0;
     virtual bool isThreadRunning() const = 0;
-    virtual void* subThreadRunner() = 0;
     virtual void addPublisher(std::shared_ptr<IPublisher> publisher) = 0;
 };
 #endif
@@ -19,7 +19,10 @@
 #ifndef __IVSSDATABASE_HPP__
 #define __IVSSDATABASE_HPP__
 
+#include <stdint.h>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <jsoncons/json.hpp>
 #include <boost/filesystem.hpp>
@@ -27,6 +30,11 @@
 #include "KuksaChannel.hpp"
 #include "VSSPath.hpp"
 
+/** Path/value pairs of a batched set */
+using VssSetPairs = std::vector<std::tuple<VSSPath, jsoncons::json>>;
+/** Path/attribute pairs of a batched get */
+using VssGetPairs = std::vector<std::tuple<VSSPath, std::string>>;
+
 class IVssDatabase {
   public:
     virtual ~IVssDatabase() {}
@@ -37,7 +45,14 @@ class IVssDatabase {
     virtual jsoncons::json getMetaData(const VSSPath &path) = 0;
   
     virtual jsoncons::json setSignal(const VSSPath &path, const std::string& attr, jsoncons::json &value) = 0; //gen2 version
+    /** Sets attr of all pairs or, if any value is invalid, none of them */
+    virtual jsoncons::json setSignals(VssSetPairs &pairs, const std::string& attr) = 0;
     virtual jsoncons::json getSignal(const VSSPath& path, const std::string& attr, bool as_string=false) = 0;
+    /** Reads all pairs from one consistent state, a batched set is seen completely or not at all.
+     *  Returns an array in request order. Entries of typed (not as_string) results also carry the VSS datatype. */
+    virtual jsoncons::json getSignals(const VssGetPairs &pairs, bool as_string=false) = 0;
+    /** Returns the recorded values of a leaf between from_ns and to_ns (ns since epoch) */
+    virtual jsoncons::json getHistory(const VSSPath& path, uint64_t from_ns, uint64_t to_ns, bool as_string=false) = 0;
 
     virtual bool pathExists(const VSSPath &path) = 0;
     virtual bool pathIsWritable(const VSSPath &path) = 0;
@@ -48,11 +63,7 @@ class IVssDatabase {
 
     virtual std::list<VSSPath> getLeafPaths(const VSSPath& path) = 0;
 
-    virtual void checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val) = 0;
-                           
-    // TODO: temporary added while components are refactored
-    jsoncons::json data_tree__;
-    jsoncons::json meta_tree__;
+    virtual void checkAndSanitizeType(const jsoncons::json &meta, jsoncons::json &val) = 0;
 };
 
 #endif
@@ -24,7 +24,6 @@
 
 #include <jsoncons/json.hpp>
 #include <string>
-#include <regex>
 
 #include "IAuthenticator.hpp"
 #include "KuksaChannel.hpp"
@@ -36,39 +35,29 @@ AccessChecker::AccessChecker(std::shared_ptr<IAuthenticator> vdator) {
   tokenValidator = vdator;
 }
 
-bool AccessChecker::checkSignalAccess(const KuksaChannel& channel, const string& path, const string& requiredPermission){
-  json permissions;
-  if(!channel.getPermissions().empty()){
-    permissions = json::parse(channel.getPermissions().as_string());
+bool AccessChecker::checkSignalAccess(const KuksaChannel& channel, const VSSPath& path, uint8_t requiredPermission){
+  const VssPermissionMatcher *matcher = channel.getPermissionMatcher();
+  if (matcher == nullptr || channel.isTokenExpired()) {
+    return false;
   }
-  else{
-    permissions = json::parse("{}");
+  VssAccessCache *cache = channel.getAccessCache();
+  uint8_t permissions;
+  if (!cache->lookup(path.id(), permissions)) {
+    permissions = matcher->permissionsFor(path.getVSSGen1Path());
+    cache->store(path.id(), permissions);
   }
-  string permissionValue = permissions.get_with_default(path, "");
-  if (permissionValue.empty()){
-    for (auto permission : permissions.object_range()) {
-      string pathString(permission.key());
-      auto path_regex = std::regex{
-        std::regex_replace(pathString, std::regex("\\*"), std::string(".*"))};
-      std::smatch base_match;
-      if (std::regex_match(path, base_match, path_regex)) {
-        permissionValue = permission.value().as<string>();
-      }
-    }
-  
-  } 
-  return permissionValue.find(requiredPermission) != std::string::npos;
+  return (permissions & requiredPermission) != 0;
 }
 
 
 // check the permissions json in KuksaChannel if path has read access
 bool AccessChecker::checkReadAccess(KuksaChannel &channel, const VSSPath &path) {
-  return checkSignalAccess(channel, path.getVSSGen1Path(), "r");
+  return checkSignalAccess(channel, path, VssPermissionMatcher::READ);
 }
 
 // check the permissions json in KuksaChannel if path has read access
 bool AccessChecker::checkWriteAccess(KuksaChannel &channel, const VSSPath &path) {
-  return checkSignalAccess(channel, path.getVSSGen1Path(), "w");
+  return checkSignalAccess(channel, path, VssPermissionMatcher::WRITE);
 }
 
 
@@ -28,6 +28,7 @@
 #include <unistd.h>
 
 #include <jwt-cpp/jwt.h>
+#include <openssl/evp.h>
 #include <jsoncons/json.hpp>
 #include "VssDatabase.hpp"
 #include "KuksaChannel.hpp"
@@ -55,8 +56,25 @@ string Authenticator::getPublicKeyFromFile(string fileName, std::shared_ptr<ILog
 }
 
 
+namespace {
+// key of a token in the cache of verified tokens
+string tokenHash(const string &authToken) {
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int length = 0;
+  EVP_Digest(authToken.data(), authToken.size(), digest, &length, EVP_sha256(), nullptr);
+  return string(reinterpret_cast<const char *>(digest), length);
+}
+}
+
+constexpr size_t Authenticator::MAX_CACHED_TOKENS;
+
 void Authenticator::updatePubKey(string key) {
-  pubkey=key;
+  {
+    std::lock_guard<std::mutex> lock(tokenCacheMutex);
+    pubkey = key;
+    keyGeneration++;
+    tokenCache.clear();
+  }
   if (key == "") {
     logger->Log(LogLevel::WARNING, "Empty key in Authenticator::updatePubKey. Subsequent JWT token validations will fail.");
     return;
@@ -64,42 +82,88 @@ void Authenticator::updatePubKey(string key) {
   logger->Log(LogLevel::VERBOSE, "Updated JWT token validation public key.");
 }
 
-// utility method to validate token.
-int Authenticator::validateToken(KuksaChannel& channel, string authToken) {
-  json claims;
-  int ttl = -1;
+// Returns the claims of a valid token, nullptr if it is not valid. The
+// signature of a token is only verified the first time it is presented.
+std::shared_ptr<const Authenticator::VerifiedToken> Authenticator::verifiedToken(const string &authToken) {
+  string hash = tokenHash(authToken);
+  string key;
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(tokenCacheMutex);
+    auto cached = tokenCache.find(hash);
+    if (cached != tokenCache.end()) {
+      if (TokenExpiryScheduler::now() < cached->second->exp) {
+        return cached->second;
+      }
+      tokenCache.erase(cached);
+      logger->Log(LogLevel::ERROR, "Authenticator::validate: Token has expired. Token is not valid!");
+      return nullptr;
+    }
+    key = pubkey;
+    generation = keyGeneration;
+  }
 
+  auto decoded = jwt::decode(authToken);
+  auto verifier = jwt::verify().allow_algorithm(
+      jwt::algorithm::rs256(key, "", "", ""));
   try {
-    auto decoded = jwt::decode(authToken);
+    verifier.verify(decoded);
+  } catch (const std::runtime_error& e) {
+    logger->Log(LogLevel::ERROR, "Authenticator::validate: " + string(e.what())
+                + " Exception occurred while authentication. Token is not valid!");
+    return nullptr;
+  }
 
-    for (auto& e : decoded.get_payload_claims()) {
-      logger->Log(LogLevel::INFO, e.first + " = " + e.second.to_json().to_str());
-      claims[e.first] = e.second.to_json().to_str();
+  auto token = std::make_shared<VerifiedToken>();
+  for (auto& e : decoded.get_payload_claims()) {
+    logger->Log(LogLevel::VERBOSE, e.first + " = " + e.second.to_json().to_str());
+    stringstream value;
+    value << e.second.to_json();
+    token->claims[e.first] = json::parse(value.str());
+  }
+  if (!token->claims.contains("exp") || !token->claims["exp"].is_number()) {
+    logger->Log(LogLevel::ERROR, "Authenticator::validate: Token has no exp claim. Token is not valid!");
+    return nullptr;
+  }
+  token->exp = token->claims["exp"].as<int64_t>();
+
+  std::lock_guard<std::mutex> lock(tokenCacheMutex);
+  // do not cache tokens verified with a key replaced in the meantime
+  if (generation == keyGeneration) {
+    if (tokenCache.size() >= MAX_CACHED_TOKENS) {
+      int64_t now = TokenExpiryScheduler::now();
+      for (auto it = tokenCache.begin(); it != tokenCache.end();) {
+        it = it->second->exp <= now ? tokenCache.erase(it) : std::next(it);
+      }
+      if (tokenCache.size() >= MAX_CACHED_TOKENS) {
+        tokenCache.clear();
+      }
     }
+    tokenCache[hash] = token;
+  }
+  return token;
+}
 
-    auto verifier = jwt::verify().allow_algorithm(
-        jwt::algorithm::rs256(pubkey, "", "", ""));
-        
-    try {
-      verifier.verify(decoded);
-    } catch (const std::runtime_error& e) {
-      logger->Log(LogLevel::ERROR, "Authenticator::validate: " + string(e.what())
-                  + " Exception occurred while authentication. Token is not valid!");
+// utility method to validate token.
+int Authenticator::validateToken(KuksaChannel& channel, string authToken) {
+  try {
+    auto token = verifiedToken(authToken);
+    if (token == nullptr) {
       return -1;
     }
-
     channel.setAuthorized(true);
     channel.setAuthToken(authToken);
-    ttl = claims["exp"].as<int>();
+    return static_cast<int>(token->exp);
   }
   catch (std::exception &e) {
     logger->Log(LogLevel::ERROR, "Authenticator::validate: " + string(e.what())
                 + " Exception occurred while decoding token!");
   }
-  return ttl;
+  return -1;
 }
 
-Authenticator::Authenticator(std::shared_ptr<ILogger> loggerUtil, string secretkey, string algo) {
+Authenticator::Authenticator(std::shared_ptr<ILogger> loggerUtil, string secretkey, string algo)
+  : expiryScheduler(loggerUtil) {
   logger = loggerUtil;
   algorithm = algo;
   pubkey = secretkey;
@@ -112,47 +176,57 @@ int Authenticator::validate(KuksaChannel& channel,
   int ttl = validateToken(channel, authToken);
   if (ttl > 0) {
     resolvePermissions(channel);
+    expiryScheduler.schedule(channel, ttl);
   }
 
   return ttl;
 }
 
 // Checks if the token is still valid for the requests from the channel(client).
-// Internally check this before publishing messages for previously subscribed
-// signals.
+// Verified tokens are cached, so this only checks whether it has expired.
 bool Authenticator::isStillValid(KuksaChannel& channel) {
-  string token = channel.getAuthToken();
-  int ret = validateToken(channel, token);
+  bool valid = !channel.isTokenExpired();
+  if (valid) {
+    try {
+      valid = verifiedToken(channel.getAuthToken()) != nullptr;
+    } catch (std::exception &) {
+      valid = false;
+    }
+  }
 
-  if (ret == -1) {
+  if (!valid) {
     channel.setAuthorized(false);
-    return false;
-  } else {
-    return true;
   }
+  return valid;
+}
+
+void Authenticator::setTokenExpiryHandler(TokenExpiryScheduler::ExpiryHandler handler) {
+  expiryScheduler.setExpiryHandler(handler);
 }
 
 // **Do this only once for authenticate request**
 // resolves the permission in the JWT token and store the absolute path to the
 // signals in permissions JSON in WsChannel.
 void Authenticator::resolvePermissions(KuksaChannel& channel) {
-  string authToken = channel.getAuthToken();
-  auto decoded = jwt::decode(authToken);
-  json claims;
-  for (auto& e : decoded.get_payload_claims()) {
-    logger->Log(LogLevel::INFO, string(e.first) + " = " + e.second.to_json().to_str());
-    stringstream value;
-    value << e.second.to_json();
-    claims[e.first] = json::parse(value.str());
+  std::shared_ptr<const VerifiedToken> token;
+  try {
+    token = verifiedToken(channel.getAuthToken());
+  } catch (std::exception &e) {
+    logger->Log(LogLevel::ERROR, "Authenticator::resolvePermissions: " + string(e.what()));
   }
 
   json permissions;
+  if (token == nullptr) {
+    channel.setPermissions(permissions);
+    return;
+  }
+  const json &claims = token->claims;
   if (claims.contains("modifyTree") && claims["modifyTree"].as<bool>()) {
     channel.enableModifyTree();
   }
 
   if (claims.contains("kuksa-vss")) {
-    json tokenPermJson = claims["kuksa-vss"];
+    const json &tokenPermJson = claims["kuksa-vss"];
     for (auto permission : tokenPermJson.object_range()) {
       // TODO use regex to check
       if(permission.value() == "rw"
@@ -165,7 +239,6 @@ void Authenticator::resolvePermissions(KuksaChannel& channel) {
       }
     }
   }
-  std::string channelPermissions;
-  permissions.dump_pretty(channelPermissions);
-  channel.setPermissions(channelPermissions);
+  // compiles the permissions, so checking them later does not need to parse anything
+  channel.setPermissions(permissions);
 }
@@ -22,8 +22,35 @@
 #include "JsonResponses.hpp"
 
 #include <time.h>
+#include <atomic>
+#include <sstream>
 
 namespace JsonResponses {
+namespace {
+std::atomic<bool> prettyPrint{false};
+}
+
+void setPrettyPrint(bool pretty) { prettyPrint = pretty; }
+
+bool isPrettyPrint() { return prettyPrint; }
+
+void serialize(const jsoncons::json& json, std::string& out) {
+  if (prettyPrint) {
+    std::stringstream ss;
+    ss << pretty_print(json);
+    out += ss.str();
+  } else {
+    // encodes straight into out
+    json.dump(out);
+  }
+}
+
+std::string serialize(const jsoncons::json& json) {
+  std::string out;
+  serialize(json, out);
+  return out;
+}
+
 void malFormedRequest(std::string request_id, const std::string action,
                       std::string message, jsoncons::json& jsonResponse) {
   jsonResponse["action"] = action;
@@ -22,6 +22,9 @@
 #include "SubscriptionHandler.hpp"
 
 #include <unistd.h>  // usleep
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <string>
 
 #include <boost/uuid/uuid_generators.hpp>
@@ -32,23 +35,51 @@
 #include "AccessChecker.hpp"
 #include "Authenticator.hpp"
 #include "ILogger.hpp"
-#include "JsonResponses.hpp"
 #include "KuksaChannel.hpp"
 #include "VssDatabase.hpp"
 #include "exception.hpp"
 #include "visconf.hpp"
 
-#include "grpcHandler.hpp"
+#include "VssGrpcStreamWriter.hpp"
 
 using namespace std;
 using namespace jsoncons::jsonpath;
 using jsoncons::json;
 
+namespace {
+// clients with more unsent messages than this are considered slow, new
+// notifications for them stay queued in the subscription handler
+constexpr size_t MAX_PENDING_WRITES = 64;
+// how often notifications queued for slow clients are retried
+constexpr std::chrono::milliseconds RETRY_INTERVAL{10};
+}  // namespace
+
+bool overflowPolicyFromString(const std::string &name, VssOverflowPolicy &policy) {
+  if (name == "conflate") {
+    policy = VssOverflowPolicy::CONFLATE;
+  } else if (name == "drop-oldest") {
+    policy = VssOverflowPolicy::DROP_OLDEST;
+  } else if (name == "disconnect") {
+    policy = VssOverflowPolicy::DISCONNECT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::string SubscriptionHandler::DispatchStats::toString() const {
+  return std::to_string(dropped) + " dropped, " + std::to_string(conflated) +
+         " conflated, " + std::to_string(disconnected) + " subscribers disconnected";
+}
+
 SubscriptionHandler::SubscriptionHandler(
     std::shared_ptr<ILogger> loggerUtil, std::shared_ptr<IServer> wserver,
     std::shared_ptr<IAuthenticator> authenticate,
-    std::shared_ptr<IAccessChecker> checkAcc)
-    : publishers_() {
+    std::shared_ptr<IAccessChecker> checkAcc, unsigned dispatchThreadCount,
+    SubscriberQueueConfig subscriberQueueConfig)
+    : publishers_(), dispatchThreads(std::max(1u, dispatchThreadCount)),
+      queueConfig(subscriberQueueConfig), threadRun(false) {
+  queueConfig.capacity = std::max<size_t>(1, queueConfig.capacity);
   logger = loggerUtil;
   server = wserver;
   validator = authenticate;
@@ -60,29 +91,27 @@ SubscriptionHandler::~SubscriptionHandler() { stopThread(); }
 
 SubscriptionId SubscriptionHandler::subscribe(KuksaChannel& channel,
                                               std::shared_ptr<IVssDatabase> db,
-                                              const string& path,
+                                              const VSSPath& vssPath,
                                               const std::string& attr) {
   // generate subscribe ID "randomly".
   SubscriptionId subId = boost::uuids::random_generator()();
 
-  VSSPath vssPath = VSSPath::fromVSS(path);
-
   if (!db->pathExists(vssPath)) {
-    throw noPathFoundonTree(path);
+    throw noPathFoundonTree(vssPath.to_string());
   } else if (!db->pathIsReadable(vssPath)) {
     stringstream msg;
-    msg << path
+    msg << vssPath.to_string()
         << " is not a sensor, actor or attribute leaf. Subscribe not supported";
     logger->Log(LogLevel::INFO,
                 "SubscriptionHandler::subscribe : " + msg.str());
     throw noPathFoundonTree(msg.str());
   } else if (!checkAccess->checkReadAccess(channel, vssPath)) {
     stringstream msg;
-    msg << "no permission to subscribe to path " << path;
+    msg << "no permission to subscribe to path " << vssPath.to_string();
     throw noPermissionException(msg.str());
   }
 
-  subscription_keys_t subsKey = subscription_keys_t(vssPath.getVSSPath(), attr);
+  subscription_keys_t subsKey = subscription_keys_t(vssPath, attr);
   logger->Log(LogLevel::VERBOSE,
               string("SubscriptionHandler::subscribe: Subscribing to ") +
                   vssPath.getVSSPath());
@@ -105,7 +134,7 @@ int SubscriptionHandler::unsubscribe(SubscriptionId subscribeID) {
       logger->Log(
           LogLevel::VERBOSE,
           string("SubscriptionHandler::unsubscribe: Unsubscribing path ") +
-              sub.first.path);
+              sub.first.path.getVSSPath());
       subsforpath->erase(subid);
       found_subscription = true;
     }
@@ -134,13 +163,36 @@ int SubscriptionHandler::unsubscribeAll(KuksaChannel channel) {
       subs.second.erase(found);
       logger->Log(LogLevel::VERBOSE,
                   "SubscriptionHandler::unsubscribeAll: Unsubscribing " +
-                      subs.first.path + " for " +
+                      subs.first.path.getVSSPath() + " for " +
                       std::to_string(channel.getConnID()));
     }
   }
   return 0;
 }
 
+int SubscriptionHandler::unsubscribeExpired() {
+  size_t removed = 0;
+  std::unique_lock<std::mutex> lock(accessMutex);
+  for (auto& subs : subscriptions) {
+    for (auto it = subs.second.begin(); it != subs.second.end();) {
+      if (it->second.isTokenExpired()) {
+        it = subs.second.erase(it);
+        removed++;
+      } else {
+        ++it;
+      }
+    }
+  }
+  logger->Log(LogLevel::VERBOSE,
+              "SubscriptionHandler::unsubscribeExpired: Removed " +
+                  std::to_string(removed) + " subscriptions");
+  return 0;
+}
+
+SubscriptionHandler::DispatchStats SubscriptionHandler::getDispatchStats() const {
+  return DispatchStats{droppedCount, conflatedCount, disconnectedCount};
+}
+
 std::shared_ptr<IServer> SubscriptionHandler::getServer() { return server; }
 
 int SubscriptionHandler::publishForVSSPath(const VSSPath path,
@@ -157,94 +209,272 @@ int SubscriptionHandler::publishForVSSPath(const VSSPath path,
   logger->Log(LogLevel::VERBOSE, ss.str());
 
   std::unique_lock<std::mutex> lock(accessMutex);
-  subscription_keys_t subsKey = subscription_keys_t(path.getVSSPath(), attr);
+  subscription_keys_t subsKey = subscription_keys_t(path, attr);
   auto handle = subscriptions.find(subsKey);
   if (handle == subscriptions.end()) {
     // no subscriptions for path
     return 0;
   }
 
-  for (auto subID : handle->second) {
-    std::lock_guard<std::mutex> lock(subMutex);
-    tuple<SubscriptionId, KuksaChannel, std::string, json> newSub;
+  std::vector<Notification> notifications;
+  std::shared_ptr<const VssNotificationPayload> payload;
+  for (const auto& subID : handle->second) {
+    if (subID.second.isTokenExpired()) {
+      // dropped by unsubscribeExpired soon
+      continue;
+    }
     logger->Log(LogLevel::VERBOSE,
                 "SubscriptionHandler::publishForVSSPath: new " + attr +
                     " set at path " + boost::uuids::to_string(subID.first) +
                     ": " + ss.str());
-    newSub = std::make_tuple(subID.first, subID.second, vssdatatype, data);
-    buffer.push(newSub);
-    c.notify_one();
+    if (!payload) {
+      payload = std::make_shared<VssNotificationPayload>(vssdatatype, data);
+    }
+    notifications.emplace_back(subID.first, subID.second, payload);
   }
+  lock.unlock();
+
+  enqueue(notifications);
   return 0;
 }
 
-void* SubscriptionHandler::subThreadRunner() {
+int SubscriptionHandler::publishForVSSPaths(const std::vector<VssSignalUpdate>& updates,
+                                            const std::string& attr) {
+  // Publish MQTT
+  for (auto& publisher : publishers_) {
+    for (const auto& update : updates) {
+      publisher->sendPathValue(update.path.getVSSPath(), update.data["dp"][attr]);
+    }
+  }
   logger->Log(LogLevel::VERBOSE,
-              "SubscribeThread: Started Subscription Thread!");
-
-  while (isThreadRunning()) {
-    if (buffer.size() > 0) {
-      std::unique_lock<std::mutex> lock(subMutex);
-      auto newSub = buffer.front();
-      buffer.pop();
-
-      KuksaChannel channel = std::get<1>(newSub);
-      std::string vssdatatype = std::get<2>(newSub);
-      jsoncons::json data = std::get<3>(newSub);
-
-      jsoncons::json answer;
-      answer["action"] = "subscription";
-      answer["subscriptionId"] = boost::uuids::to_string(std::get<0>(newSub));
-
-      JsonResponses::convertJSONTimeStampToISO8601(data["dp"]);
-      answer.insert_or_assign("data", data);
-
-      stringstream ss;
-      ss << pretty_print(answer);
-      string message = ss.str();
-      if (channel.getType() == KuksaChannel::Type::GRPC) {
-        // check for subscriptionID in channel
-        auto handle = channel.grpcSubsMap->find(std::get<0>(newSub));
-        if (handle == channel.grpcSubsMap->end()) {
-          logger->Log(LogLevel::WARNING, "Subscription thread: No subscription for requested path in GRPC");
+              "SubscriptionHandler::publishForVSSPaths: set " + attr + " for " +
+                  std::to_string(updates.size()) + " paths");
+
+  std::vector<Notification> notifications;
+  {
+    std::unique_lock<std::mutex> lock(accessMutex);
+    for (const auto& update : updates) {
+      auto handle = subscriptions.find(subscription_keys_t(update.path, attr));
+      if (handle == subscriptions.end()) {
+        continue;
+      }
+      std::shared_ptr<const VssNotificationPayload> payload;
+      for (const auto& subID : handle->second) {
+        if (subID.second.isTokenExpired()) {
           continue;
         }
-        grpcHandler::grpc_send_object_to_stream(logger, vssdatatype, answer,
-                                                handle->second);
-      } else {  // WEBSOCKET
-        bool connectionexist =
-            getServer()->SendToConnection(channel.getConnID(), message);
-        if (!connectionexist) {
-          this->unsubscribeAll(channel);
+        if (!payload) {
+          payload = std::make_shared<VssNotificationPayload>(update.vssdatatype, update.data);
         }
+        notifications.emplace_back(subID.first, subID.second, payload);
       }
+    }
+  }
+  // queue the whole batch at once, so each dispatch thread is woken only once
+  enqueue(notifications);
+  return 0;
+}
+
+size_t SubscriptionHandler::shardIndex(const KuksaChannel& channel) const {
+  // connection ids are often addresses, mix them before taking the modulo
+  uint64_t id = channel.getConnID() * 0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>((id >> 32) % shards.size());
+}
 
+void SubscriptionHandler::enqueue(std::vector<Notification>& notifications) {
+  if (notifications.empty() || shards.empty()) {
+    return;
+  }
+  std::vector<std::vector<Notification>> perShard(shards.size());
+  for (auto& notification : notifications) {
+    perShard[shardIndex(std::get<1>(notification))].push_back(std::move(notification));
+  }
+  std::vector<KuksaChannel> disconnected;
+  for (size_t index = 0; index < shards.size(); index++) {
+    if (perShard[index].empty()) {
+      continue;
+    }
+    DispatchShard& shard = *shards[index];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto& notification : perShard[index]) {
+      const KuksaChannel& channel = std::get<1>(notification);
+      auto condition = [&channel](const KuksaChannel& other) { return other == channel; };
+      if (std::any_of(disconnected.begin(), disconnected.end(), condition)) {
+        continue;
+      }
+      auto& queue = shard.subscribers[channel.getConnID()];
+      if (!push(queue, notification)) {
+        disconnected.push_back(channel);
+        shard.subscribers.erase(channel.getConnID());
+      }
+    }
+    shard.signaled = true;
+    shard.wakeup.notify_one();
+  }
+
+  for (const auto& channel : disconnected) {
+    disconnectedCount++;
+    logger->Log(LogLevel::WARNING,
+                "SubscriptionHandler: Notifications for connection " +
+                    std::to_string(channel.getConnID()) +
+                    " exceed the queue size, closing it");
+    unsubscribeAll(channel);
+    // the client has to reconnect and subscribe again
+    if (channel.grpcWriter) {
+      channel.grpcWriter->cancel();
     } else {
-      std::unique_lock<std::mutex> lock(subMutex);
-      c.wait(lock);
+      getServer()->CloseConnection(channel.getConnID());
+    }
+  }
+}
+
+bool SubscriptionHandler::push(SubscriberQueue& queue, Notification& notification) {
+  const bool conflate = queueConfig.overflowPolicy == VssOverflowPolicy::CONFLATE;
+  const SubscriptionId& subscriptionId = std::get<0>(notification);
+  if (queue.pending.size() >= queueConfig.capacity) {
+    if (queueConfig.overflowPolicy == VssOverflowPolicy::DISCONNECT) {
+      return false;
+    }
+    auto newest = queue.newest.find(subscriptionId);
+    if (conflate && newest != queue.newest.end()) {
+      // the client only misses an intermediate value of this subscription
+      queue.pending[newest->second - queue.popped] = std::move(notification);
+      conflatedCount++;
+      return true;
+    }
+    popFront(queue);
+    droppedCount++;
+  }
+  if (conflate) {
+    queue.newest[subscriptionId] = queue.popped + queue.pending.size();
+  }
+  queue.pending.push_back(std::move(notification));
+  return true;
+}
+
+void SubscriptionHandler::popFront(SubscriberQueue& queue) {
+  auto newest = queue.newest.find(std::get<0>(queue.pending.front()));
+  if (newest != queue.newest.end() && newest->second == queue.popped) {
+    queue.newest.erase(newest);
+  }
+  queue.pending.pop_front();
+  queue.popped++;
+}
+
+void SubscriptionHandler::dispatch(Notification& notification) {
+  const SubscriptionId& subscriptionId = std::get<0>(notification);
+  KuksaChannel& channel = std::get<1>(notification);
+  const VssNotificationPayload& payload = *std::get<2>(notification);
+
+  if (channel.getType() == KuksaChannel::Type::GRPC) {
+    // check for subscriptionID in channel
+    auto handle = channel.grpcSubsMap->find(subscriptionId);
+    if (handle == channel.grpcSubsMap->end()) {
+      logger->Log(LogLevel::WARNING, "Subscription thread: No subscription for requested path in GRPC");
+      return;
+    }
+    // written by the thread of the stream, which a client not reading blocks
+    if (!channel.grpcWriter || !channel.grpcWriter->write(payload.grpcResponse())) {
+      this->unsubscribeAll(channel);
+    }
+  } else {  // WEBSOCKET
+    bool connectionexist = getServer()->SendSharedToConnection(
+        channel.getConnID(), payload.websocketMessage(),
+        boost::uuids::to_string(subscriptionId));
+    if (!connectionexist) {
+      this->unsubscribeAll(channel);
     }
   }
+}
 
+void SubscriptionHandler::dispatchRunner(DispatchShard& shard) {
   logger->Log(LogLevel::VERBOSE,
-              "SubscribeThread: Subscription handler thread stopped running");
+              "SubscribeThread: Started Subscription Thread!");
 
-  return NULL;
+  // true while notifications for slow clients are held back
+  bool holding = false;
+  std::unique_lock<std::mutex> lock(shard.mutex);
+  while (true) {
+    auto woken = [&] { return shard.signaled || !threadRun; };
+    if (holding) {
+      shard.wakeup.wait_for(lock, RETRY_INTERVAL, woken);
+    } else {
+      shard.wakeup.wait(lock, woken);
+    }
+    if (!threadRun) {
+      break;
+    }
+    shard.signaled = false;
+
+    // gRPC streams count their pending writes, the server those of websocket connections
+    std::vector<std::pair<ConnectionId, std::shared_ptr<VssGrpcStreamWriter>>> connections;
+    for (const auto& subscriber : shard.subscribers) {
+      const KuksaChannel& channel = std::get<1>(subscriber.second.pending.front());
+      connections.emplace_back(subscriber.first, channel.grpcWriter);
+    }
+    lock.unlock();
+    // while a client does not keep up, its notifications are kept here,
+    // where the overflow policy applies to them
+    std::vector<ConnectionId> writable;
+    for (const auto& connection : connections) {
+      size_t pendingWrites = connection.second ? connection.second->pendingWrites()
+                                               : getServer()->PendingWrites(connection.first);
+      if (pendingWrites < MAX_PENDING_WRITES) {
+        writable.push_back(connection.first);
+      }
+    }
+    lock.lock();
+
+    // send everything queued so far without holding the lock
+    std::vector<std::deque<Notification>> pending;
+    for (auto connID : writable) {
+      auto subscriber = shard.subscribers.find(connID);
+      if (subscriber != shard.subscribers.end()) {
+        pending.push_back(std::move(subscriber->second.pending));
+        shard.subscribers.erase(subscriber);
+      }
+    }
+    holding = !shard.subscribers.empty();
+    lock.unlock();
+    for (auto& notifications : pending) {
+      for (auto& notification : notifications) {
+        dispatch(notification);
+      }
+    }
+    lock.lock();
+  }
+
+  logger->Log(LogLevel::VERBOSE,
+              "SubscribeThread: Subscription handler thread stopped running");
 }
 
 int SubscriptionHandler::startThread() {
-  subThread = thread(&SubscriptionHandler::subThreadRunner, this);
+  if (threadRun) {
+    return 0;
+  }
   threadRun = true;
+  shards.clear();
+  for (unsigned i = 0; i < dispatchThreads; i++) {
+    shards.push_back(std::make_unique<DispatchShard>());
+  }
+  for (auto& shard : shards) {
+    shard->thread = thread(&SubscriptionHandler::dispatchRunner, this, std::ref(*shard));
+  }
   return 0;
 }
 
 int SubscriptionHandler::stopThread() {
   if (isThreadRunning()) {
-    {
-      std::lock_guard<std::mutex> lock(subMutex);
-      threadRun = false;
-      c.notify_one();
+    threadRun = false;
+    for (auto& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->wakeup.notify_one();
+    }
+    for (auto& shard : shards) {
+      shard->thread.join();
     }
-    subThread.join();
+    logger->Log(LogLevel::VERBOSE, "SubscriptionHandler: Notifications " +
+                                       getDispatchStats().toString());
   }
   return 0;
 }
@@ -0,0 +1,136 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "TokenExpiryScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "ILogger.hpp"
+
+constexpr int64_t TokenExpiryScheduler::SLOTS;
+
+TokenExpiryScheduler::TokenExpiryScheduler(std::shared_ptr<ILogger> logger)
+  : logger_(logger), wheel_(SLOTS), lastTick_(now()) {
+}
+
+TokenExpiryScheduler::~TokenExpiryScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    running_ = false;
+    wakeup_.notify_one();
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+int64_t TokenExpiryScheduler::now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void TokenExpiryScheduler::setExpiryHandler(ExpiryHandler handler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  handler_ = handler;
+}
+
+void TokenExpiryScheduler::schedule(const KuksaChannel &channel, int64_t exp) {
+  auto tokenExpired = channel.getTokenExpiry();
+  if (tokenExpired.expired()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // an exp already passed is handled with the next tick
+    int64_t tick = std::max(exp, lastTick_ + 1);
+    wheel_[tick % SLOTS].push_back(Entry{exp, tokenExpired});
+    size_++;
+  }
+
+  std::lock_guard<std::mutex> lock(threadMutex_);
+  if (!running_ && !thread_.joinable()) {
+    running_ = true;
+    thread_ = std::thread(&TokenExpiryScheduler::run, this);
+  }
+}
+
+size_t TokenExpiryScheduler::advance(int64_t now) {
+  std::vector<std::shared_ptr<std::atomic<bool>>> due;
+  ExpiryHandler handler;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (now <= lastTick_) {
+      return 0;
+    }
+    // after a pause longer than a round every slot is visited once
+    for (int64_t tick = std::max(lastTick_ + 1, now - SLOTS + 1); tick <= now; tick++) {
+      auto &slot = wheel_[tick % SLOTS];
+      auto end = std::remove_if(slot.begin(), slot.end(), [&](const Entry &entry) {
+        auto tokenExpired = entry.tokenExpired.lock();
+        if (!tokenExpired) {
+          // channel is gone
+          return true;
+        }
+        if (entry.exp <= now) {
+          due.push_back(tokenExpired);
+          return true;
+        }
+        return false;
+      });
+      size_ -= std::distance(end, slot.end());
+      slot.erase(end, slot.end());
+    }
+    lastTick_ = now;
+    handler = handler_;
+  }
+
+  if (due.empty()) {
+    return 0;
+  }
+  for (auto &tokenExpired : due) {
+    tokenExpired->store(true);
+  }
+  logger_->Log(LogLevel::INFO, "TokenExpiryScheduler: " + std::to_string(due.size()) + " token(s) expired");
+  if (handler) {
+    handler();
+  }
+  return due.size();
+}
+
+size_t TokenExpiryScheduler::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+void TokenExpiryScheduler::run() {
+  std::unique_lock<std::mutex> lock(threadMutex_);
+  while (running_) {
+    wakeup_.wait_for(lock, std::chrono::seconds(1));
+    if (!running_) {
+      break;
+    }
+    lock.unlock();
+    advance(now());
+    lock.lock();
+  }
+}
@@ -23,76 +23,191 @@
 #include "VSSPath.hpp"
 
 #include <algorithm>
-#include <regex>
-#include <sstream>
+#include <deque>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
 
-VSSPath::VSSPath(std::string vss, std::string vssgen1, std::string jsonpath, bool gen1origin)
-    : vsspath(vss), vssgen1path(vssgen1), jsonpath(jsonpath), gen1_(gen1origin) {}
+namespace {
 
-std::string VSSPath::getVSSPath() const { return this->vsspath; }
+// FNV-1a, computed once per interned path
+std::size_t hashPath(boost::string_view path) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : path) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<std::size_t>(hash);
+}
+
+struct PathViewHasher {
+  std::size_t operator()(boost::string_view path) const { return hashPath(path); }
+};
+
+/** Process wide table of GEN2 paths of the VSS model. Entries are never
+ *  removed, so handles and the views used as keys stay valid. Paths sent by
+ *  clients are only looked up, the bound guards against huge models */
+class PathTable {
+  public:
+    const VSSPath::Entry *find(boost::string_view vss) const {
+      std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+      auto it = index_.find(vss);
+      return it == index_.end() ? nullptr : it->second;
+    }
+
+    /** Returns nullptr if the table is full */
+    const VSSPath::Entry *insert(boost::string_view vss) {
+      std::lock_guard<std::shared_timed_mutex> lock(mutex_);
+      auto it = index_.find(vss);
+      if (it != index_.end()) {
+        return it->second;
+      }
+      if (entries_.size() >= VSSPath::MAX_INTERNED_PATHS) {
+        return nullptr;
+      }
+      entries_.emplace_back();
+      VSSPath::Entry &entry = entries_.back();
+      entry.vsspath = vss.to_string();
+      entry.hash = hashPath(vss);
+      entry.id = static_cast<uint32_t>(entries_.size());
+      index_.emplace(boost::string_view(entry.vsspath), &entry);
+      return &entry;
+    }
+
+    /** Returns nullptr for unknown ids */
+    const VSSPath::Entry *get(uint32_t id) const {
+      std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+      if (id == 0 || id > entries_.size()) {
+        return nullptr;
+      }
+      return &entries_[id - 1];
+    }
 
-std::string VSSPath::getVSSGen1Path() const  { return this->vssgen1path; }
+    size_t size() const {
+      std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+      return entries_.size();
+    }
+
+  private:
+    mutable std::shared_timed_mutex mutex_;
+    // deque does not move its elements when growing
+    std::deque<VSSPath::Entry> entries_;
+    std::unordered_map<boost::string_view, const VSSPath::Entry *, PathViewHasher> index_;
+};
+
+PathTable &pathTable() {
+  static PathTable table;
+  return table;
+}
 
-std::string VSSPath::getJSONPath() const { return this->jsonpath; }
+}  // namespace
+
+constexpr size_t VSSPath::MAX_INTERNED_PATHS;
+constexpr size_t VSSPath::MAX_INLINE_PATH;
+
+VSSPath::VSSPath(const Entry *entry, std::shared_ptr<const Entry> owned, bool gen1origin)
+    : entry_(entry), owned_(std::move(owned)), gen1_(gen1origin) {}
+
+const std::string &VSSPath::getVSSGen1Path() const {
+  std::call_once(entry_->gen1Once, [this]() { entry_->vssgen1path = gen2togen1(entry_->vsspath); });
+  return entry_->vssgen1path;
+}
 
-bool VSSPath::isGen1Origin() const { return this->gen1_;}
+const std::string &VSSPath::getJSONPath() const {
+  std::call_once(entry_->jsonOnce, [this]() { entry_->jsonpath = gen2tojson(entry_->vsspath); });
+  return entry_->jsonpath;
+}
 
 std::string VSSPath::to_string() const {return isGen1Origin()? getVSSGen1Path() : getVSSPath();}
 
-VSSPath VSSPath::fromVSS(std::string input) {
-  bool gen1=false;
-  std::string vss, vssgen1, jsonpath;
-  if (input.find(".") == std::string::npos) {  // If no "." in we assume a GEN2 "/" seperated path
-    vss = input;
-    vssgen1 = VSSPath::gen2togen1(vss);
-  } else {
-    vssgen1 = input;
-    gen1=true;
-    vss = VSSPath::gen1togen2(vssgen1);
+size_t VSSPath::internedCount() { return pathTable().size(); }
+
+/** Returns the interned handle for GEN2 path vss, or an owned one if the
+ *  path is not in the table */
+VSSPath VSSPath::lookup(boost::string_view vss, bool gen1origin) {
+  const Entry *entry = pathTable().find(vss);
+  if (entry != nullptr) {
+    return VSSPath(entry, nullptr, gen1origin);
+  }
+  return owned(vss, gen1origin);
+}
+
+VSSPath VSSPath::owned(boost::string_view vss, bool gen1origin) {
+  auto owned = std::make_shared<Entry>();
+  owned->vsspath = vss.to_string();
+  owned->hash = hashPath(vss);
+  owned->id = 0;
+  return VSSPath(owned.get(), owned, gen1origin);
+}
+
+VSSPath VSSPath::internVSSGen2(boost::string_view vss) {
+  const Entry *entry = pathTable().find(vss);
+  if (entry == nullptr) {
+    entry = pathTable().insert(vss);
+  }
+  if (entry != nullptr) {
+    return VSSPath(entry, nullptr, false);
+  }
+  return owned(vss, false);
+}
+
+VSSPath VSSPath::fromId(uint32_t id) {
+  const Entry *entry = pathTable().get(id);
+  if (entry == nullptr) {
+    throw std::out_of_range("No path with id " + std::to_string(id));
   }
+  return VSSPath(entry, nullptr, false);
+}
 
-  jsonpath = VSSPath::gen2tojson(vss);
-  return VSSPath(vss, vssgen1, jsonpath,gen1);
+VSSPath VSSPath::fromVSS(boost::string_view input) {
+  if (input.find('.') == boost::string_view::npos) {  // If no "." in we assume a GEN2 "/" seperated path
+    return lookup(input, false);
+  }
+  return fromVSSGen1(input);
 }
 
-std::string VSSPath::gen1togen2(std::string input) {
-  std::string gen2 = input;
+std::string VSSPath::gen1togen2(boost::string_view input) {
+  std::string gen2 = input.to_string();
   std::replace(gen2.begin(), gen2.end(), '.', '/');
   return gen2;
 }
 
-std::string VSSPath::gen2togen1(std::string input) {
-  std::string gen1 = input;
+std::string VSSPath::gen2togen1(boost::string_view input) {
+  std::string gen1 = input.to_string();
   std::replace(gen1.begin(), gen1.end(), '/', '.');
   return gen1;
 }
 
-std::string VSSPath::gen2tojson(std::string input) {
-  std::vector<std::string> elements;
-  boost::split(elements, input, boost::is_any_of("/"));
-
-  std::stringstream jsonpath;
-  jsonpath << "$";
-  bool first = true;
-  for (auto element : elements) {
-    if (!first) {
-      jsonpath << "[\'children\']";
+std::string VSSPath::gen2tojson(boost::string_view input) {
+  std::string jsonpath = "$";
+  jsonpath.reserve(input.size() + 16 * (std::count(input.begin(), input.end(), '/') + 1));
+  size_t start = 0;
+  while (true) {
+    size_t end = input.find('/', start);
+    boost::string_view element = input.substr(start, end == boost::string_view::npos ? boost::string_view::npos : end - start);
+    if (start != 0) {
+      jsonpath += "[\'children\']";
     }
     if (element == "*") {
-      jsonpath << "[*]";
+      jsonpath += "[*]";
     } else {
-      jsonpath << "[\'" << element << "\']";
+      jsonpath += "[\'";
+      jsonpath.append(element.data(), element.size());
+      jsonpath += "\']";
     }
-    first = false;
+    if (end == boost::string_view::npos) {
+      break;
+    }
+    start = end + 1;
   }
-  return jsonpath.str();
+  return jsonpath;
 }
 
-std::string VSSPath::jsontogen2(std::string input) {
-    std::string gen2=input;
+std::string VSSPath::jsontogen2(boost::string_view input) {
+    std::string gen2=input.to_string();
     boost::erase_all(gen2,"['children']");
     boost::erase_all(gen2,"'");
 
@@ -102,16 +217,20 @@ std::string VSSPath::jsontogen2(std::string input) {
     return gen2;
 }
 
-VSSPath VSSPath::fromVSSGen2(std::string input) {
-  return VSSPath(input, gen2togen1(input), gen2tojson(input),false);
+VSSPath VSSPath::fromVSSGen2(boost::string_view input) {
+  return lookup(input, false);
 }
 
-VSSPath VSSPath::fromVSSGen1(std::string input) {
-  std::string vss = gen1togen2(input);
-  return VSSPath(vss, input, gen2tojson(vss),true);
+VSSPath VSSPath::fromVSSGen1(boost::string_view input) {
+  // convert short paths on the stack, so known paths are found without allocation
+  if (input.size() <= MAX_INLINE_PATH) {
+    char gen2[MAX_INLINE_PATH];
+    std::replace_copy(input.begin(), input.end(), gen2, '.', '/');
+    return lookup(boost::string_view(gen2, input.size()), true);
+  }
+  return lookup(gen1togen2(input), true);
 }
 
-VSSPath VSSPath::fromJSON(std::string input, bool gen1) {
-  std::string vss = VSSPath::jsontogen2(input);
-  return VSSPath(vss, VSSPath::gen2togen1(vss), input, gen1);
+VSSPath VSSPath::fromJSON(boost::string_view input, bool gen1) {
+  return lookup(VSSPath::jsontogen2(input), gen1);
 }
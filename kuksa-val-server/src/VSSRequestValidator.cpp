@@ -72,6 +72,8 @@ VSSRequestValidator::VSSRequestValidator(std::shared_ptr<ILogger> loggerUtil) :
   logger(loggerUtil) {
   
   this->getValidator            = std::make_unique<MessageValidator>( VSS_JSON::SCHEMA_GET);
+  this->getHistoryValidator     = std::make_unique<MessageValidator>( VSS_JSON::SCHEMA_GET_HISTORY);
+  this->resolveValidator        = std::make_unique<MessageValidator>( VSS_JSON::SCHEMA_RESOLVE);
   this->setValidator            = std::make_unique<MessageValidator>( VSS_JSON::SCHEMA_SET);
   this->subscribeValidator      = std::make_unique<MessageValidator>( VSS_JSON::SCHEMA_SUBSCRIBE);
   this->unsubscribeValidator    = std::make_unique<MessageValidator>( VSS_JSON::SCHEMA_UNSUBSCRIBE);
@@ -87,6 +89,14 @@ void VSSRequestValidator::validateGet(jsoncons::json& request) {
   getValidator->validate(request);
 }
 
+void VSSRequestValidator::validateGetHistory(jsoncons::json& request) {
+  getHistoryValidator->validate(request);
+}
+
+void VSSRequestValidator::validateResolve(jsoncons::json& request) {
+  resolveValidator->validate(request);
+}
+
 void VSSRequestValidator::validateSet(jsoncons::json& request) {
   setValidator->validate(request);
 }
@@ -21,14 +21,103 @@
 
 
 
+#include "VssSignalDescriptor.hpp"
 #include "VssDatabase.hpp"
 #include "ILogger.hpp"
 #include "exception.hpp"
+#include <limits>
 #include <string>
 #include <boost/algorithm/string.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 
 
+template <typename T>
+void VssSignalDescriptor::compileNumber(VssSignalDescriptor &descriptor, const jsoncons::json &meta, Sanitizer sanitizer) {
+    descriptor.sanitizer_ = sanitizer;
+    try {
+        if (meta.contains("min")) {
+            descriptor.min_ = VssValue::fromScalar<T>(meta["min"].as<T>());
+            descriptor.hasMin_ = true;
+        }
+        if (meta.contains("max")) {
+            descriptor.max_ = VssValue::fromScalar<T>(meta["max"].as<T>());
+            descriptor.hasMax_ = true;
+        }
+    }
+    catch(std::exception const& e) {
+        descriptor.limitError_ = "Limits of " + descriptor.datatypeName_ + " leaf are invalid. Reason: " + e.what();
+        descriptor.sanitizer_ = &sanitizeInvalidLimit;
+    }
+}
+
+std::shared_ptr<const VssSignalDescriptor> VssSignalDescriptor::compile(const jsoncons::json &meta) {
+    auto descriptor = std::make_shared<VssSignalDescriptor>();
+    if (meta.contains("datatype") && meta["datatype"].is_string()) {
+        descriptor->datatypeName_ = meta["datatype"].as<std::string>();
+    }
+    descriptor->datatype_ = datatypeFromString(descriptor->datatypeName_);
+
+    switch (descriptor->datatype_) {
+        case VssDatatype::UINT8:  compileNumber<uint8_t>(*descriptor, meta, &sanitizeNumber<uint8_t>); break;
+        case VssDatatype::INT8:   compileNumber<int8_t>(*descriptor, meta, &sanitizeNumber<int8_t>); break;
+        case VssDatatype::UINT16: compileNumber<uint16_t>(*descriptor, meta, &sanitizeNumber<uint16_t>); break;
+        case VssDatatype::INT16:  compileNumber<int16_t>(*descriptor, meta, &sanitizeNumber<int16_t>); break;
+        case VssDatatype::UINT32: compileNumber<uint32_t>(*descriptor, meta, &sanitizeNumber<uint32_t>); break;
+        case VssDatatype::INT32:  compileNumber<int32_t>(*descriptor, meta, &sanitizeNumber<int32_t>); break;
+        case VssDatatype::UINT64: compileNumber<uint64_t>(*descriptor, meta, &sanitizeNumber<uint64_t>); break;
+        case VssDatatype::INT64:  compileNumber<int64_t>(*descriptor, meta, &sanitizeNumber<int64_t>); break;
+        case VssDatatype::FLOAT:  compileNumber<float>(*descriptor, meta, &sanitizeNumber<float>); break;
+        case VssDatatype::DOUBLE: compileNumber<double>(*descriptor, meta, &sanitizeNumber<double>); break;
+        case VssDatatype::UINT8_ARRAY:  compileNumber<uint8_t>(*descriptor, meta, &sanitizeNumberArray<uint8_t>); break;
+        case VssDatatype::INT8_ARRAY:   compileNumber<int8_t>(*descriptor, meta, &sanitizeNumberArray<int8_t>); break;
+        case VssDatatype::UINT16_ARRAY: compileNumber<uint16_t>(*descriptor, meta, &sanitizeNumberArray<uint16_t>); break;
+        case VssDatatype::INT16_ARRAY:  compileNumber<int16_t>(*descriptor, meta, &sanitizeNumberArray<int16_t>); break;
+        case VssDatatype::UINT32_ARRAY: compileNumber<uint32_t>(*descriptor, meta, &sanitizeNumberArray<uint32_t>); break;
+        case VssDatatype::INT32_ARRAY:  compileNumber<int32_t>(*descriptor, meta, &sanitizeNumberArray<int32_t>); break;
+        case VssDatatype::UINT64_ARRAY: compileNumber<uint64_t>(*descriptor, meta, &sanitizeNumberArray<uint64_t>); break;
+        case VssDatatype::INT64_ARRAY:  compileNumber<int64_t>(*descriptor, meta, &sanitizeNumberArray<int64_t>); break;
+        case VssDatatype::FLOAT_ARRAY:  compileNumber<float>(*descriptor, meta, &sanitizeNumberArray<float>); break;
+        case VssDatatype::DOUBLE_ARRAY: compileNumber<double>(*descriptor, meta, &sanitizeNumberArray<double>); break;
+        case VssDatatype::BOOLEAN:
+            descriptor->sanitizer_ = &sanitizeBool;
+            break;
+        case VssDatatype::STRING:
+            descriptor->sanitizer_ = &sanitizeString;
+            // In VSS 3.0 the keyword "allowed" replaced "enum"
+            for (const char *key : {"allowed", "enum"}) {
+                if (meta.contains(key) && meta[key].is_array()) {
+                    AllowedValues allowed;
+                    allowed.definition = meta[key];
+                    for (const auto &item : allowed.definition.array_range()) {
+                        allowed.values.insert(item.as_string());
+                    }
+                    descriptor->allowed_.push_back(std::move(allowed));
+                }
+            }
+            break;
+        case VssDatatype::UNKNOWN:
+            break;
+        default: {
+            // boolean and string arrays, elements are checked one by one
+            jsoncons::json elementMeta;
+            elementMeta["datatype"] = descriptor->datatypeName_.substr(0, descriptor->datatypeName_.size() - 2);
+            descriptor->element_ = compile(elementMeta);
+            descriptor->sanitizer_ = &sanitizeArray;
+            break;
+        }
+    }
+    return descriptor;
+}
+
+jsoncons::json VssSignalDescriptor::definitionOf(const jsoncons::json &meta) {
+    jsoncons::json definition;
+    for (const char *key : {"datatype", "min", "max", "allowed", "enum"}) {
+        if (meta.contains(key)) {
+            definition.insert_or_assign(key, meta[key]);
+        }
+    }
+    return definition;
+}
 
 /** Converting numeric types. We will rely on JSoncons implementation, i.e. if it is 
  *  an acceptable number for jsoncons, so it is for us.
@@ -39,7 +128,7 @@
  *  are not the intention of a client
  */
 template<typename T>
-void checkNumTypes(jsoncons::json &meta, jsoncons::json &val )
+VssValue VssSignalDescriptor::sanitizeNumber(const VssSignalDescriptor &descriptor, jsoncons::json &val)
 {
     T cval;
     try {
@@ -47,12 +136,12 @@ void checkNumTypes(jsoncons::json &meta, jsoncons::json &val )
     }
     catch(std::exception const& e) {
       std::stringstream msg;
-      msg << "Value " << val << " can not be converted to defined type " << meta["datatype"].as_string() << ". Reason: " << e.what();
+      msg << "Value " << val << " can not be converted to defined type " << descriptor.datatypeName_ << ". Reason: " << e.what();
       throw outOfBoundException(msg.str());
     }
     catch(...) {
       std::stringstream msg;
-      msg << "Value " << val << " can not be converted to defined type " << meta["datatype"].as_string() << ". Reason: " << boost::current_exception_diagnostic_information();
+      msg << "Value " << val << " can not be converted to defined type " << descriptor.datatypeName_ << ". Reason: " << boost::current_exception_diagnostic_information();
       throw outOfBoundException(msg.str());
       
     }
@@ -60,23 +149,76 @@ void checkNumTypes(jsoncons::json &meta, jsoncons::json &val )
     if (std::numeric_limits<T>::has_infinity && (cval == std::numeric_limits<T>::infinity() || cval == -std::numeric_limits<T>::infinity()) ) {
         throw outOfBoundException("Value out of bounds. Reason: Infinity");
     }
-    
 
-    if ( meta.contains("min") && cval < meta["min"].as<T>() ) {
+    if ( descriptor.hasMin_ && cval < descriptor.min_.get<T>() ) {
         std::stringstream msg;
-        msg << "Value " << cval << " is out of bounds. Allowed minimum is " <<  meta["min"].as<double>();
+        msg << "Value " << +cval << " is out of bounds. Allowed minimum is " << +descriptor.min_.get<T>();
         throw outOfBoundException(msg.str());
     }
 
-    if ( meta.contains("max") && cval > meta["max"].as<T>() ) {
+    if ( descriptor.hasMax_ && cval > descriptor.max_.get<T>() ) {
         std::stringstream msg;
-        msg << "Value " << cval << " is out of bounds. Allowed maximum is " <<  meta["max"].as<double>();
+        msg << "Value " << +cval << " is out of bounds. Allowed maximum is " << +descriptor.max_.get<T>();
         throw outOfBoundException(msg.str());
     }
-    val=val.as<T>();
+    val=cval;
+    return VssValue::fromScalar<T>(cval);
 }
 
-void checkBoolType(jsoncons::json &val ) {
+/** Numeric arrays are converted into one contiguous native buffer, which is
+ *  then range checked in a branch free loop the compiler can vectorize and
+ *  stored as is. Limits of the leaf apply to every element. The JSON array
+ *  is left as given */
+template<typename T>
+VssValue VssSignalDescriptor::sanitizeNumberArray(const VssSignalDescriptor &descriptor, jsoncons::json &val)
+{
+    if (!val.is_array()) {
+      std::stringstream msg;
+      msg << "Value " << val << " can not be converted to defined type " << descriptor.datatypeName_ << ". Reason: Not an array";
+      throw outOfBoundException(msg.str());
+    }
+
+    const size_t count = val.size();
+    std::vector<T> buffer(count);
+    try {
+        T *out = buffer.data();
+        for (const auto &element : val.array_range()) {
+            *out++ = element.as<T>();
+        }
+    }
+    catch(std::exception const& e) {
+      std::stringstream msg;
+      msg << "Value " << val << " can not be converted to defined type " << descriptor.datatypeName_ << ". Reason: " << e.what();
+      throw outOfBoundException(msg.str());
+    }
+
+    const T lowest = descriptor.hasMin_ ? descriptor.min_.get<T>() : std::numeric_limits<T>::lowest();
+    const T highest = descriptor.hasMax_ ? descriptor.max_.get<T>() : std::numeric_limits<T>::max();
+    const T *data = buffer.data();
+    // an integer accumulator without early exit keeps the loop vectorizable
+    unsigned invalid = 0;
+    for (size_t i = 0; i < count; i++) {
+        // infinity is outside of [lowest, highest], NaN passes like for scalars
+        invalid |= static_cast<unsigned>(data[i] < lowest) | static_cast<unsigned>(data[i] > highest);
+    }
+
+    if (invalid != 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (std::numeric_limits<T>::has_infinity && (data[i] == std::numeric_limits<T>::infinity() || data[i] == -std::numeric_limits<T>::infinity())) {
+                throw outOfBoundException("Value out of bounds. Reason: Infinity");
+            }
+            if (data[i] < lowest || data[i] > highest) {
+                std::stringstream msg;
+                msg << "Value " << +data[i] << " at index " << i << " is out of bounds. Allowed range is "
+                    << +lowest << " to " << +highest;
+                throw outOfBoundException(msg.str());
+            }
+        }
+    }
+    return VssValue::fromArray<T>(data, count);
+}
+
+VssValue VssSignalDescriptor::sanitizeBool(const VssSignalDescriptor &, jsoncons::json &val) {
     std::string v=val.as<std::string>();
     boost::algorithm::erase_all(v, "\"");
 
@@ -91,95 +233,53 @@ void checkBoolType(jsoncons::json &val ) {
         msg << val.as_string() << " is not a bool. Valid values are true and false ";
         throw outOfBoundException(msg.str());
     }
+    return VssValue::fromScalar<bool>(val.as<bool>());
 }
 
-void checkEnumType(jsoncons::json &enumDefinition, jsoncons::json &val ) {
-    
-    for (const auto& item: enumDefinition.array_range()){
-      if(item.as_string() == val){
-        return;
-      }
+VssValue VssSignalDescriptor::sanitizeString(const VssSignalDescriptor &descriptor, jsoncons::json &val) {
+    for (const auto &allowed : descriptor.allowed_) {
+        if (!val.is_string() || allowed.values.find(val.as_string()) == allowed.values.end()) {
+            std::stringstream msg;
+            msg << val.as_string() << " is a defined enum value. Valid values are " << allowed.definition;
+            throw outOfBoundException(msg.str());
+        }
     }
-
-    std::stringstream msg;
-    msg << val.as_string() << " is a defined enum value. Valid values are " << print(enumDefinition);
-    throw outOfBoundException(msg.str());
+    return VssValue::fromString(val.as<std::string>());
 }
 
-void VssDatabase::checkArrayType(std::string& subdatatype, jsoncons::json &val) {
-    jsoncons::json metadata;
-    metadata["datatype"] = subdatatype;
+VssValue VssSignalDescriptor::sanitizeArray(const VssSignalDescriptor &descriptor, jsoncons::json &val) {
     try{
         for (auto v : val.array_range())
         {
-            checkAndSanitizeType(metadata, v);
+            descriptor.element_->sanitize(v);
         }
     }
     catch(std::exception const& e) {
       std::stringstream msg;
-      msg << "Value " << val << " can not be converted to defined type " << subdatatype << "[]. Reason: " << e.what();
+      msg << "Value " << val << " can not be converted to defined type " << descriptor.datatypeName_ << ". Reason: " << e.what();
       throw outOfBoundException(msg.str());
     } catch(...) {
       std::stringstream msg;
-      msg << "Value " << val << " can not be converted to defined type " << subdatatype << "[]. Reason: " << boost::current_exception_diagnostic_information();
+      msg << "Value " << val << " can not be converted to defined type " << descriptor.datatypeName_ << ". Reason: " << boost::current_exception_diagnostic_information();
       throw outOfBoundException(msg.str());
     }
+    return VssValue::fromJson(descriptor.datatype_, val);
 }
 
+VssValue VssSignalDescriptor::sanitizeUnsupported(const VssSignalDescriptor &descriptor, jsoncons::json &) {
+    std::string msg = "The datatype " + descriptor.datatypeName_ + " is not supported ";
+    throw genException(msg);
+}
+
+VssValue VssSignalDescriptor::sanitizeInvalidLimit(const VssSignalDescriptor &descriptor, jsoncons::json &) {
+    throw genException(descriptor.limitError_);
+}
 
-/** This will check whether &val val is a valid value for the sensor described
- *  by meta  and whether  it is within the limits defined by VSS if any */
-void VssDatabase::checkAndSanitizeType(jsoncons::json &meta, jsoncons::json &val) {
-    std::string dt=meta["datatype"].as<std::string>();
-    if (dt == "uint8") {
-        checkNumTypes<uint8_t>(meta,val);
-    }
-    else if (dt == "int8") {
-        checkNumTypes<int8_t>(meta,val);
-    }
-    else if (dt == "uint16") {
-        checkNumTypes<uint16_t>(meta,val);
-    }
-    else if (dt == "int16") {
-        checkNumTypes<int16_t>(meta,val);
-    }
-    else if (dt == "uint32") {
-        checkNumTypes<uint32_t>(meta,val);
-    }
-    else if (dt == "int32") {
-        checkNumTypes<int32_t>(meta,val);
-    }
-    else if (dt == "uint64") {
-        checkNumTypes<uint64_t>(meta,val);
-    }
-    else if (dt == "int64") {
-        checkNumTypes<int64_t>(meta,val);
-    }
-    else if (dt == "float") {
-        checkNumTypes<float>(meta,val);
-    }
-    else if (dt == "double") {
-        checkNumTypes<double>(meta,val);
-    }
-    else if (dt == "boolean") { 
-        checkBoolType(val);
-    }
-    else if (dt == "string") { 
-    	// In VSS 3.0 the keyword "allowed" replaced "enum"
-        if (meta.contains("allowed") ) {
-            checkEnumType(meta["allowed"], val);
-        }
-        if (meta.contains("enum") ) {
-          checkEnumType(meta["enum"], val);
-        }
-    }
-    else if (dt.rfind("[]") == dt.size()-2){
-        std::string subdatatype = dt.substr(0, dt.size()-2);
-        checkArrayType(subdatatype, val);
-    }
-    else {
-      std::string msg = "The datatype " + dt + " is not supported ";
-      throw genException(msg);
-    }
 
+/** This will check whether &val val is a valid value for the sensor described
+ *  by meta  and whether  it is within the limits defined by VSS if any.
+ *  Leafs of the tree carry a compiled descriptor, this is for metadata given
+ *  by callers */
+void VssDatabase::checkAndSanitizeType(const jsoncons::json &meta, jsoncons::json &val) {
+    VssSignalDescriptor::compile(meta)->sanitize(val);
 }
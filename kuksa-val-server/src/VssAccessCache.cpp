@@ -0,0 +1,76 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "VssAccessCache.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+constexpr size_t VssAccessCache::SLOTS;
+std::atomic<uint64_t> VssAccessCache::totalHits_{0};
+std::atomic<uint64_t> VssAccessCache::totalMisses_{0};
+
+namespace {
+constexpr uint32_t PERMISSION_BITS = 2;
+constexpr uint32_t PERMISSION_MASK = (1u << PERMISSION_BITS) - 1;
+constexpr uint32_t MAX_ID = UINT32_MAX >> PERMISSION_BITS;
+}
+
+VssAccessCache::~VssAccessCache() {
+  totalHits_.fetch_add(hits_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  totalMisses_.fetch_add(misses_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+bool VssAccessCache::lookup(uint32_t id, uint8_t &permissions) {
+  if (id != 0 && id <= MAX_ID) {
+    uint32_t slot = slots_[id % SLOTS].load(std::memory_order_relaxed);
+    if (slot != 0 && (slot >> PERMISSION_BITS) == id) {
+      permissions = static_cast<uint8_t>(slot & PERMISSION_MASK);
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void VssAccessCache::store(uint32_t id, uint8_t permissions) {
+  if (id != 0 && id <= MAX_ID) {
+    slots_[id % SLOTS].store((id << PERMISSION_BITS) | (permissions & PERMISSION_MASK), std::memory_order_relaxed);
+  }
+}
+
+VssAccessCache::Stats VssAccessCache::stats() const {
+  return Stats{hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed)};
+}
+
+VssAccessCache::Stats VssAccessCache::totalStats() {
+  return Stats{totalHits_.load(std::memory_order_relaxed), totalMisses_.load(std::memory_order_relaxed)};
+}
+
+std::string VssAccessCache::Stats::toString() const {
+  uint64_t checks = hits + misses;
+  std::stringstream ss;
+  ss << hits << " hits, " << misses << " misses (" << std::fixed << std::setprecision(1)
+     << (checks == 0 ? 0.0 : 100.0 * hits / checks) << "% hit rate)";
+  return ss.str();
+}
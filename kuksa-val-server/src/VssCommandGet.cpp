@@ -36,9 +36,6 @@
  * compatibility **/
 jsoncons::json VssCommandProcessor::processGet(KuksaChannel &channel,
                                              jsoncons::json &request) {
-  std::string pathStr= request["path"].as_string();
-  VSSPath path = VSSPath::fromVSS(pathStr);
-
   try {
     requestValidator->validateGet(request);
   } catch (jsoncons::jsonschema::schema_error &e) {
@@ -66,6 +63,20 @@ jsoncons::json VssCommandProcessor::processGet(KuksaChannel &channel,
     attribute = "value";
   }
 
+  if (request.contains("paths") || request.contains("ids")) {
+    return processMultiGet(channel, request, requestId, attribute);
+  }
+
+  bool byId = request.contains("id");
+  std::string pathStr = request.get_value_or<std::string>("path", "");
+  VSSPath path = VSSPath::fromVSS(pathStr);
+  if (byId) {
+    if (!pathForId(request["id"], path)) {
+      return JsonResponses::pathNotFound(requestId, "get", "id " + request["id"].as_string());
+    }
+    pathStr = path.to_string();
+  }
+
   logger->Log(LogLevel::VERBOSE, "Get request with id " + requestId +
                                      " for path: " + path.to_string() + " with attribute: " + attribute);
 
@@ -98,6 +109,9 @@ jsoncons::json VssCommandProcessor::processGet(KuksaChannel &channel,
     }
     if (vssPaths.size() == 1) {
       answer["data"] = datapoints[0];
+      if (byId) {
+        answer["data"]["id"] = path.id();
+      }
     } else {
       answer["data"] = datapoints;
     }
@@ -116,3 +130,84 @@ jsoncons::json VssCommandProcessor::processGet(KuksaChannel &channel,
   return answer;
 
 }
+
+/** Gets all paths of a request at once. Access is checked for every leaf
+ * before anything is read, the values are then read in one go from the
+ * database, so the answer reflects one consistent state **/
+jsoncons::json VssCommandProcessor::processMultiGet(KuksaChannel &channel,
+                                                   jsoncons::json &request,
+                                                   const std::string &requestId,
+                                                   const std::string &attribute) {
+  jsoncons::json answer;
+  VssGetPairs getPairs;
+  // entries requested by id get their id added to the answer
+  std::vector<bool> byId;
+
+  try {
+    std::vector<std::pair<VSSPath, bool>> requested;
+    if (request.contains("paths")) {
+      for (const auto &pathJson : request["paths"].array_range()) {
+        requested.emplace_back(VSSPath::fromVSS(pathJson.as_string()), false);
+      }
+    }
+    if (request.contains("ids")) {
+      for (const auto &id : request["ids"].array_range()) {
+        VSSPath path = VSSPath::fromVSS("");
+        if (!pathForId(id, path)) {
+          return JsonResponses::pathNotFound(requestId, "get", "id " + id.as_string());
+        }
+        requested.emplace_back(path, true);
+      }
+    }
+    logger->Log(LogLevel::VERBOSE, "Get request with id " + requestId + " for " +
+                                       std::to_string(requested.size()) +
+                                       " paths with attribute: " + attribute);
+
+    for (const auto &entry : requested) {
+      std::string pathStr = entry.first.to_string();
+      list<VSSPath> vssPaths = database->getLeafPaths(entry.first);
+      if (vssPaths.empty()) {
+        return JsonResponses::pathNotFound(requestId, "get", pathStr);
+      }
+      for (auto &vssPath : vssPaths) {
+        if (!accessValidator_->checkReadAccess(channel, vssPath)) {
+          stringstream msg;
+          msg << "Insufficient read access to " << pathStr;
+          logger->Log(LogLevel::WARNING, msg.str());
+          return JsonResponses::noAccess(requestId, "get", msg.str());
+        }
+        if (!database->pathIsAttributable(vssPath, attribute)) {
+          stringstream msg;
+          msg << "Can not get " << vssPath.to_string() << " with attribute " << attribute << ".";
+          logger->Log(LogLevel::WARNING, msg.str());
+          return JsonResponses::noAccess(requestId, "get", msg.str());
+        }
+        getPairs.push_back(std::make_tuple(std::move(vssPath), attribute));
+        byId.push_back(entry.second);
+      }
+    }
+
+    bool as_string = channel.getType() != KuksaChannel::Type::GRPC;
+    answer["data"] = database->getSignals(getPairs, as_string);
+    for (size_t i = 0; i < getPairs.size(); i++) {
+      if (byId[i]) {
+        answer["data"][i]["id"] = std::get<0>(getPairs[i]).id();
+      }
+    }
+  } catch (notSetException &e) {
+    logger->Log(LogLevel::ERROR, string(e.what()));
+    return JsonResponses::notSetResponse(requestId, e.what());
+  } catch (noPathFoundonTree &e) {
+    logger->Log(LogLevel::ERROR, string(e.what()));
+    return JsonResponses::pathNotFound(requestId, "get", e.what());
+  } catch (std::exception &e) {
+    logger->Log(LogLevel::ERROR, "Unhandled error: " + string(e.what()));
+    return JsonResponses::malFormedRequest(
+    requestId, "get", string("Unhandled error: ") + e.what());
+  }
+
+  answer["action"] = "get";
+  answer["requestId"] = requestId;
+  answer["ts"] = JsonResponses::getTimeStamp();
+  return answer;
+}
@@ -0,0 +1,133 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "JsonResponses.hpp"
+#include "VSSPath.hpp"
+#include "VSSRequestValidator.hpp"
+#include "VssCommandProcessor.hpp"
+#include "exception.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <limits>
+#include "ILogger.hpp"
+#include "IVssDatabase.hpp"
+
+namespace {
+// latest time in ms whose last ns still fits the ns range of the history
+constexpr uint64_t MAX_HISTORY_MS = (std::numeric_limits<uint64_t>::max() - 999999) / 1000000;
+}
+
+/** Implements the Websocket getHistory request. Returns the recorded values of
+ *  all leafs of path between startTime and endTime (ms since epoch, both
+ *  optional and inclusive). Leafs without history are left out, it is an
+ *  error only if none of them is recorded. Times beyond the ns range of the history are
+ *  clamped, an endTime beyond it is open ended **/
+jsoncons::json VssCommandProcessor::processGetHistory(KuksaChannel &channel,
+                                                    jsoncons::json &request) {
+  try {
+    requestValidator->validateGetHistory(request);
+  } catch (jsoncons::jsonschema::schema_error &e) {
+    std::string msg = std::string(e.what());
+    boost::algorithm::trim(msg);
+    logger->Log(LogLevel::ERROR, msg);
+    return JsonResponses::malFormedRequest(
+        requestValidator->tryExtractRequestId(request), "getHistory",
+        string("Schema error: ") + msg);
+  } catch (std::exception &e) {
+    std::string msg = std::string(e.what());
+    boost::algorithm::trim(msg);
+    logger->Log(LogLevel::ERROR, "Unhandled error: " + msg);
+    return JsonResponses::malFormedRequest(
+        requestValidator->tryExtractRequestId(request), "getHistory",
+        string("Unhandled error: ") + e.what());
+  }
+
+  std::string pathStr = request["path"].as_string();
+  VSSPath path = VSSPath::fromVSS(pathStr);
+  string requestId = request["requestId"].as_string();
+
+  uint64_t from_ns = 0;
+  uint64_t to_ns = std::numeric_limits<uint64_t>::max();
+  if (request.contains("startTime")) {
+    uint64_t startTime = request["startTime"].as<uint64_t>();
+    from_ns = startTime > MAX_HISTORY_MS ? std::numeric_limits<uint64_t>::max() : startTime * 1000000;
+  }
+  if (request.contains("endTime")) {
+    uint64_t endTime = request["endTime"].as<uint64_t>();
+    if (endTime <= MAX_HISTORY_MS) {
+      // include all samples within the last millisecond
+      to_ns = endTime * 1000000 + 999999;
+    }
+  }
+
+  logger->Log(LogLevel::VERBOSE, "Get history request with id " + requestId +
+                                     " for path: " + path.to_string());
+
+  jsoncons::json answer;
+  jsoncons::json datapoints = jsoncons::json::array();
+
+  try {
+    list<VSSPath> vssPaths = database->getLeafPaths(path);
+    for (const auto &vssPath : vssPaths) {
+      if (!accessValidator_->checkReadAccess(channel, vssPath)) {
+        stringstream msg;
+        msg << "Insufficient read access to " << pathStr;
+        logger->Log(LogLevel::WARNING, msg.str());
+        return JsonResponses::noAccess(requestId, "getHistory", msg.str());
+      }
+      bool as_string = channel.getType() != KuksaChannel::Type::GRPC;
+      try {
+        datapoints.push_back(database->getHistory(vssPath, from_ns, to_ns, as_string));
+      } catch (notSetException &) {
+        // history patterns may only cover some leafs of a branch
+        if (vssPaths.size() == 1) {
+          throw;
+        }
+      }
+    }
+    if (vssPaths.size() < 1) {
+      return JsonResponses::pathNotFound(requestId, "getHistory", pathStr);
+    }
+    if (datapoints.empty()) {
+      throw notSetException("History of " + pathStr + " is not recorded.");
+    }
+    if (vssPaths.size() == 1) {
+      answer["data"] = datapoints[0];
+    } else {
+      answer["data"] = datapoints;
+    }
+  } catch (notSetException &e) {
+    logger->Log(LogLevel::ERROR, string(e.what()));
+    answer = JsonResponses::notSetResponse(requestId, e.what());
+    answer["action"] = "getHistory";
+    return answer;
+  } catch (std::exception &e) {
+    logger->Log(LogLevel::ERROR, "Unhandled error: " + string(e.what()));
+    return JsonResponses::malFormedRequest(
+    requestId, "getHistory", string("Unhandled error: ") + e.what());
+  }
+
+  answer["action"] = "getHistory";
+  answer["requestId"] = requestId;
+  answer["ts"] = JsonResponses::getTimeStamp();
+  return answer;
+}
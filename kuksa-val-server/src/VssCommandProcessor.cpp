@@ -24,6 +24,7 @@
 
 #include <stdint.h>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -110,6 +111,22 @@ jsoncons::json VssCommandProcessor::processUpdateVSSTree(KuksaChannel& channel,
   return answer;
 }
 
+bool VssCommandProcessor::pathForId(const jsoncons::json &id, VSSPath &path) {
+  // do not rely on the schema and on jsoncons narrowing ids silently
+  if (!id.is_uint64() || id.as<uint64_t>() > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  try {
+    path = VSSPath::fromId(static_cast<uint32_t>(id.as<uint64_t>()));
+    return true;
+  } catch (std::out_of_range &) {
+    return false;
+  } catch (std::exception &) {
+    // jsoncons failed to convert the id
+    return false;
+  }
+}
+
 jsoncons::json VssCommandProcessor::processGetMetaData(jsoncons::json &request) {
   VSSPath path=VSSPath::fromVSS(request["path"].as_string());
 
@@ -237,6 +254,12 @@ jsoncons::json VssCommandProcessor::processQuery(const string &req_json,
     if (action == "get") {
         jresponse = processGet(channel, root);
     } 
+    else if (action == "getHistory") {
+        jresponse = processGetHistory(channel, root);
+    }
+    else if (action == "resolve") {
+        jresponse = processResolve(root);
+    }
     else if (action == "set") {
         jresponse = processSet(channel, root);
     }
@@ -0,0 +1,119 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "JsonResponses.hpp"
+#include "VSSPath.hpp"
+#include "VSSRequestValidator.hpp"
+#include "VssCommandProcessor.hpp"
+#include "exception.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include "ILogger.hpp"
+#include "IVssDatabase.hpp"
+
+namespace {
+
+jsoncons::json noIdAvailable(const std::string &requestId, const std::string &path) {
+  jsoncons::json answer;
+  answer["action"] = "resolve";
+  answer["requestId"] = requestId;
+  jsoncons::json error;
+  error["number"] = "503";
+  error["reason"] = "Service Unavailable";
+  error["message"] = "No id left for " + path + ", use its path instead";
+  answer["error"] = error;
+  answer["ts"] = JsonResponses::getTimeStamp();
+  return answer;
+}
+
+}  // namespace
+
+/** Implements the Websocket resolve request. Returns the numeric id of every
+ *  leaf of the requested paths. Clients can use the ids instead of paths in
+ *  get, set and subscribe requests. Ids stay valid as long as the server runs.
+ *  Like getMetaData, resolve does not need any access rights. Access is checked
+ *  when an id is used **/
+jsoncons::json VssCommandProcessor::processResolve(jsoncons::json &request) {
+  try {
+    requestValidator->validateResolve(request);
+  } catch (jsoncons::jsonschema::schema_error &e) {
+    std::string msg = std::string(e.what());
+    boost::algorithm::trim(msg);
+    logger->Log(LogLevel::ERROR, msg);
+    return JsonResponses::malFormedRequest(
+        requestValidator->tryExtractRequestId(request), "resolve",
+        string("Schema error: ") + msg);
+  } catch (std::exception &e) {
+    std::string msg = std::string(e.what());
+    boost::algorithm::trim(msg);
+    logger->Log(LogLevel::ERROR, "Unhandled error: " + msg);
+    return JsonResponses::malFormedRequest(
+        requestValidator->tryExtractRequestId(request), "resolve",
+        string("Unhandled error: ") + e.what());
+  }
+
+  string requestId = request["requestId"].as_string();
+  std::vector<std::string> paths;
+  if (request.contains("paths")) {
+    for (const auto &path : request["paths"].array_range()) {
+      paths.push_back(path.as_string());
+    }
+  } else {
+    paths.push_back(request["path"].as_string());
+  }
+
+  logger->Log(LogLevel::VERBOSE, "Resolve request with id " + requestId + " for " +
+                                     std::to_string(paths.size()) + " path(s)");
+
+  jsoncons::json data = jsoncons::json::array();
+  try {
+    for (const auto &pathStr : paths) {
+      list<VSSPath> vssPaths = database->getLeafPaths(VSSPath::fromVSS(pathStr));
+      if (vssPaths.empty()) {
+        return JsonResponses::pathNotFound(requestId, "resolve", pathStr);
+      }
+      for (const auto &vssPath : vssPaths) {
+        if (vssPath.id() == 0) {
+          // the path table is full. Ids start at 1, so fail instead of
+          // returning an id no request would accept
+          logger->Log(LogLevel::WARNING, "Resolve: no id left for " + vssPath.to_string());
+          return noIdAvailable(requestId, vssPath.to_string());
+        }
+        jsoncons::json entry;
+        entry["path"] = vssPath.to_string();
+        entry["id"] = vssPath.id();
+        data.push_back(std::move(entry));
+      }
+    }
+  } catch (std::exception &e) {
+    logger->Log(LogLevel::ERROR, "Unhandled error: " + string(e.what()));
+    return JsonResponses::malFormedRequest(
+        requestId, "resolve", string("Unhandled error: ") + e.what());
+  }
+
+  jsoncons::json answer;
+  answer["action"] = "resolve";
+  answer["requestId"] = requestId;
+  answer["data"] = std::move(data);
+  answer["ts"] = JsonResponses::getTimeStamp();
+  return answer;
+}
@@ -53,8 +53,6 @@ jsoncons::json VssCommandProcessor::processSet(KuksaChannel &channel,
         requestValidator->tryExtractRequestId(request) , "set", string("Unhandled error: ") + e.what());
   }
 
-  VSSPath path = VSSPath::fromVSS(request["path"].as_string());
-  
   string requestId = request["requestId"].as_string();
 
   std::string attribute;
@@ -63,18 +61,36 @@ jsoncons::json VssCommandProcessor::processSet(KuksaChannel &channel,
   } else {
     attribute = "value";
   }
-  logger->Log(LogLevel::VERBOSE, "Set request with id " + requestId +
-                                     " for path: " + path.to_string() + " with attribute: " + attribute);
 
-  //unpack any multiset or filters here later as in
-  //list of setPairs=expand(VSSPath, filters)
-
-  std::vector<std::tuple<VSSPath,jsoncons::json>> setPairs;
-  setPairs.push_back(std::make_tuple(path, (jsoncons::json&)request[attribute]));
+  //a multiset carries a list of path/value pairs in "values". Instead of a path
+  //the id returned by resolve can be given
+  VssSetPairs setPairs;
+  if (request.contains("values")) {
+    for (auto &entry : request["values"].array_range()) {
+      VSSPath entryPath = VSSPath::fromVSS(entry.get_value_or<std::string>("path", ""));
+      if (entry.contains("id") && !pathForId(entry["id"], entryPath)) {
+        return JsonResponses::pathNotFound(requestId, "set", "id " + entry["id"].as_string());
+      }
+      if (!entry.contains(attribute)) {
+        return JsonResponses::malFormedRequest(requestId, "set",
+                                               "No " + attribute + " given for " + entryPath.to_string());
+      }
+      setPairs.push_back(std::make_tuple(entryPath, entry[attribute]));
+    }
+  } else {
+    VSSPath requestPath = VSSPath::fromVSS(request.get_value_or<std::string>("path", ""));
+    if (request.contains("id") && !pathForId(request["id"], requestPath)) {
+      return JsonResponses::pathNotFound(requestId, "set", "id " + request["id"].as_string());
+    }
+    setPairs.push_back(std::make_tuple(requestPath, (jsoncons::json&)request[attribute]));
+  }
+  VSSPath path = std::get<0>(setPairs.front());
+  logger->Log(LogLevel::VERBOSE, "Set request with id " + requestId + " for " + std::to_string(setPairs.size()) +
+                                     " path(s) starting with: " + path.to_string() + " with attribute: " + attribute);
 
   //Check Access rights  & types first. Will only proceed to set, if all paths in set are valid
   //(set all or none)
-  for ( std::tuple<VSSPath,jsoncons::json> setTuple : setPairs) {
+  for (const auto &setTuple : setPairs) {
     if (! database->pathExists(std::get<0>(setTuple) )) {
       stringstream msg;
       logger->Log(LogLevel::WARNING,msg.str());
@@ -102,8 +118,10 @@ jsoncons::json VssCommandProcessor::processSet(KuksaChannel &channel,
 
   //If all preliminary checks successful, we are setting everything
   try {
-    for ( std::tuple<VSSPath,jsoncons::json> setTuple : setPairs) {
-      database->setSignal(std::get<0>(setTuple), attribute, std::get<1>(setTuple));
+    if (setPairs.size() == 1) {
+      database->setSignal(std::get<0>(setPairs.front()), attribute, std::get<1>(setPairs.front()));
+    } else {
+      database->setSignals(setPairs, attribute);
     }
   } catch (genException &e) {
     logger->Log(LogLevel::ERROR, string(e.what()));
@@ -120,9 +138,7 @@ jsoncons::json VssCommandProcessor::processSet(KuksaChannel &channel,
     root["error"] = error;
     root["ts"] = JsonResponses::getTimeStamp();
 
-    std::stringstream ss;
-    ss << pretty_print(root);
-    return ss.str();
+    return root;
   } catch (noPathFoundonTree &e) {
     logger->Log(LogLevel::ERROR, string(e.what()));
     return JsonResponses::pathNotFound(request["requestId"].as<string>(), "set",
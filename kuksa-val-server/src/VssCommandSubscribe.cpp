@@ -47,8 +47,11 @@ jsoncons::json VssCommandProcessor::processSubscribe(KuksaChannel &channel,
         string("Unhandled error: ") + e.what());
   }
 
-  string path = request["path"].as<string>();
   string request_id = request["requestId"].as<string>();
+  VSSPath path = VSSPath::fromVSS(request.get_value_or<std::string>("path", ""));
+  if (request.contains("id") && !pathForId(request["id"], path)) {
+    return JsonResponses::pathNotFound(request_id, "subscribe", "id " + request["id"].as_string());
+  }
   std::string attribute;
   if (request.contains("attribute")) {
     attribute = request["attribute"].as_string();
@@ -61,14 +64,14 @@ jsoncons::json VssCommandProcessor::processSubscribe(KuksaChannel &channel,
       LogLevel::VERBOSE,
       string(
           "VssCommandProcessor::processSubscribe: Client wants to subscribe ") +
-          path);
+          path.to_string());
 
   boost::uuids::uuid subId;;
   try {
     subId = subHandler->subscribe(channel, database, path, attribute);
   } catch (noPathFoundonTree &noPathFound) {
     logger->Log(LogLevel::ERROR, string(noPathFound.what()));
-    return JsonResponses::pathNotFound(request_id, "subscribe", path);
+    return JsonResponses::pathNotFound(request_id, "subscribe", path.to_string());
   } catch (noPermissionException &nopermission) {
     logger->Log(LogLevel::ERROR, string(nopermission.what()));
     return JsonResponses::noAccess(request_id, "subscribe",
@@ -20,14 +20,14 @@
  **********************************************************************/
 
 
+#include <algorithm>
 #include <limits>
 #include <regex>
 #include <stdexcept>
 #include <fstream>
 #include <ctime>
+#include <thread>
 #include <boost/algorithm/string.hpp>
-#include "jsonpath/json_query.hpp"
-#include "jsoncons_ext/jsonpatch/jsonpatch.hpp"
 
 #include "exception.hpp"
 #include "visconf.hpp"
@@ -35,6 +35,8 @@
 #include "IAccessChecker.hpp"
 #include "ISubscriptionHandler.hpp"
 #include "VssDatabase.hpp"
+#include "VssModelCompiler.hpp"
+#include "VssValuePersistence.hpp"
 #include "KuksaChannel.hpp"
 #include "JsonResponses.hpp"
 
@@ -47,9 +49,16 @@ VssDatabase::VssDatabase(std::shared_ptr<ILogger> loggerUtil,
                          std::shared_ptr<ISubscriptionHandler> subHandle) {
   logger_ = loggerUtil;
   subHandler_ = subHandle;
+  snapshot_ = std::make_shared<VssTreeSnapshot>();
+  snapshotEpoch_ = nextSnapshotEpoch();
 }
 
-VssDatabase::~VssDatabase() {}
+VssDatabase::~VssDatabase() {
+  // the background writer of persistence may still take snapshots of the value store
+  if (persistence_) {
+    persistence_->stop();
+  }
+}
 
 /** Returns true if the json structure is of VSS type sensor */
 bool VssDatabase::isActor(const json &element) {
@@ -68,7 +77,8 @@ bool VssDatabase::isAttribute(const json &element) {
 
 
 /** Iterates over a given VSS tree and checks attributes specifying the "default"
- *  metadata. If a default is present, it will be used as "value" (and thus returned upon get)
+ *  metadata. If a default is present, it will be used as "value" (and thus returned upon get).
+ *  The "value" is moved to the value store once the tree is indexed
  */ 
 void VssDatabase::applyDefaultValues(json &tree, VSSPath path) {
   //logger_->Log(LogLevel::VERBOSE, "Applying default values in "+path.to_string());
@@ -99,10 +109,10 @@ void VssDatabase::applyDefaultValues(json &tree, VSSPath path) {
 
 // Initializer
 void VssDatabase::initJsonTree(const boost::filesystem::path &fileName) {
+  jsoncons::json tree;
   try {
     std::ifstream is(fileName.string());
-    is >> data_tree__;
-    meta_tree__ = data_tree__;
+    is >> tree;
 
     logger_->Log(LogLevel::VERBOSE, "VssDatabase::VssDatabase : VSS tree initialized using JSON file = "
                 + fileName.string());
@@ -114,28 +124,520 @@ void VssDatabase::initJsonTree(const boost::filesystem::path &fileName) {
     throw e;
   }
 
-  applyDefaultValues(data_tree__["Vehicle"], VSSPath::fromVSS("Vehicle"));
+  applyDefaultValues(tree["Vehicle"], VSSPath::fromVSS("Vehicle"));
+  initTree(std::move(tree));
+}
+
+void VssDatabase::initTree(jsoncons::json tree) {
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  valueStore_.clear();
+  publishTree(std::move(tree));
+  logger_->Log(LogLevel::INFO, "VssDatabase: VSS tree uses approx. "
+               + std::to_string(indexMemoryFootprint(*currentSnapshot())) + " bytes, value store approx. "
+               + std::to_string(valueStore_.memoryFootprint()) + " bytes");
+}
+
+void VssDatabase::initCompiledModel(VssCompiledModel model) {
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  valueStore_.clear();
+
+  // leafs of the same type and limits share their descriptor
+  std::vector<std::shared_ptr<const VssSignalDescriptor>> descriptors;
+  descriptors.reserve(model.descriptors.size());
+  for (const auto &definition : model.descriptors) {
+    descriptors.push_back(VssSignalDescriptor::compile(definition));
+  }
+
+  auto previous = currentSnapshot();
+  auto snapshot = std::make_shared<VssTreeSnapshot>();
+  snapshot->roots = std::move(model.roots);
+  snapshot->pathIndex.reserve(model.nodes.size());
+  for (auto &compiled : model.nodes) {
+    NodeType type = nodeTypeOf(compiled.element);
+    std::shared_ptr<VssSignalSlot> slot;
+    std::shared_ptr<const VssSignalDescriptor> descriptor;
+    if (type != NodeType::BRANCH) {
+      descriptor = compiled.descriptor < descriptors.size() ? descriptors[compiled.descriptor]
+                                                            : VssSignalDescriptor::compile(compiled.element);
+      slot = valueStore_.getOrCreateSlot(compiled.path, descriptor->datatype());
+      moveValueToSlot(compiled.element, "value", *slot, *descriptor);
+      moveValueToSlot(compiled.element, "targetValue", *slot, *descriptor);
+    }
+    VSSPath vssPath = VSSPath::internVSSGen2(compiled.path);
+    snapshot->pathIndex[vssPath] = std::make_shared<const VssNode>(
+        VssNode{std::move(compiled.element), type, vssPath, std::move(compiled.children), slot, descriptor});
+  }
+  VssReplacedNodes replaced;
+  replaced.elements = snapshot->roots;
+  publishSnapshot(std::move(snapshot), *previous, replaced, true);
+  logger_->Log(LogLevel::INFO, "VssDatabase: VSS tree uses approx. "
+               + std::to_string(indexMemoryFootprint(*currentSnapshot())) + " bytes, value store approx. "
+               + std::to_string(valueStore_.memoryFootprint()) + " bytes, "
+               + std::to_string(descriptors.size()) + " distinct descriptors");
+}
+
+void VssDatabase::enablePersistence(std::shared_ptr<VssValuePersistence> persistence) {
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  size_t skipped = 0;
+  persistence->replay([&](const std::string &path, VssAttribute attr, const VssSample &sample) {
+    auto slot = valueStore_.findSlot(path);
+    // the model may have changed since the value has been recorded
+    if (!slot || slot->datatype() != sample.value.datatype()) {
+      skipped++;
+      return;
+    }
+    slot->store(attr, sample);
+  });
+  if (skipped > 0) {
+    logger_->Log(LogLevel::WARNING, "VssDatabase::enablePersistence: Skipped " + std::to_string(skipped)
+                 + " recorded values not matching the current VSS tree");
+  }
+
+  persistence->start([this](const VssValuePersistence::RecordFunc &record) {
+    std::lock_guard<std::mutex> lock_guard(writeMutex_);
+    valueStore_.forEachSlot([&](const std::string &path, const VssSignalSlot &slot) {
+      for (auto attr : {VssAttribute::VALUE, VssAttribute::TARGET_VALUE}) {
+        VssSample sample;
+        if (slot.load(attr, sample)) {
+          record(path, attr, sample);
+        }
+      }
+    });
+  });
+  persistence_ = persistence;
+}
+
+size_t VssDatabase::enableHistory(const VSSPath &pattern, size_t capacity) {
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  auto snapshot = currentSnapshot();
+  size_t count = 0;
+  for (const auto &path : getLeafPaths(pattern)) {
+    const VssNode* node = findNode(*snapshot, path);
+    if (node == nullptr || !node->slot) {
+      continue;
+    }
+    auto history = std::make_shared<VssSignalHistory>(node->slot->datatype(), capacity);
+    // start with the current value, e.g. a default or a restored one
+    VssSample sample;
+    if (node->slot->load(VssAttribute::VALUE, sample)) {
+      history->append(sample);
+    }
+    node->slot->setHistory(history);
+    count++;
+  }
+  logger_->Log(LogLevel::INFO, "VssDatabase::enableHistory: Recording last " + std::to_string(capacity)
+               + " values of " + std::to_string(count) + " signals matching " + pattern.to_string());
+  return count;
+}
+
+/** Rough estimate of the heap and inline memory used by a json tree. It is
+ *  meant for comparing layouts, not for exact accounting */
+size_t VssDatabase::jsonMemoryFootprint(const jsoncons::json &tree) {
+  size_t bytes = sizeof(jsoncons::json);
+  if (tree.is_object()) {
+    for (const auto &member : tree.object_range()) {
+      bytes += member.key().size() + jsonMemoryFootprint(member.value());
+    }
+  } else if (tree.is_array()) {
+    for (const auto &element : tree.array_range()) {
+      bytes += jsonMemoryFootprint(element);
+    }
+  } else if (tree.is_string()) {
+    bytes += tree.as<string>().size();
+  }
+  return bytes;
+}
+
+/** Estimated memory used by the nodes of snapshot and its index in bytes */
+size_t VssDatabase::indexMemoryFootprint(const VssTreeSnapshot &snapshot) {
+  size_t bytes = 0;
+  for (const auto &entry : snapshot.pathIndex) {
+    bytes += sizeof(entry) + sizeof(void*) + sizeof(VssNode) + jsonMemoryFootprint(entry.second->element);
+    for (const auto &child : entry.second->children) {
+      bytes += sizeof(child) + child.capacity();
+    }
+  }
+  return bytes;
+}
+
+size_t VssDatabase::getMemoryFootprint() {
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  return indexMemoryFootprint(*currentSnapshot()) + valueStore_.memoryFootprint();
+}
+
+jsoncons::json VssDatabase::getTree(bool withValues) {
+  auto snapshot = currentSnapshot();
+  jsoncons::json tree;
+  for (const auto &name : snapshot->roots) {
+    const VssNode* node = findChild(*snapshot, "", name);
+    if (node != nullptr) {
+      tree.insert_or_assign(name, nodeToJson(*snapshot, *node, withValues));
+    }
+  }
+  return tree;
+}
+
+VssDatabase::NodeType VssDatabase::nodeTypeOf(const jsoncons::json &element) {
+  if (!element.contains("type")) {
+    return NodeType::UNKNOWN;
+  }
+  string type = element["type"].as<string>();
+  if (type == "branch") {
+    return NodeType::BRANCH;
+  } else if (type == "sensor") {
+    return NodeType::SENSOR;
+  } else if (type == "actuator") {
+    return NodeType::ACTUATOR;
+  } else if (type == "attribute") {
+    return NodeType::ATTRIBUTE;
+  }
+  return NodeType::UNKNOWN;
+}
+
+/** Wildcard paths can not be resolved through the index and still need the
+ *  JSONPath engine */
+bool VssDatabase::hasWildcard(const VSSPath &path) {
+  return path.getVSSPath().find('*') != std::string::npos;
+}
+
+/** Snapshot a thread used last. It is kept while it is the current one, so
+ *  that taking the current snapshot usually only reads snapshotEpoch_. pins
+ *  counts the SnapshotRefs using it, it may only be replaced or dropped if
+ *  there are none. source is the epoch of the database it belongs to, only
+ *  read while a SnapshotRef is alive, i.e. while the database is in use */
+struct VssDatabase::SnapshotCache {
+  uint64_t epoch = 0;
+  std::shared_ptr<const VssTreeSnapshot> snapshot;
+  unsigned pins = 0;
+  const std::atomic<uint64_t> *source = nullptr;
+};
+
+VssDatabase::SnapshotRef::SnapshotRef(const VssTreeSnapshot *snapshot, SnapshotCache *pinned,
+                                      std::shared_ptr<const VssTreeSnapshot> owned)
+    : snapshot_(snapshot), pinned_(pinned), owned_(std::move(owned)) {
+  if (pinned_) {
+    pinned_->pins++;
+  }
+}
+
+VssDatabase::SnapshotRef::SnapshotRef(SnapshotRef &&other)
+    : snapshot_(other.snapshot_), pinned_(other.pinned_), owned_(std::move(other.owned_)) {
+  other.pinned_ = nullptr;
+}
+
+VssDatabase::SnapshotRef::~SnapshotRef() {
+  if (pinned_ && --pinned_->pins == 0 && pinned_->source->load(std::memory_order_acquire) != pinned_->epoch) {
+    // superseded while in use, do not keep the old tree alive until the next read
+    pinned_->snapshot.reset();
+    pinned_->epoch = 0;
+    pinned_->source = nullptr;
+  }
+}
+
+uint64_t VssDatabase::nextSnapshotEpoch() {
+  static std::atomic<uint64_t> epoch{0};
+  return ++epoch;
+}
+
+/** Returns the current snapshot. Unless the tree changed since the calling
+ *  thread took it last, neither a lock nor a reference count is touched, so
+ *  concurrent readers do not contend. See SnapshotRef for how long a thread
+ *  keeps its last snapshot alive */
+VssDatabase::SnapshotRef VssDatabase::currentSnapshot() {
+  static thread_local SnapshotCache cache;
+  uint64_t epoch = snapshotEpoch_.load(std::memory_order_acquire);
+  if (cache.epoch == epoch) {
+    return SnapshotRef(cache.snapshot.get(), &cache, nullptr);
+  }
+  std::shared_ptr<const VssTreeSnapshot> snapshot;
+  {
+    std::lock_guard<std::mutex> lock_guard(snapshotMutex_);
+    snapshot = snapshot_;
+    epoch = snapshotEpoch_.load(std::memory_order_relaxed);
+  }
+  if (cache.pins > 0) {
+    // still in use further up the stack, e.g. by another database
+    return SnapshotRef(snapshot.get(), nullptr, snapshot);
+  }
+  cache.snapshot = std::move(snapshot);
+  cache.epoch = epoch;
+  cache.source = &snapshotEpoch_;
+  return SnapshotRef(cache.snapshot.get(), &cache, nullptr);
+}
+
+/** Builds the nodes of a complete tree and makes it the current snapshot.
+ *  Needs to be called with writeMutex_ held */
+void VssDatabase::publishTree(jsoncons::json tree) {
+  auto previous = currentSnapshot();
+  auto snapshot = std::make_shared<VssTreeSnapshot>();
+  if (tree.is_object()) {
+    for (auto &child : tree.object_range()) {
+      if (child.value().is_object()) {
+        snapshot->roots.push_back(string(child.key()));
+        indexNode(*snapshot, string(child.key()), std::move(child.value()), nullptr);
+      }
+    }
+  }
+  VssReplacedNodes replaced;
+  replaced.elements = snapshot->roots;
+  publishSnapshot(std::move(snapshot), *previous, replaced, true);
+}
+
+/** Takes over the cache entries of previous, which are not affected by the
+ *  replaced nodes, and makes snapshot the current one. Readers still working
+ *  on the previous snapshot are not affected. Needs to be called with
+ *  writeMutex_ held */
+void VssDatabase::publishSnapshot(std::shared_ptr<VssTreeSnapshot> snapshot, const VssTreeSnapshot &previous,
+                                  const VssReplacedNodes &replaced, bool structureChanged) {
+  auto within = [](const string &path, const string &ancestor) {
+    return path.size() > ancestor.size() && path.compare(0, ancestor.size(), ancestor) == 0
+           && path[ancestor.size()] == '/';
+  };
+  // the node itself or anything below it has been replaced
+  auto subtreeReplaced = [&](const string &path) {
+    for (const auto *paths : {&replaced.elements, &replaced.children}) {
+      for (const auto &replacedPath : *paths) {
+        if (replacedPath == path || within(replacedPath, path)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  snapshot->version = previous.version + 1;
+  {
+    // expansions only depend on the structure of the tree, wildcards may match anywhere
+    std::lock_guard<std::mutex> lock_guard(previous.leafCacheMutex);
+    for (const auto &entry : previous.leafCache) {
+      const string path = entry.first.substr(0, entry.first.rfind('|'));
+      if (!structureChanged || (path.find('*') == string::npos && !subtreeReplaced(path))) {
+        snapshot->leafCache.insert(entry);
+      }
+    }
+  }
+  {
+    // metadata contains the subtree of a node and the metadata of its ancestors
+    std::lock_guard<std::mutex> lock_guard(previous.metaDataCacheMutex);
+    for (const auto &entry : previous.metaDataCache) {
+      const string &path = entry.first;
+      bool affected = path.find('*') != string::npos || subtreeReplaced(path);
+      for (const auto &replacedPath : replaced.elements) {
+        affected = affected || within(path, replacedPath);
+      }
+      if (!affected) {
+        snapshot->metaDataCache.insert(entry);
+      }
+    }
+  }
+
+  logger_->Log(LogLevel::VERBOSE, "VssDatabase::publishSnapshot: "
+               + std::to_string(replaced.elements.size() + replaced.children.size()) + " of "
+               + std::to_string(snapshot->pathIndex.size()) + " nodes replaced for tree version "
+               + std::to_string(snapshot->version));
+  std::shared_ptr<const VssTreeSnapshot> published(std::move(snapshot));
+  std::lock_guard<std::mutex> lock_guard(snapshotMutex_);
+  snapshot_.swap(published);
+  snapshotEpoch_.store(nextSnapshotEpoch(), std::memory_order_release);
+}
+
+/** Adds element at path and all of its children to the index of snapshot.
+ *  Values are moved to the value store. Leafs are appended to addedLeafs,
+ *  if given */
+void VssDatabase::indexNode(VssTreeSnapshot &snapshot, const std::string &path, jsoncons::json element,
+                            std::vector<std::string> *addedLeafs) {
+  std::vector<std::string> children;
+  if (element.contains("children")) {
+    jsoncons::json childElements = std::move(element.at("children"));
+    element.erase("children");
+    if (childElements.is_object()) {
+      for (auto &child : childElements.object_range()) {
+        if (child.value().is_object()) {
+          children.push_back(string(child.key()));
+          indexNode(snapshot, path + "/" + children.back(), std::move(child.value()), addedLeafs);
+        }
+      }
+    }
+  }
+
+  NodeType type = nodeTypeOf(element);
+  std::shared_ptr<VssSignalSlot> slot;
+  std::shared_ptr<const VssSignalDescriptor> descriptor;
+  if (type != NodeType::BRANCH) {
+    descriptor = VssSignalDescriptor::compile(element);
+    slot = valueStore_.getOrCreateSlot(path, descriptor->datatype());
+    moveValueToSlot(element, "value", *slot, *descriptor);
+    moveValueToSlot(element, "targetValue", *slot, *descriptor);
+    if (addedLeafs != nullptr) {
+      addedLeafs->push_back(path);
+    }
+  }
+  VSSPath vssPath = VSSPath::internVSSGen2(path);
+  snapshot.pathIndex[vssPath] = std::make_shared<const VssNode>(
+      VssNode{std::move(element), type, vssPath, std::move(children), slot, descriptor});
+}
+
+/** Replaces current in the index of snapshot by a node with the given element
+ *  and children. If the element changed, type, descriptor and slot are
+ *  updated and contained values are moved to the value store */
+void VssDatabase::replaceNode(VssTreeSnapshot &snapshot, const VssNode &current, jsoncons::json element,
+                              std::vector<std::string> children, bool elementChanged, VssTreeChanges &changes) {
+  NodeType type = current.type;
+  std::shared_ptr<VssSignalSlot> slot = current.slot;
+  std::shared_ptr<const VssSignalDescriptor> descriptor = current.descriptor;
+  if (elementChanged) {
+    type = nodeTypeOf(element);
+    changes.structureChanged |= type != current.type;
+    if (type == NodeType::BRANCH) {
+      slot = nullptr;
+      descriptor = nullptr;
+    } else {
+      const string &path = current.path.getVSSPath();
+      descriptor = VssSignalDescriptor::compile(element);
+      slot = valueStore_.getOrCreateSlot(path, descriptor->datatype());
+      moveValueToSlot(element, "value", *slot, *descriptor);
+      moveValueToSlot(element, "targetValue", *slot, *descriptor);
+      changes.changed.push_back(path);
+    }
+  }
+  snapshot.pathIndex[current.path] = std::make_shared<const VssNode>(
+      VssNode{std::move(element), type, current.path, std::move(children), slot, descriptor});
+}
+
+/** Removes the node at path and all of its children from the index of snapshot */
+void VssDatabase::removeNode(VssTreeSnapshot &snapshot, const VSSPath &path) {
+  auto it = snapshot.pathIndex.find(path);
+  if (it == snapshot.pathIndex.end()) {
+    return;
+  }
+  std::shared_ptr<const VssNode> node = it->second;
+  snapshot.pathIndex.erase(it);
+  for (const auto &child : node->children) {
+    removeNode(snapshot, VSSPath::fromVSSGen2(path.getVSSPath() + "/" + child));
+  }
+}
+
+/** Returns node with its whole subtree as in the VSS json format. Values are
+ *  only included with withValues, otherwise they stay in the value store */
+jsoncons::json VssDatabase::nodeToJson(const VssTreeSnapshot &snapshot, const VssNode &node, bool withValues) {
+  jsoncons::json element = node.element;
+  if (withValues && node.slot) {
+    VssSample sample;
+    if (node.slot->load(VssAttribute::VALUE, sample)) {
+      element.insert_or_assign("value", sample.value.toJson());
+    }
+    if (node.slot->load(VssAttribute::TARGET_VALUE, sample)) {
+      element.insert_or_assign("targetValue", sample.value.toJson());
+    }
+  }
+  if (node.type == NodeType::BRANCH || !node.children.empty()) {
+    jsoncons::json children;
+    for (const auto &name : node.children) {
+      const VssNode* child = findChild(snapshot, node.path.getVSSPath(), name);
+      if (child != nullptr) {
+        children.insert_or_assign(name, nodeToJson(snapshot, *child, withValues));
+      }
+    }
+    element.insert_or_assign("children", std::move(children));
+  }
+  return element;
+}
+
+/** Values contained in the tree, i.e. applied defaults or values given in an
+ *  overlay, are moved to the value store, so that the tree only holds metadata */
+void VssDatabase::moveValueToSlot(jsoncons::json &element, const std::string &attr, VssSignalSlot &slot,
+                                  const VssSignalDescriptor &descriptor) {
+  if (!element.contains(attr)) {
+    return;
+  }
+  VssAttribute attribute;
+  attributeFromString(attr, attribute);
+  VssSample sample;
+
+  jsoncons::json value = element[attr];
+  try {
+    sample.value = descriptor.sanitize(value);
+  } catch (std::exception &e) {
+    logger_->Log(LogLevel::WARNING, "VssDatabase::moveValueToSlot: Keeping " + attr + " "
+                 + element[attr].as<string>() + " as string. Reason: " + e.what());
+    sample.value = VssValue::fromString(element[attr].as<string>());
+  }
+  slot.store(attribute, sample);
+  element.erase(attr);
+}
+
+/** Resolves a path to a single node of snapshot. Returns nullptr if the path
+ *  does not exist or references multiple nodes */
+const VssDatabase::VssNode* VssDatabase::findNode(const VssTreeSnapshot &snapshot, const VSSPath &path) {
+  auto it = snapshot.pathIndex.find(path);
+  if (it != snapshot.pathIndex.end()) {
+    return it->second.get();
+  }
+  if (!hasWildcard(path)) {
+    return nullptr;
+  }
+  std::vector<const VssNode*> matches = matchNodes(snapshot, path);
+  return matches.size() == 1 ? matches.front() : nullptr;
+}
+
+const VssDatabase::VssNode* VssDatabase::findChild(const VssTreeSnapshot &snapshot, const std::string &parentPath,
+                                                   const std::string &name) {
+  auto it = snapshot.pathIndex.find(VSSPath::fromVSSGen2(parentPath.empty() ? name : parentPath + "/" + name));
+  return it == snapshot.pathIndex.end() ? nullptr : it->second.get();
+}
+
+/** Returns all nodes matching a path, in which elements may be "*" to match
+ *  any child. Like the JSONPath query the path stands for, but walking the
+ *  names of the children instead of the json tree */
+std::vector<const VssDatabase::VssNode*> VssDatabase::matchNodes(const VssTreeSnapshot &snapshot, const VSSPath &path) {
+  std::vector<string> elements;
+  boost::split(elements, path.getVSSPath(), boost::is_any_of("/"));
+
+  std::vector<const VssNode*> matches;
+  for (const auto &name : snapshot.roots) {
+    if (elements[0] == "*" || elements[0] == name) {
+      const VssNode* node = findChild(snapshot, "", name);
+      if (node != nullptr) {
+        matches.push_back(node);
+      }
+    }
+  }
+  for (size_t depth = 1; depth < elements.size() && !matches.empty(); depth++) {
+    std::vector<const VssNode*> next;
+    for (const VssNode* parent : matches) {
+      for (const auto &name : parent->children) {
+        if (elements[depth] == "*" || elements[depth] == name) {
+          const VssNode* node = findChild(snapshot, parent->path.getVSSPath(), name);
+          if (node != nullptr) {
+            next.push_back(node);
+          }
+        }
+      }
+    }
+    matches.swap(next);
+  }
+  return matches;
 }
 
 //Check if a path exists, doesn't care about the type
 bool VssDatabase::pathExists(const VSSPath &path) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath());
-  if (res.size() == 0) {
-    return false;
+  auto snapshot = currentSnapshot();
+  if (!hasWildcard(path)) {
+    return snapshot->pathIndex.find(path) != snapshot->pathIndex.end();
   }
-  return true;
-  
+  return !matchNodes(*snapshot, path).empty();
 }
 
 // Check if a path is writable _in principle_, i.e. whether it is an actor or sensor.
 // This does _not_ check whether a user is authorized, and it will return false in case
 // the VSSPath references multiple destinations
 bool VssDatabase::pathIsWritable(const VSSPath &path) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath(),jsonpath::result_type::value);
-  if (res.size() != 1) { //either no match, or multiple matches
+  auto snapshot = currentSnapshot();
+  const VssNode* node = findNode(*snapshot, path);
+  if (node == nullptr) { //either no match, or multiple matches
     return false;
   }
-  if (res[0].contains("type") && ( res[0]["type"].as<string>() == "sensor" || res[0]["type"].as<string>() == "actuator" )) {
+  if (node->type == NodeType::SENSOR || node->type == NodeType::ACTUATOR) {
     return true; //sensors and actors can be written to
   }
   //else it is either another type (branch), or a broken part (no type at all) of the tree, and thus not writable
@@ -146,15 +648,18 @@ bool VssDatabase::pathIsWritable(const VSSPath &path) {
 // This does _not_ check whether a user is authorized, and it will return false in case
 // the VSSPath references multiple destinations
 bool VssDatabase::pathIsAttributable(const VSSPath &path, const std::string& attr) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath(),jsonpath::result_type::value);
-  if (res.size() < 1) { // either no match,
-    return false;
-  } else if (res.size() > 1) { // multiple matches - Allow them to enable get using wildcards
-    return true;
+  auto snapshot = currentSnapshot();
+  const VssNode* node = findNode(*snapshot, path);
+  if (node == nullptr) {
+    if (!hasWildcard(path)) { // no match
+      return false;
+    }
+    // multiple matches - Allow them to enable get using wildcards
+    return matchNodes(*snapshot, path).size() > 1;
   }
 
   if (attr == "targetValue") {
-    if (res[0].contains("type") && (res[0]["type"].as<string>() == "actuator" )) {
+    if (node->type == NodeType::ACTUATOR) {
       return true; //only actors can have target values/setpoints
     }
   } if (attr == "value") {
@@ -168,11 +673,12 @@ bool VssDatabase::pathIsAttributable(const VSSPath &path, const std::string& att
 // This does _not_ check whether a user is authorized, and it will return false in case
 // the VSSPath references multiple destinations
 bool VssDatabase::pathIsReadable(const VSSPath &path) {
-  jsoncons::json res = jsonpath::json_query(data_tree__, path.getJSONPath(),jsonpath::result_type::value);
-  if (res.size() != 1) { //either no match, or multiple matches
+  auto snapshot = currentSnapshot();
+  const VssNode* node = findNode(*snapshot, path);
+  if (node == nullptr) { //either no match, or multiple matches
     return false;
   }
-  if ( isSensor(res[0]) || isActor(res[0])|| isAttribute(res[0]) ) {
+  if (node->type == NodeType::SENSOR || node->type == NodeType::ACTUATOR || node->type == NodeType::ATTRIBUTE) {
     return true; //sensors, actors and attributes can be read
   }
   //else it is either another type (branch), or a broken part (no type at all) of the tree, and thus not writable
@@ -188,23 +694,19 @@ bool VssDatabase::checkPathValid(const VSSPath & path){
 //return the VSS datatype of a path. If the path is not found, throw
 //an exception
 string VssDatabase::getDatatypeForPath(const VSSPath &path) {
-  if ( !pathExists(path)) {
+  auto snapshot = currentSnapshot();
+  const VssNode* node = findNode(*snapshot, path);
+  if (node == nullptr) {
      throw noPathFoundonTree(path.to_string());
   }
-  if ( !pathIsReadable(path)) { //"readable" implies sensor, actuator or attribute, those have datatypes
+  if (node->type != NodeType::SENSOR && node->type != NodeType::ACTUATOR && node->type != NodeType::ATTRIBUTE) {
+    //"readable" implies sensor, actuator or attribute, those have datatypes
     stringstream ss;
     ss << path.to_string() + " does not contain a datatype because it is not a sensor/actuator/attribute.";
     throw genException(ss.str());
   }
-  jsoncons::json resArray;
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    resArray = jsonpath::json_query(data_tree__, path.getJSONPath());
-  }
-  jsoncons::json datapoint;
-  jsoncons::json result = resArray[0];
-  if (result.contains("datatype")) {
-    return result["datatype"].as<string>();
+  if (node->element.contains("datatype")) {
+    return node->element.at("datatype").as<string>();
   }
   else {
     stringstream ss;
@@ -229,96 +731,192 @@ vector<string> getPathTokens(string path) {
 // Return a list of path of all leaf nodes, which are the children of the given path
 // If the given path is already a leaf node, the to returned list contains only the given nodes 
 list<VSSPath> VssDatabase::getLeafPaths(const VSSPath &path) {
-  list<VSSPath> paths;
   bool path_is_gen1 = path.isGen1Origin();
+  auto snapshot = currentSnapshot();
 
-  //If this is a branch, recures
-  jsoncons::json pathRes;
-  try {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    pathRes = jsonpath::json_query(data_tree__, path.getJSONPath(), jsonpath::result_type::path);
-  }
-  catch (jsonpath::jsonpath_error &e) { //no valid path, return empty list
-    logger_->Log(LogLevel::VERBOSE, path.getJSONPath() + " is not a a valid path "+e.what());
+  // a single leaf does not need any expansion
+  auto it = snapshot->pathIndex.find(path);
+  if (it != snapshot->pathIndex.end() && it->second->type != NodeType::BRANCH) {
+    list<VSSPath> paths;
+    collectLeafPaths(*snapshot, *it->second, path_is_gen1, paths);
     return paths;
   }
 
-  for (auto jpath : pathRes.array_range()) {
-    jsoncons::json resArray;
-    {
-      std::lock_guard<std::mutex> lock_guard(rwMutex_);
-      resArray = jsonpath::json_query(data_tree__, jpath.as<string>());
-    }
-    if (resArray.size() == 0) {
-      continue;
+  // branches and wildcards are expanded once per tree version
+  string key = path.getVSSPath() + (path_is_gen1 ? "|gen1" : "|gen2");
+  {
+    std::lock_guard<std::mutex> lock_guard(snapshot->leafCacheMutex);
+    auto cached = snapshot->leafCache.find(key);
+    if (cached != snapshot->leafCache.end()) {
+      return cached->second;
     }
+  }
 
-    //recurse if branch
-    if (resArray[0].contains("type") && resArray[0]["type"].as<string>() == "branch") {
-      VSSPath recursepath = VSSPath::fromJSON(jpath.as<string>()+"['children'][*]", path_is_gen1);
-      paths.merge(getLeafPaths(recursepath));
-      continue;
-    }
-    else {
-      paths.push_back(VSSPath::fromJSON(jpath.as<string>(), path_is_gen1));
+  list<VSSPath> paths = expandLeafPaths(*snapshot, path);
+
+  std::lock_guard<std::mutex> lock_guard(snapshot->leafCacheMutex);
+  if (snapshot->leafCache.size() >= MAX_LEAF_CACHE_ENTRIES) {
+    // clients may request arbitrary wildcard patterns, so keep the cache bounded
+    snapshot->leafCache.clear();
+  }
+  snapshot->leafCache.emplace(key, paths);
+  return paths;
+}
+
+// Resolves a branch or wildcard path to its leafs without using the cache
+list<VSSPath> VssDatabase::expandLeafPaths(const VssTreeSnapshot &snapshot, const VSSPath &path) {
+  list<VSSPath> paths;
+  bool path_is_gen1 = path.isGen1Origin();
+
+  if (!hasWildcard(path)) {
+    auto it = snapshot.pathIndex.find(path);
+    if (it != snapshot.pathIndex.end()) {
+      collectLeafPaths(snapshot, *it->second, path_is_gen1, paths);
     }
+    return paths;
   }
 
+  for (const VssNode* node : matchNodes(snapshot, path)) {
+    collectLeafPaths(snapshot, *node, path_is_gen1, paths);
+  }
   return paths;
 }
 
+// Appends node to paths if it is a leaf, otherwise recurses into all children
+// of the branch
+void VssDatabase::collectLeafPaths(const VssTreeSnapshot &snapshot, const VssNode &node, bool gen1, list<VSSPath> &paths) {
+  if (node.type != NodeType::BRANCH) {
+    paths.push_back(gen1 ? VSSPath::fromVSSGen1(node.path.getVSSGen1Path()) : node.path);
+    return;
+  }
 
-
-// Tokenizes the signal path with '[' - ']' as separator for internal
-// processing.
-// TODO- Regex could be used here??
-vector<string> getVSSTokens(string path) {
-  vector<string> tokens;
-  char* path_char = (char*)path.c_str();
-  char* tok = strtok(path_char, "['");
-  int count = 1;
-  while (tok != NULL) {
-    string tokString = string(tok);
-    if (count % 2 == 0) {
-      tok = strtok(NULL, "']");
-      tokens.push_back(tokString);
-    } else {
-      tok = strtok(NULL, "['");
+  list<VSSPath> leaves;
+  for (const auto &name : node.children) {
+    const VssNode* child = findChild(snapshot, node.path.getVSSPath(), name);
+    if (child != nullptr) {
+      collectLeafPaths(snapshot, *child, gen1, leaves);
     }
-    count++;
   }
-
-  return tokens;
+  paths.merge(leaves);
 }
 
 
-// Apply changes for the given sourceTree
-void VssDatabase::updateJsonTree(jsoncons::json& sourceTree, const jsoncons::json& jsonTree){
-  std::error_code ec;
 
-  jsoncons::json patches;
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    patches = jsoncons::jsonpatch::from_diff(sourceTree, jsonTree);
+/** Merges overlay into target like a JSON patch diff without remove
+ *  operations would do: objects are merged key by key, arrays element by
+ *  element and anything else is replaced. Returns true if target changed */
+static bool mergeJson(jsoncons::json &target, const jsoncons::json &overlay) {
+  if (target.is_object() && overlay.is_object()) {
+    bool modified = false;
+    for (const auto &member : overlay.object_range()) {
+      if (target.contains(member.key())) {
+        modified |= mergeJson(target.at(member.key()), member.value());
+      } else {
+        target.insert_or_assign(member.key(), member.value());
+        modified = true;
+      }
+    }
+    return modified;
   }
-  jsoncons::json patchArray = jsoncons::json::array();
-  //std::cout << pretty_print(patches) << std::endl;
-  for(auto& patch: patches.array_range()){
-    if (patch["op"] != "remove"){
-      patchArray.push_back(patch);
-       
+  if (target.is_array() && overlay.is_array()) {
+    bool modified = false;
+    size_t i = 0;
+    for (const auto &element : overlay.array_range()) {
+      if (i < target.size()) {
+        modified |= mergeJson(target[i], element);
+      } else {
+        target.push_back(element);
+        modified = true;
+      }
+      i++;
     }
+    return modified;
   }
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    jsonpatch::apply_patch(sourceTree, patchArray, ec);
+  if (target != overlay) {
+    target = overlay;
+    return true;
+  }
+  return false;
+}
+
+/** Merges overlay into the children of the node at parentPath, whose names
+ *  are given. Only nodes present in the overlay are visited and only those
+ *  actually changing are replaced in the index, all others stay shared with
+ *  the previous snapshot. Existing nodes are never removed */
+void VssDatabase::mergeChildren(VssTreeSnapshot &snapshot, std::vector<std::string> &names,
+                                const jsoncons::json &overlay, const string &parentPath, VssTreeChanges &changes,
+                                VssReplacedNodes &replaced) {
+  for (const auto &child : overlay.object_range()) {
+    const jsoncons::json &overlayNode = child.value();
+    if (!overlayNode.is_object()) {
+      continue;
+    }
+    const string name = string(child.key());
+    const string path = parentPath.empty() ? name : parentPath + "/" + name;
+    auto it = snapshot.pathIndex.find(VSSPath::fromVSSGen2(path));
+    if (it == snapshot.pathIndex.end()) {
+      names.insert(std::lower_bound(names.begin(), names.end(), name), name);
+      indexNode(snapshot, path, overlayNode, &changes.added);
+      replaced.elements.push_back(path);
+      changes.structureChanged = true;
+      continue;
+    }
+
+    // keeps the node alive, while its index entry is replaced
+    std::shared_ptr<const VssNode> current = it->second;
+    jsoncons::json element = current->element;
+    std::vector<std::string> children = current->children;
+    bool modified = false;
+    for (const auto &attribute : overlayNode.object_range()) {
+      const string key = string(attribute.key());
+      if (key == "children") {
+        if (attribute.value().is_object()) {
+          mergeChildren(snapshot, children, attribute.value(), path, changes, replaced);
+        }
+        continue;
+      }
+      if (element.contains(key)) {
+        modified |= mergeJson(element.at(key), attribute.value());
+      } else {
+        element.insert_or_assign(key, attribute.value());
+        modified = true;
+      }
+    }
+
+    if (modified) {
+      replaced.elements.push_back(path);
+    } else if (children.size() != current->children.size()) {
+      replaced.children.push_back(path);
+    } else {
+      continue;
+    }
+    replaceNode(snapshot, *current, std::move(element), std::move(children), modified, changes);
   }
+}
 
-  if(ec){
-    std::cout << "error " << ec.message() << std::endl;
-    throw genException(ec.message());
+// Merges overlay into the current tree and publishes the result. Only the
+// parts of the tree present in the overlay are visited and only changed nodes
+// are rebuilt. Existing elements are never removed. Needs to be called with
+// writeMutex_ held
+VssTreeChanges VssDatabase::applyOverlay(const jsoncons::json& overlay){
+  if (!overlay.is_object()) {
+    throw genException("VSS tree update needs to be a JSON object");
   }
 
+  auto previous = currentSnapshot();
+  auto snapshot = std::make_shared<VssTreeSnapshot>();
+  snapshot->pathIndex = previous->pathIndex;
+  snapshot->roots = previous->roots;
+  VssTreeChanges changes;
+  VssReplacedNodes replaced;
+  mergeChildren(*snapshot, snapshot->roots, overlay, "", changes, replaced);
+
+  logger_->Log(LogLevel::VERBOSE, "VssDatabase::applyOverlay: " + std::to_string(changes.added.size())
+               + " leafs added, " + std::to_string(changes.changed.size()) + " leafs changed");
+  if (!replaced.elements.empty() || !replaced.children.empty()) {
+    publishSnapshot(std::move(snapshot), *previous, replaced, changes.structureChanged);
+  }
+  return changes;
 }
 
 void VssDatabase::updateJsonTree(KuksaChannel& channel,  jsoncons::json& jsonTree){
@@ -330,8 +928,8 @@ void VssDatabase::updateJsonTree(KuksaChannel& channel,  jsoncons::json& jsonTre
   if (jsonTree.contains("Vehicle")) {
     applyDefaultValues(jsonTree["Vehicle"], VSSPath::fromVSS(""));
   }
-  updateJsonTree(meta_tree__, jsonTree);
-  updateJsonTree(data_tree__, jsonTree);
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  applyOverlay(jsonTree);
 }
 
 // update a metadata in tree, which will only do one-level-deep shallow merge/update.
@@ -346,117 +944,100 @@ void VssDatabase::updateMetaData(KuksaChannel& channel, const VSSPath& path, con
   
   logger_->Log(LogLevel::VERBOSE, "VssDatabase::updateMetaData: VSS specific path =" + jPath);
     
-  jsoncons::json resMetaTree, resDataTree, resMetaTreeArray, resDataTreeArray;
-    
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    resMetaTreeArray= jsonpath::json_query(meta_tree__, jPath);
-    resDataTreeArray = jsonpath::json_query(data_tree__, jPath);
-  }
-
-  if (resMetaTreeArray.is_array() && resMetaTreeArray.size() == 1) {
-    resMetaTree = resMetaTreeArray[0];
-  }else if(resMetaTreeArray.is_object()){
-    resMetaTree = resMetaTreeArray;
-  }else{
+  std::lock_guard<std::mutex> lock_guard(writeMutex_);
+  auto previous = currentSnapshot();
+  const VssNode* node = findNode(*previous, path);
+  if (node == nullptr) {
     std::stringstream msg;
     msg << jPath + " is not a valid path";
     logger_->Log(LogLevel::ERROR, "VssDatabase::updateMetaData " + msg.str());
 
     throw notValidException(msg.str());
   }
-  if (resDataTreeArray.is_array() && resDataTreeArray.size() == 1) {
-    resDataTree = resDataTreeArray[0];
-  }else if(resDataTreeArray.is_object()){
-    resDataTree = resDataTreeArray;
-  }else{
-    std::stringstream msg;
-    msg << jPath + " is not a valid path";
-    logger_->Log(LogLevel::ERROR, "VssDatabase::updateMetaData " + msg.str());
 
-    throw notValidException(msg.str());
-  }
-  // Note: merge metadata may cause overwritting existing data values
-  resMetaTree.merge_or_update(metadata);
-  resDataTree.merge_or_update(metadata);
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    jsonpath::json_replace(meta_tree__, jPath, resMetaTree);
-    jsonpath::json_replace(data_tree__, jPath, resDataTree);
+  auto snapshot = std::make_shared<VssTreeSnapshot>();
+  snapshot->pathIndex = previous->pathIndex;
+  snapshot->roots = previous->roots;
+  VssTreeChanges changes;
+  VssReplacedNodes replaced;
+  replaced.elements.push_back(node->path.getVSSPath());
+  if (metadata.contains("children")) {
+    // children are replaced as a whole, so is the subtree
+    jsoncons::json subtree = nodeToJson(*previous, *node);
+    subtree.merge_or_update(metadata);
+    removeNode(*snapshot, node->path);
+    indexNode(*snapshot, node->path.getVSSPath(), std::move(subtree), nullptr);
+  } else {
+    // Values are kept in the value store, so merging only touches metadata
+    jsoncons::json element = node->element;
+    element.merge_or_update(metadata);
+    replaceNode(*snapshot, *node, std::move(element), node->children, true, changes);
   }
+  publishSnapshot(std::move(snapshot), *previous, replaced,
+                  metadata.contains("type") || metadata.contains("children"));
 }
 
 // Returns the response JSON for metadata request.
 jsoncons::json VssDatabase::getMetaData(const VSSPath& path) {
-  string jPath = path.getJSONPath();
-  jsoncons::json pathRes = jsonpath::json_query(meta_tree__, jPath, jsonpath::result_type::path);
-  if (pathRes.size() > 0) {
-    jPath = pathRes[0].as<string>();
-  } else {
-    return NULL;
-  }
-  logger_->Log(LogLevel::VERBOSE, "VssDatabase::getMetaData: VSS specific path =" + jPath);
-
-  vector<string> tokens = getVSSTokens(jPath);
-  int tokLength = tokens.size();
-
-  jsoncons::json parentArray[16];
-  string parentName[16];
-
-  int parentCount = 0;
-  jsoncons::json resJson;
-  string format_path = "$";
-  for (int i = 0; i < tokLength; i++) {
-    format_path = format_path + "." + tokens[i];
-    if ((i < tokLength - 1) && (tokens[i] == "children")) {
-      continue;
-    }
-    jsoncons::json resArray;
-    {
-      std::lock_guard<std::mutex> lock_guard(rwMutex_);
-      resArray = jsonpath::json_query(meta_tree__, format_path);
+  auto snapshot = currentSnapshot();
+  const string key = path.getVSSPath();
+  {
+    std::lock_guard<std::mutex> lock_guard(snapshot->metaDataCacheMutex);
+    auto cached = snapshot->metaDataCache.find(key);
+    if (cached != snapshot->metaDataCache.end()) {
+      return *cached->second;
     }
+  }
 
-    if (resArray.is_array() && resArray.size() == 1) {
-      resJson = resArray[0];
-      if (resJson.contains("description")) {
-        resJson.insert_or_assign("description",
-                                 resJson["description"].as<string>());
-      }
+  auto result = std::make_shared<const jsoncons::json>(buildMetaData(*snapshot, path));
+  if (result->is_null()) {
+    logger_->Log(LogLevel::VERBOSE, "VssDatabase::getMetaData: No metadata for " + key);
+    return NULL;
+  }
 
-      if (resJson.contains("type")) {
-        string type = resJson["type"].as<string>();
-        resJson.insert_or_assign("type", type);
-      }
-    } else {
-      // handle exception.
-      logger_->Log(LogLevel::ERROR, string("VssDatabase::getMetaData : More than 1 Branch/ value found! ")
-                  + string("Path requested needs to be more refined"));
-      return NULL;
-    }
+  std::lock_guard<std::mutex> lock_guard(snapshot->metaDataCacheMutex);
+  if (snapshot->metaDataCache.size() >= MAX_METADATA_CACHE_ENTRIES) {
+    snapshot->metaDataCache.clear();
+  }
+  snapshot->metaDataCache.emplace(key, result);
+  return *result;
+}
 
-    // last element is the requested signal.
-    if ((i == tokLength - 1) && (tokens[i] != "children")) {
-      jsoncons::json value;
-      value.insert_or_assign(tokens[i], resJson);
-      resJson = value;
+/** Returns the requested node with its whole subtree, nested into all of its
+ *  ancestors. Ancestors only carry their own attributes and the one child on
+ *  the way to the node. A wildcard path resolves to its first match */
+jsoncons::json VssDatabase::buildMetaData(const VssTreeSnapshot &snapshot, const VSSPath &path) {
+  const VssNode* node = nullptr;
+  auto it = snapshot.pathIndex.find(path);
+  if (it != snapshot.pathIndex.end()) {
+    node = it->second.get();
+  } else if (hasWildcard(path)) {
+    std::vector<const VssNode*> matches = matchNodes(snapshot, path);
+    if (!matches.empty()) {
+      node = matches.front();
     }
-
-    parentArray[parentCount] = resJson;
-    parentName[parentCount] = tokens[i];
-    parentCount++;
+  }
+  if (node == nullptr) {
+    return jsoncons::json(jsoncons::null_type());
   }
 
-  jsoncons::json result = resJson;
+  const string nodePath = node->path.getVSSPath();
+  size_t sep = nodePath.rfind('/');
+  jsoncons::json result;
+  result.insert_or_assign(nodePath.substr(sep == string::npos ? 0 : sep + 1), nodeToJson(snapshot, *node));
 
-  for (int i = parentCount - 2; i >= 0; i--) {
-    jsoncons::json element = parentArray[i];
-    element.insert_or_assign("children", result);
-    jsoncons::json parent;
-    parent.insert_or_assign(parentName[i], element);
-    result = parent;
+  while (sep != string::npos) {
+    const string parentPath = nodePath.substr(0, sep);
+    auto parent = snapshot.pathIndex.find(VSSPath::fromVSSGen2(parentPath));
+    if (parent == snapshot.pathIndex.end()) {
+      return jsoncons::json(jsoncons::null_type());
+    }
+    jsoncons::json element = parent->second->element;
+    element.insert_or_assign("children", std::move(result));
+    sep = parentPath.rfind('/');
+    result = jsoncons::json();
+    result.insert_or_assign(parentPath.substr(sep == string::npos ? 0 : sep + 1), std::move(element));
   }
-
   return result;
 }
 
@@ -467,60 +1048,154 @@ jsoncons::json VssDatabase::setSignal(const VSSPath &path, const std::string& at
   
   data["path"] = path.to_string();
 
-  jsoncons::json res; 
-  {
-    std::lock_guard<std::mutex> lock_guard(rwMutex_);
-    res = jsonpath::json_query(data_tree__, path.getJSONPath());
-    if (res.is_array() && res.size() == 1) {
-      jsoncons::json resJson = res[0];
-      if (resJson.contains("datatype")) {
-        checkAndSanitizeType(resJson, value);
-        resJson.insert_or_assign(attr, value);
-        JsonResponses::addTimeStampToJSON(resJson, "-"+attr);
-        jsonpath::json_replace(data_tree__, path.getJSONPath(), resJson);
-
-        datapoint.insert_or_assign(attr, value);
-        datapoint.insert_or_assign("ts_s",  resJson["ts_s-"+attr]);
-        datapoint.insert_or_assign("ts_ns", resJson["ts_ns-"+attr]);
-        data.insert_or_assign("dp", datapoint);
-        subHandler_->publishForVSSPath(path, resJson["datatype"].as<std::string>(), attr, data);
-      }
-      else {
-        throw genException(path.getVSSPath()+ "is invalid for set"); //Todo better error message. (Does not propagate);
+  VssAttribute attribute;
+  if (!attributeFromString(attr, attribute)) {
+    throw genException(attr + " is not a valid attribute for set");
+  }
+
+  // no lock needed, the snapshot is immutable and the slot serializes its stores
+  auto snapshot = currentSnapshot();
+  const VssNode* node = findNode(*snapshot, path);
+  if (node == nullptr) {
+    throw noPathFoundonTree(path.to_string());
+  }
+  const jsoncons::json &resJson = node->element;
+  if (node->slot && resJson.contains("datatype")) {
+    VssSample sample;
+    sample.value = node->descriptor->sanitize(value);
+    timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    sample.ts_s = ts.tv_sec;
+    sample.ts_ns = ts.tv_nsec;
+    {
+      // shared with other single sets, so a getSignals can exclude them all
+      std::shared_lock<std::shared_timed_mutex> lock(batchMutex_);
+      if (persistence_) {
+        // logged in the order the values are stored, so a replay ends with the last one
+        node->slot->store(attribute, sample, [&](const VssSample &stored) {
+          persistence_->append(node->path.getVSSPath(), attribute, stored);
+        });
+      } else {
+        node->slot->store(attribute, sample);
       }
     }
+    if (persistence_) {
+      persistence_->commit();
+    }
+
+    datapoint.insert_or_assign(attr, value);
+    datapoint.insert_or_assign("ts_s", sample.ts_s);
+    datapoint.insert_or_assign("ts_ns", sample.ts_ns);
+    data.insert_or_assign("dp", datapoint);
+    subHandler_->publishForVSSPath(path, node->element.at("datatype").as<std::string>(), attr, data);
+  }
+  else {
+    throw genException(path.getVSSPath()+ "is invalid for set"); //Todo better error message. (Does not propagate);
   }
   return data;
 }
 
-// Returns signal in JSON format
-jsoncons::json VssDatabase::getSignal(const VSSPath& path, const std::string& attr, bool as_string) {
-    jsoncons::json resArray;
-    {
-      std::lock_guard<std::mutex> lock_guard(rwMutex_);
-      resArray = jsonpath::json_query(data_tree__, path.getJSONPath());
+// Set signal values of all given paths. All values are validated before the
+// first one is stored, so either all or none of them are set
+jsoncons::json VssDatabase::setSignals(VssSetPairs &pairs, const std::string& attr) {
+  VssAttribute attribute;
+  if (!attributeFromString(attr, attribute)) {
+    throw genException(attr + " is not a valid attribute for set");
+  }
+
+  struct PendingSet {
+    const VssNode* node;
+    VssSample sample;
+  };
+  std::vector<PendingSet> pending;
+  pending.reserve(pairs.size());
+
+  // all values of a batch share the same timestamp
+  timespec ts;
+  timespec_get(&ts, TIME_UTC);
+
+  auto snapshot = currentSnapshot();
+  for (auto &pair : pairs) {
+    const VSSPath &path = std::get<0>(pair);
+    jsoncons::json &value = std::get<1>(pair);
+    const VssNode* node = findNode(*snapshot, path);
+    if (node == nullptr) {
+      throw noPathFoundonTree(path.to_string());
+    }
+    if (!node->slot || !node->element.contains("datatype")) {
+      throw genException(path.getVSSPath() + " is invalid for set");
+    }
+    VssSample sample;
+    sample.value = node->descriptor->sanitize(value);
+    sample.ts_s = ts.tv_sec;
+    sample.ts_ns = ts.tv_nsec;
+    pending.push_back(PendingSet{node, std::move(sample)});
+  }
+
+  {
+    std::lock_guard<std::shared_timed_mutex> lock_guard(batchMutex_);
+    for (const auto &set : pending) {
+      if (persistence_) {
+        set.node->slot->store(attribute, set.sample, [&](const VssSample &stored) {
+          persistence_->append(set.node->path.getVSSPath(), attribute, stored);
+        });
+      } else {
+        set.node->slot->store(attribute, set.sample);
+      }
+    }
+  }
+  if (persistence_) {
+    persistence_->commit();
+  }
+
+  jsoncons::json result = jsoncons::json::array();
+  std::vector<VssSignalUpdate> updates;
+  updates.reserve(pending.size());
+  for (size_t i = 0; i < pending.size(); i++) {
+    const VssNode* node = pending[i].node;
+    const VSSPath &path = std::get<0>(pairs[i]);
+
+    jsoncons::json data;
+    jsoncons::json datapoint;
+    data["path"] = path.to_string();
+    datapoint.insert_or_assign(attr, std::get<1>(pairs[i]));
+    datapoint.insert_or_assign("ts_s", pending[i].sample.ts_s);
+    datapoint.insert_or_assign("ts_ns", pending[i].sample.ts_ns);
+    data.insert_or_assign("dp", datapoint);
+    updates.push_back(VssSignalUpdate{path, node->element.at("datatype").as<std::string>(), data});
+    result.push_back(data);
+  }
+  subHandler_->publishForVSSPaths(updates, attr);
+  return result;
+}
+
+// Returns path and datapoint of attr stored in the slot of node
+jsoncons::json VssDatabase::signalToJson(const VssNode &node, const VSSPath &path, const std::string &attr, bool as_string) {
+    VssAttribute attribute;
+    bool validAttribute = attributeFromString(attr, attribute);
+
+    VssSample sample;
+    if (!validAttribute || !node.slot || !node.slot->load(attribute, sample)) {
+      throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
     }
+    return sampleToJson(path, attr, sample, as_string);
+}
+
+// Returns path and datapoint of a sample of attr
+jsoncons::json VssDatabase::sampleToJson(const VSSPath &path, const std::string &attr, const VssSample &sample,
+                                         bool as_string) {
     jsoncons::json answer;
     jsoncons::json datapoint;
     answer.insert_or_assign("path", path.to_string());
-    jsoncons::json result = resArray[0];
-    if (result.contains(attr)) {
-      if (as_string) {
-        datapoint.insert_or_assign(attr, result[attr].as<string>());
-      }
-      else {
-        datapoint.insert_or_assign(attr, result[attr]);
-      }
-    } else {
-      throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
+
+    if (as_string) {
+      datapoint.insert_or_assign(attr, sample.value.toJson().as<string>());
     }
-    if (result.contains("ts_s-"+attr) && result.contains("ts_ns-"+attr)) {
-      datapoint["ts_s"] = result["ts_s-"+attr].as<uint64_t>();
-      datapoint["ts_ns"] = result["ts_ns-"+attr].as<uint32_t>();
-    } else {
-      datapoint["ts_s"] = 0;
-      datapoint["ts_ns"] = 0;
+    else {
+      datapoint.insert_or_assign(attr, sample.value.toJson());
     }
+    datapoint["ts_s"] = sample.ts_s;
+    datapoint["ts_ns"] = sample.ts_ns;
 
     if (as_string) {
       JsonResponses::convertJSONTimeStampToISO8601(datapoint);
@@ -528,5 +1203,126 @@ jsoncons::json VssDatabase::getSignal(const VSSPath& path, const std::string& at
 
     answer.insert_or_assign("dp", datapoint);
     return answer;
+}
 
-}
\ No newline at end of file
+// Returns signal in JSON format
+jsoncons::json VssDatabase::getSignal(const VSSPath& path, const std::string& attr, bool as_string) {
+    auto snapshot = currentSnapshot();
+    const VssNode* node = findNode(*snapshot, path);
+    if (node == nullptr) {
+      throw noPathFoundonTree(path.to_string());
+    }
+    return signalToJson(*node, path, attr, as_string);
+}
+
+// Returns all signals in JSON format as they have been at one point in time.
+// Batched sets are excluded by batchMutex_. Single sets only hold it shared,
+// so the samples are copied again, if one of them has been stored meanwhile.
+// After MAX_GET_SIGNALS_RETRIES attempts, the samples are copied holding
+// batchMutex_ exclusively, which excludes all sets for the copy only
+jsoncons::json VssDatabase::getSignals(const VssGetPairs &pairs, bool as_string) {
+  auto snapshot = currentSnapshot();
+  std::vector<const VssNode*> nodes;
+  nodes.reserve(pairs.size());
+  for (const auto &pair : pairs) {
+    const VssNode* node = findNode(*snapshot, std::get<0>(pair));
+    if (node == nullptr) {
+      throw noPathFoundonTree(std::get<0>(pair).to_string());
+    }
+    nodes.push_back(node);
+  }
+
+  // slot and attribute read for each pair, no slot if the attribute is invalid
+  std::vector<const VssSignalSlot*> slots(pairs.size(), nullptr);
+  std::vector<VssAttribute> attributes(pairs.size(), VssAttribute::VALUE);
+  std::vector<uint64_t> sequences(pairs.size(), 0);
+  std::vector<VssSample> samples(pairs.size());
+  // vector<bool> would pack the flags, a plain byte per pair is cheaper to write
+  std::vector<uint8_t> loaded(pairs.size(), 0);
+  for (size_t i = 0; i < pairs.size(); i++) {
+    if (attributeFromString(std::get<1>(pairs[i]), attributes[i])) {
+      slots[i] = nodes[i]->slot.get();
+    }
+  }
+  auto copySamples = [&]() {
+    for (size_t i = 0; i < pairs.size(); i++) {
+      loaded[i] = slots[i] && slots[i]->load(attributes[i], samples[i]);
+    }
+  };
+
+  bool consistent = false;
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(batchMutex_);
+    for (unsigned attempt = 0; attempt < MAX_GET_SIGNALS_RETRIES && !consistent; attempt++) {
+      if (attempt > 0) {
+        std::this_thread::yield();
+      }
+      for (size_t i = 0; i < pairs.size(); i++) {
+        sequences[i] = slots[i] ? slots[i]->sequence(attributes[i]) : 0;
+      }
+      copySamples();
+      consistent = true;
+      for (size_t i = 0; i < pairs.size() && consistent; i++) {
+        consistent = !slots[i] || ((sequences[i] & 1) == 0 && slots[i]->sequence(attributes[i]) == sequences[i]);
+      }
+    }
+  }
+  if (!consistent) {
+    std::lock_guard<std::shared_timed_mutex> lock(batchMutex_);
+    copySamples();
+  }
+
+  jsoncons::json result = jsoncons::json::array();
+  result.reserve(pairs.size());
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const VSSPath &path = std::get<0>(pairs[i]);
+    const std::string &attr = std::get<1>(pairs[i]);
+    if (!loaded[i]) {
+      throw notSetException("Attribute " + attr + " on " + path.getVSSPath() + " has not been set yet.");
+    }
+    jsoncons::json entry = sampleToJson(path, attr, samples[i], as_string);
+    if (!as_string && nodes[i]->element.contains("datatype")) {
+      entry["datatype"] = nodes[i]->element.at("datatype").as<std::string>();
+    }
+    result.push_back(std::move(entry));
+  }
+  return result;
+}
+
+// Returns the recorded values of a leaf in JSON format
+jsoncons::json VssDatabase::getHistory(const VSSPath& path, uint64_t from_ns, uint64_t to_ns, bool as_string) {
+  jsoncons::json answer;
+  answer.insert_or_assign("path", path.to_string());
+
+  auto snapshot = currentSnapshot();
+  const VssNode* node = findNode(*snapshot, path);
+  if (node == nullptr) {
+    throw noPathFoundonTree(path.to_string());
+  }
+  std::shared_ptr<VssSignalHistory> history;
+  if (node->slot) {
+    history = node->slot->history();
+  }
+  if (!history) {
+    throw notSetException("History of " + path.getVSSPath() + " is not recorded.");
+  }
+
+  jsoncons::json datapoints = jsoncons::json::array();
+  for (const auto &sample : history->query(from_ns, to_ns)) {
+    jsoncons::json datapoint;
+    if (as_string) {
+      datapoint.insert_or_assign("value", sample.value.toJson().as<string>());
+    }
+    else {
+      datapoint.insert_or_assign("value", sample.value.toJson());
+    }
+    datapoint["ts_s"] = sample.ts_s;
+    datapoint["ts_ns"] = sample.ts_ns;
+    if (as_string) {
+      JsonResponses::convertJSONTimeStampToISO8601(datapoint);
+    }
+    datapoints.push_back(datapoint);
+  }
+  answer.insert_or_assign("dp", datapoints);
+  return answer;
+}
@@ -89,6 +89,16 @@ jsoncons::json VssDatabase_Record::setSignal(const VSSPath &path, const std::str
     return VssDatabase::setSignal(path, attr, value);
 }
 
+jsoncons::json VssDatabase_Record::setSignals(VssSetPairs &pairs, const std::string& attr)
+{
+    for (const auto &pair : pairs) {
+        std::string json_val;
+        std::get<1>(pair).dump_pretty(json_val);
+        BOOST_LOG(lg) << "set;" << attr << ";" << std::get<0>(pair).to_string() << ";" + json_val;
+    }
+    return VssDatabase::setSignals(pairs, attr);
+}
+
 jsoncons::json VssDatabase_Record::getSignal(const VSSPath &path, const std::string& attr, bool as_string)
 {
     if(logMode_ == "recordSetAndGet")
@@ -96,3 +106,14 @@ jsoncons::json VssDatabase_Record::getSignal(const VSSPath &path, const std::str
 
     return VssDatabase::getSignal(path, attr);
 }
+
+jsoncons::json VssDatabase_Record::getSignals(const VssGetPairs &pairs, bool as_string)
+{
+    if(logMode_ == "recordSetAndGet") {
+        for (const auto &pair : pairs) {
+            BOOST_LOG(lg) << "get;" << std::get<1>(pair) << ";" << std::get<0>(pair).to_string();
+        }
+    }
+
+    return VssDatabase::getSignals(pairs, as_string);
+}
@@ -0,0 +1,106 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "VssGrpcStreamWriter.hpp"
+
+#include "ILogger.hpp"
+
+VssGrpcStreamWriter::VssGrpcStreamWriter(std::shared_ptr<ILogger> logger, Stream *stream,
+                                         grpc::ServerContext *context)
+  : logger_(logger), stream_(stream), context_(context) {
+  thread_ = std::thread(&VssGrpcStreamWriter::writerLoop, this);
+}
+
+VssGrpcStreamWriter::~VssGrpcStreamWriter() {
+  close();
+}
+
+bool VssGrpcStreamWriter::write(const kuksa::SubscribeResponse &resp) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closed_) {
+    return false;
+  }
+  queue_.push_back(resp);
+  pending_++;
+  wakeup_.notify_one();
+  return true;
+}
+
+bool VssGrpcStreamWriter::writeNow(const kuksa::SubscribeResponse &resp) {
+  std::lock_guard<std::mutex> lock(streamMutex_);
+  return stream_->Write(resp);
+}
+
+void VssGrpcStreamWriter::cancel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (context_ != nullptr) {
+    context_->TryCancel();
+  }
+}
+
+void VssGrpcStreamWriter::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    pending_ -= queue_.size();
+    queue_.clear();
+    wakeup_.notify_one();
+  }
+  if (pending_ > 0) {
+    // a client not reading blocks the write until the call is cancelled
+    cancel();
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  // the call ends after close, copies of the channel may still cancel
+  std::lock_guard<std::mutex> lock(mutex_);
+  context_ = nullptr;
+}
+
+void VssGrpcStreamWriter::writerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wakeup_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+    if (closed_) {
+      break;
+    }
+    kuksa::SubscribeResponse resp = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    bool written;
+    {
+      std::lock_guard<std::mutex> streamLock(streamMutex_);
+      written = stream_->Write(resp);
+    }
+    lock.lock();
+    pending_--;
+    if (!written) {
+      // the stream is broken, nothing queued can be written anymore
+      logger_->Log(LogLevel::WARNING, "Error pushing data to GRPC subscriber, dropping its notifications");
+      closed_ = true;
+      pending_ -= queue_.size();
+      queue_.clear();
+      break;
+    }
+  }
+}
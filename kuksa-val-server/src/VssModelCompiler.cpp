@@ -0,0 +1,539 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "VssModelCompiler.hpp"
+
+#include "VssSignalDescriptor.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using jsoncons::json;
+
+namespace {
+
+const char MODEL_MAGIC[8] = {'K', 'V', 'S', 'S', 'M', 'D', 'L', '\0'};
+const uint32_t MODEL_FORMAT_VERSION = 2;
+/** VSS trees are far less deep, deeper nesting means a corrupt file */
+const unsigned MAX_DEPTH = 64;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t formatVersion;
+  uint32_t fileSize;
+  uint64_t contentHash;
+  uint32_t stringCount;
+  uint32_t stringsOffset;  // StringEntry[stringCount], followed by the characters
+  uint32_t nodeCount;
+  uint32_t rootCount;
+  uint32_t nodesOffset;    // CompiledNode[nodeCount] in pre-order
+  uint32_t descriptorCount;
+  uint32_t descriptorsOffset;  // uint32_t[descriptorCount], offsets of the encoded definitions
+  uint32_t valuesOffset;   // encoded node attributes and descriptor definitions
+  uint32_t valuesSize;
+};
+
+struct StringEntry {
+  uint32_t offset;  // relative to the first character after the entries
+  uint32_t length;
+};
+
+const uint32_t NODE_HAS_CHILDREN = 0x1;
+
+struct CompiledNode {
+  uint32_t name;        // string id
+  uint32_t childCount;  // direct children, following this node in pre-order
+  uint32_t attributes;  // offset of the encoded attributes in the value section
+  uint32_t flags;
+  uint32_t descriptor;  // descriptor id or VssCompiledNode::NO_DESCRIPTOR
+};
+
+enum ValueTag : uint8_t {
+  TAG_NULL = 0,
+  TAG_FALSE,
+  TAG_TRUE,
+  TAG_INT64,
+  TAG_UINT64,
+  TAG_DOUBLE,
+  TAG_STRING,  // followed by string id
+  TAG_ARRAY,   // followed by element count and elements
+  TAG_OBJECT   // followed by member count and (key id, value) pairs
+};
+
+/** Collects nodes, strings and values of a tree, then serializes them */
+class ModelWriter {
+  public:
+    void addRoot(const json &tree) {
+      if (!tree.is_object()) {
+        throw std::runtime_error("VSS tree needs to be a JSON object");
+      }
+      for (const auto &member : tree.object_range()) {
+        // like the database, only objects are nodes
+        if (member.value().is_object()) {
+          addNode(std::string(member.key()), member.value());
+          rootCount_++;
+        }
+      }
+    }
+
+    std::vector<char> serialize(uint64_t hash) const {
+      std::vector<StringEntry> entries;
+      std::string characters;
+      for (const auto &str : strings_) {
+        entries.push_back(StringEntry{static_cast<uint32_t>(characters.size()), static_cast<uint32_t>(str.size())});
+        characters += str;
+      }
+
+      FileHeader header;
+      memcpy(header.magic, MODEL_MAGIC, sizeof(header.magic));
+      header.formatVersion = MODEL_FORMAT_VERSION;
+      header.contentHash = hash;
+      header.stringCount = static_cast<uint32_t>(strings_.size());
+      header.stringsOffset = sizeof(FileHeader);
+      header.nodeCount = static_cast<uint32_t>(nodes_.size());
+      header.rootCount = rootCount_;
+      header.nodesOffset = align(header.stringsOffset + entries.size() * sizeof(StringEntry) + characters.size());
+      header.descriptorCount = static_cast<uint32_t>(descriptors_.size());
+      header.descriptorsOffset = header.nodesOffset + nodes_.size() * sizeof(CompiledNode);
+      header.valuesOffset = header.descriptorsOffset + descriptors_.size() * sizeof(uint32_t);
+      header.valuesSize = static_cast<uint32_t>(values_.size());
+      header.fileSize = header.valuesOffset + header.valuesSize;
+
+      std::vector<char> out(header.fileSize, 0);
+      memcpy(&out[0], &header, sizeof(header));
+      if (!entries.empty()) {
+        memcpy(&out[header.stringsOffset], entries.data(), entries.size() * sizeof(StringEntry));
+      }
+      if (!characters.empty()) {
+        memcpy(&out[header.stringsOffset + entries.size() * sizeof(StringEntry)], characters.data(), characters.size());
+      }
+      if (!nodes_.empty()) {
+        memcpy(&out[header.nodesOffset], nodes_.data(), nodes_.size() * sizeof(CompiledNode));
+      }
+      if (!descriptors_.empty()) {
+        memcpy(&out[header.descriptorsOffset], descriptors_.data(), descriptors_.size() * sizeof(uint32_t));
+      }
+      if (!values_.empty()) {
+        memcpy(&out[header.valuesOffset], values_.data(), values_.size());
+      }
+      return out;
+    }
+
+  private:
+    static uint32_t align(size_t offset) {
+      return static_cast<uint32_t>((offset + 7) & ~static_cast<size_t>(7));
+    }
+
+    uint32_t intern(const std::string &str) {
+      auto it = stringIds_.find(str);
+      if (it != stringIds_.end()) {
+        return it->second;
+      }
+      uint32_t id = static_cast<uint32_t>(strings_.size());
+      strings_.push_back(str);
+      stringIds_.emplace(str, id);
+      return id;
+    }
+
+    template <typename T>
+    void append(T value) {
+      const char *bytes = reinterpret_cast<const char *>(&value);
+      values_.insert(values_.end(), bytes, bytes + sizeof(T));
+    }
+
+    void encode(const json &value) {
+      if (value.is_null()) {
+        append<uint8_t>(TAG_NULL);
+      } else if (value.is_bool()) {
+        append<uint8_t>(value.as<bool>() ? TAG_TRUE : TAG_FALSE);
+      } else if (value.is_uint64()) {
+        // the parser stores non negative integers as uint64
+        append<uint8_t>(TAG_UINT64);
+        append<uint64_t>(value.as<uint64_t>());
+      } else if (value.is_int64()) {
+        append<uint8_t>(TAG_INT64);
+        append<int64_t>(value.as<int64_t>());
+      } else if (value.is_double()) {
+        append<uint8_t>(TAG_DOUBLE);
+        append<double>(value.as<double>());
+      } else if (value.is_string()) {
+        append<uint8_t>(TAG_STRING);
+        append<uint32_t>(intern(value.as<std::string>()));
+      } else if (value.is_array()) {
+        append<uint8_t>(TAG_ARRAY);
+        append<uint32_t>(static_cast<uint32_t>(value.size()));
+        for (const auto &element : value.array_range()) {
+          encode(element);
+        }
+      } else if (value.is_object()) {
+        encodeObject(value, false);
+      } else {
+        // anything else, e.g. byte strings, keeps its textual representation
+        append<uint8_t>(TAG_STRING);
+        append<uint32_t>(intern(value.as<std::string>()));
+      }
+    }
+
+    void encodeObject(const json &object, bool skipChildren) {
+      uint32_t count = 0;
+      for (const auto &member : object.object_range()) {
+        if (!(skipChildren && member.key() == "children")) {
+          count++;
+        }
+      }
+      append<uint8_t>(TAG_OBJECT);
+      append<uint32_t>(count);
+      for (const auto &member : object.object_range()) {
+        if (!(skipChildren && member.key() == "children")) {
+          append<uint32_t>(intern(std::string(member.key())));
+          encode(member.value());
+        }
+      }
+    }
+
+    /** Returns the id of the type definition of leaf, equal definitions
+     *  are stored once */
+    uint32_t addDescriptor(const json &leaf) {
+      json definition = VssSignalDescriptor::definitionOf(leaf);
+      std::string key = definition.to_string();
+      auto it = descriptorIds_.find(key);
+      if (it != descriptorIds_.end()) {
+        return it->second;
+      }
+      uint32_t id = static_cast<uint32_t>(descriptors_.size());
+      descriptors_.push_back(static_cast<uint32_t>(values_.size()));
+      encode(definition);
+      descriptorIds_.emplace(key, id);
+      return id;
+    }
+
+    void addNode(const std::string &name, const json &node) {
+      size_t index = nodes_.size();
+      bool isBranch = node.contains("type") && node["type"] == "branch";
+      nodes_.push_back(CompiledNode{intern(name), 0, 0, 0, VssCompiledNode::NO_DESCRIPTOR});
+      if (!isBranch) {
+        nodes_[index].descriptor = addDescriptor(node);
+      }
+      nodes_[index].attributes = static_cast<uint32_t>(values_.size());
+
+      bool hasChildren = node.contains("children") && node["children"].is_object();
+      encodeObject(node, hasChildren);
+      if (!hasChildren) {
+        return;
+      }
+      uint32_t childCount = 0;
+      for (const auto &child : node["children"].object_range()) {
+        if (child.value().is_object()) {
+          addNode(std::string(child.key()), child.value());
+          childCount++;
+        }
+      }
+      nodes_[index].childCount = childCount;
+      nodes_[index].flags |= NODE_HAS_CHILDREN;
+    }
+
+    std::unordered_map<std::string, uint32_t> stringIds_;
+    std::vector<std::string> strings_;
+    std::vector<CompiledNode> nodes_;
+    std::unordered_map<std::string, uint32_t> descriptorIds_;
+    std::vector<uint32_t> descriptors_;
+    std::vector<char> values_;
+    uint32_t rootCount_ = 0;
+};
+
+/** Read only mapping of a complete file */
+class MappedFile {
+  public:
+    explicit MappedFile(const boost::filesystem::path &file) {
+      fd_ = open(file.string().c_str(), O_RDONLY);
+      if (fd_ < 0) {
+        return;
+      }
+      struct stat st;
+      if (fstat(fd_, &st) != 0 || st.st_size <= 0) {
+        return;
+      }
+      void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (data == MAP_FAILED) {
+        return;
+      }
+      data_ = static_cast<const char *>(data);
+      size_ = static_cast<size_t>(st.st_size);
+    }
+
+    ~MappedFile() {
+      if (data_ != nullptr) {
+        munmap(const_cast<char *>(data_), size_);
+      }
+      if (fd_ >= 0) {
+        close(fd_);
+      }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    int fd_ = -1;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+class corruptModel : public std::runtime_error {
+  public:
+    corruptModel() : std::runtime_error("corrupt compiled VSS model") {}
+};
+
+/** Reads the node table of a mapped model. Every offset read from the file
+ *  is checked, as the file may have been truncated or modified */
+class ModelReader {
+  public:
+    ModelReader(const char *data, size_t size, const FileHeader &header)
+      : data_(data), size_(size), header_(header) {
+      size_t entriesEnd = section(header_.stringsOffset, header_.stringCount, sizeof(StringEntry));
+      entries_ = data_ + header_.stringsOffset;
+      characters_ = data_ + entriesEnd;
+      charactersSize_ = header_.nodesOffset >= entriesEnd ? header_.nodesOffset - entriesEnd : 0;
+      section(header_.nodesOffset, header_.nodeCount, sizeof(CompiledNode));
+      section(header_.descriptorsOffset, header_.descriptorCount, sizeof(uint32_t));
+      section(header_.valuesOffset, header_.valuesSize, 1);
+    }
+
+    void read(VssCompiledModel &model) {
+      model.descriptors.clear();
+      model.descriptors.reserve(header_.descriptorCount);
+      for (uint32_t i = 0; i < header_.descriptorCount; i++) {
+        uint32_t offset;
+        memcpy(&offset, data_ + header_.descriptorsOffset + i * sizeof(uint32_t), sizeof(offset));
+        size_t pos = offset;
+        model.descriptors.push_back(decode(pos, 0));
+      }
+
+      model.roots.clear();
+      model.nodes.clear();
+      model.nodes.reserve(header_.nodeCount);
+      uint32_t next = 0;
+      for (uint32_t i = 0; i < header_.rootCount; i++) {
+        model.roots.push_back(readNode(next, "", model, 0));
+      }
+      if (next != header_.nodeCount) {
+        throw corruptModel();
+      }
+    }
+
+  private:
+    size_t section(uint64_t offset, uint64_t count, uint64_t elementSize) const {
+      uint64_t end = offset + count * elementSize;
+      if (end > size_) {
+        throw corruptModel();
+      }
+      return static_cast<size_t>(end);
+    }
+
+    template <typename T>
+    T read(const char *base, size_t sectionSize, size_t &pos) const {
+      if (pos + sizeof(T) > sectionSize) {
+        throw corruptModel();
+      }
+      T value;
+      memcpy(&value, base + pos, sizeof(T));
+      pos += sizeof(T);
+      return value;
+    }
+
+    std::string string(uint32_t id) const {
+      if (id >= header_.stringCount) {
+        throw corruptModel();
+      }
+      StringEntry entry;
+      memcpy(&entry, entries_ + id * sizeof(StringEntry), sizeof(entry));
+      if (static_cast<uint64_t>(entry.offset) + entry.length > charactersSize_) {
+        throw corruptModel();
+      }
+      return std::string(characters_ + entry.offset, entry.length);
+    }
+
+    json decode(size_t &pos, unsigned depth) const {
+      if (depth > MAX_DEPTH) {
+        throw corruptModel();
+      }
+      const char *values = data_ + header_.valuesOffset;
+      switch (read<uint8_t>(values, header_.valuesSize, pos)) {
+        case TAG_NULL:
+          return json(jsoncons::null_type());
+        case TAG_FALSE:
+          return json(false);
+        case TAG_TRUE:
+          return json(true);
+        case TAG_INT64:
+          return json(read<int64_t>(values, header_.valuesSize, pos));
+        case TAG_UINT64:
+          return json(read<uint64_t>(values, header_.valuesSize, pos));
+        case TAG_DOUBLE:
+          return json(read<double>(values, header_.valuesSize, pos));
+        case TAG_STRING:
+          return json(string(read<uint32_t>(values, header_.valuesSize, pos)));
+        case TAG_ARRAY: {
+          uint32_t count = read<uint32_t>(values, header_.valuesSize, pos);
+          json array = json::array();
+          for (uint32_t i = 0; i < count; i++) {
+            array.push_back(decode(pos, depth + 1));
+          }
+          return array;
+        }
+        case TAG_OBJECT: {
+          uint32_t count = read<uint32_t>(values, header_.valuesSize, pos);
+          json object;
+          for (uint32_t i = 0; i < count; i++) {
+            std::string key = string(read<uint32_t>(values, header_.valuesSize, pos));
+            object.insert_or_assign(key, decode(pos, depth + 1));
+          }
+          return object;
+        }
+        default:
+          throw corruptModel();
+      }
+    }
+
+    /** Appends the node next and its subtree to model, returns its name */
+    std::string readNode(uint32_t &next, const std::string &parentPath, VssCompiledModel &model, unsigned depth) {
+      if (next >= header_.nodeCount || depth > MAX_DEPTH) {
+        throw corruptModel();
+      }
+      CompiledNode node;
+      memcpy(&node, data_ + header_.nodesOffset + next * sizeof(CompiledNode), sizeof(node));
+      next++;
+      if (node.descriptor != VssCompiledNode::NO_DESCRIPTOR && node.descriptor >= header_.descriptorCount) {
+        throw corruptModel();
+      }
+
+      std::string name = string(node.name);
+      std::string path = parentPath.empty() ? name : parentPath + "/" + name;
+      size_t index = model.nodes.size();
+      size_t pos = node.attributes;
+      model.nodes.push_back(VssCompiledNode{path, decode(pos, 0), {}, node.descriptor});
+      if (!model.nodes[index].element.is_object()) {
+        throw corruptModel();
+      }
+      if (node.flags & NODE_HAS_CHILDREN) {
+        std::vector<std::string> children;
+        children.reserve(node.childCount);
+        for (uint32_t i = 0; i < node.childCount; i++) {
+          children.push_back(readNode(next, path, model, depth + 1));
+        }
+        model.nodes[index].children = std::move(children);
+      }
+      return name;
+    }
+
+    const char *data_;
+    size_t size_;
+    const FileHeader &header_;
+    const char *entries_;
+    const char *characters_;
+    size_t charactersSize_;
+};
+
+/** FNV-1a, good enough to detect changed sources */
+void hashBytes(uint64_t &hash, const char *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+}
+
+void hashFile(uint64_t &hash, const boost::filesystem::path &file) {
+  std::ifstream is(file.string(), std::ios::binary);
+  if (!is) {
+    throw std::runtime_error("Can not read \"" + file.string() + "\"");
+  }
+  char buffer[16384];
+  while (is) {
+    is.read(buffer, sizeof(buffer));
+    hashBytes(hash, buffer, static_cast<size_t>(is.gcount()));
+  }
+}
+
+}  // namespace
+
+uint64_t compiledModelHash(const boost::filesystem::path &vssFile,
+                           const std::vector<boost::filesystem::path> &overlayFiles) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hashBytes(hash, reinterpret_cast<const char *>(&MODEL_FORMAT_VERSION), sizeof(MODEL_FORMAT_VERSION));
+  hashFile(hash, vssFile);
+  for (const auto &overlay : overlayFiles) {
+    // overlays are applied in order of their names, so names are part of the model
+    std::string name = overlay.filename().string();
+    hashBytes(hash, name.c_str(), name.size() + 1);
+    hashFile(hash, overlay);
+  }
+  return hash;
+}
+
+void writeCompiledModel(const boost::filesystem::path &file, const jsoncons::json &tree, uint64_t hash) {
+  ModelWriter writer;
+  writer.addRoot(tree);
+  std::vector<char> content = writer.serialize(hash);
+
+  boost::filesystem::path tmpFile = file;
+  tmpFile += ".tmp";
+  {
+    std::ofstream os(tmpFile.string(), std::ios::binary | std::ios::trunc);
+    os.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!os) {
+      throw std::runtime_error("Can not write compiled VSS model \"" + tmpFile.string() + "\"");
+    }
+  }
+  boost::filesystem::rename(tmpFile, file);
+}
+
+constexpr uint32_t VssCompiledNode::NO_DESCRIPTOR;
+
+bool loadCompiledModel(const boost::filesystem::path &file, uint64_t hash, VssCompiledModel &model) {
+  MappedFile mapped(file);
+  if (mapped.data() == nullptr || mapped.size() < sizeof(FileHeader)) {
+    return false;
+  }
+  FileHeader header;
+  memcpy(&header, mapped.data(), sizeof(header));
+  if (memcmp(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0 || header.formatVersion != MODEL_FORMAT_VERSION ||
+      header.fileSize != mapped.size() || header.contentHash != hash) {
+    return false;
+  }
+  try {
+    ModelReader reader(mapped.data(), mapped.size(), header);
+    reader.read(model);
+  } catch (const corruptModel &) {
+    return false;
+  }
+  return true;
+}
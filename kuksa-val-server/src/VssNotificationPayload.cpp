@@ -0,0 +1,65 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "VssNotificationPayload.hpp"
+
+#include "JsonResponses.hpp"
+#include "grpcHandler.hpp"
+
+namespace {
+// stands in for the subscriptionId while serializing, it is the last value of
+// the message, as object members are sorted by name
+const std::string SUBSCRIPTION_ID_PLACEHOLDER = "00000000-0000-0000-0000-000000000000";
+}  // namespace
+
+VssNotificationPayload::VssNotificationPayload(std::string vssdatatype, jsoncons::json data)
+  : vssdatatype_(std::move(vssdatatype)), data_(std::move(data)) {}
+
+VssNotificationPayload::~VssNotificationPayload() = default;
+
+std::shared_ptr<const SharedMessage> VssNotificationPayload::websocketMessage() const {
+  std::call_once(websocketEncoded_, [this] {
+    jsoncons::json answer;
+    answer["action"] = "subscription";
+    answer["subscriptionId"] = SUBSCRIPTION_ID_PLACEHOLDER;
+    answer.insert_or_assign("data", data_);
+    JsonResponses::convertJSONTimeStampToISO8601(answer["data"]["dp"]);
+
+    std::string text;
+    JsonResponses::serialize(answer, text);
+
+    auto message = std::make_shared<SharedMessage>();
+    size_t position = text.rfind(SUBSCRIPTION_ID_PLACEHOLDER);
+    message->head = text.substr(0, position);
+    message->tail = text.substr(position + SUBSCRIPTION_ID_PLACEHOLDER.size());
+    websocketMessage_ = std::move(message);
+  });
+  return websocketMessage_;
+}
+
+const kuksa::SubscribeResponse &VssNotificationPayload::grpcResponse() const {
+  std::call_once(grpcEncoded_, [this] {
+    grpcResponse_ = std::make_unique<kuksa::SubscribeResponse>();
+    grpcHandler::grpc_fill_subscribe_response(vssdatatype_, data_, grpcResponse_.get());
+  });
+  return *grpcResponse_;
+}
@@ -0,0 +1,163 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "VssPermissionMatcher.hpp"
+
+#include <limits>
+
+namespace {
+constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+}
+
+constexpr int32_t VssPermissionMatcher::NO_ENTRY;
+
+std::shared_ptr<const VssPermissionMatcher> VssPermissionMatcher::compile(const jsoncons::json &permissions) {
+  auto matcher = std::make_shared<VssPermissionMatcher>();
+  jsoncons::json parsed;
+  try {
+    if (permissions.is_string()) {
+      parsed = jsoncons::json::parse(permissions.as_string());
+    } else {
+      parsed = permissions;
+    }
+  } catch (std::exception &) {
+    return matcher;
+  }
+  if (!parsed.is_object()) {
+    return matcher;
+  }
+
+  uint32_t order = 0;
+  for (const auto &permission : parsed.object_range()) {
+    std::string value = permission.value().is_string() ? permission.value().as_string() : "";
+    // as before, an empty value does not count as exact match
+    matcher->add(std::string(permission.key()), parsePermissions(value), order++, !value.empty());
+  }
+  return matcher;
+}
+
+uint8_t VssPermissionMatcher::parsePermissions(const std::string &value) {
+  uint8_t permissions = NONE;
+  if (value.find('r') != std::string::npos) {
+    permissions |= READ;
+  }
+  if (value.find('w') != std::string::npos) {
+    permissions |= WRITE;
+  }
+  return permissions;
+}
+
+uint32_t VssPermissionMatcher::child(uint32_t node, char c) const {
+  for (const auto &entry : nodes_[node].children) {
+    if (entry.first == c) {
+      return entry.second;
+    }
+  }
+  return NO_NODE;
+}
+
+uint32_t VssPermissionMatcher::addChild(uint32_t node, char c) {
+  uint32_t next = child(node, c);
+  if (next == NO_NODE) {
+    next = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[node].children.emplace_back(c, next);
+  }
+  return next;
+}
+
+void VssPermissionMatcher::add(const std::string &key, uint8_t permissions, uint32_t order, bool exact) {
+  uint32_t node = 0;
+  bool patternAdded = false;
+  for (size_t i = 0; i < key.size(); i++) {
+    if (key[i] == '*' && !patternAdded) {
+      nodes_[node].patterns.push_back(static_cast<uint32_t>(patterns_.size()));
+      patterns_.push_back(Pattern{key.substr(i), order, permissions});
+      patternAdded = true;
+    }
+    node = addChild(node, key[i]);
+  }
+  if (exact) {
+    nodes_[node].exact = permissions;
+  } else if (!patternAdded) {
+    // a key without '*' still takes part in pattern matching
+    nodes_[node].patterns.push_back(static_cast<uint32_t>(patterns_.size()));
+    patterns_.push_back(Pattern{"", order, permissions});
+  }
+}
+
+/** Matches path against glob, where '*' matches any sequence of characters
+ *  and every other character only itself */
+bool VssPermissionMatcher::globMatch(boost::string_view glob, boost::string_view path) {
+  size_t g = 0;
+  size_t p = 0;
+  size_t starGlob = boost::string_view::npos;
+  size_t starPath = 0;
+  while (p < path.size()) {
+    if (g < glob.size() && glob[g] == '*') {
+      starGlob = g++;
+      starPath = p;
+    } else if (g < glob.size() && glob[g] == path[p]) {
+      g++;
+      p++;
+    } else if (starGlob != boost::string_view::npos) {
+      // let the last '*' consume one more character
+      g = starGlob + 1;
+      p = ++starPath;
+    } else {
+      return false;
+    }
+  }
+  while (g < glob.size() && glob[g] == '*') {
+    g++;
+  }
+  return g == glob.size();
+}
+
+uint8_t VssPermissionMatcher::permissionsFor(boost::string_view path) const {
+  // an exact key wins over all patterns
+  uint32_t node = 0;
+  for (size_t i = 0; i < path.size() && node != NO_NODE; i++) {
+    node = child(node, path[i]);
+  }
+  if (node != NO_NODE && nodes_[node].exact != NO_ENTRY) {
+    return static_cast<uint8_t>(nodes_[node].exact);
+  }
+
+  // otherwise the last matching pattern, only patterns whose prefix is a
+  // prefix of path are candidates
+  const Pattern *best = nullptr;
+  node = 0;
+  for (size_t i = 0; node != NO_NODE; i++) {
+    for (uint32_t index : nodes_[node].patterns) {
+      const Pattern &pattern = patterns_[index];
+      if ((best == nullptr || pattern.order > best->order) && globMatch(pattern.glob, path.substr(i))) {
+        best = &pattern;
+      }
+    }
+    if (i == path.size()) {
+      break;
+    }
+    node = child(node, path[i]);
+  }
+  return best == nullptr ? NONE : best->permissions;
+}
@@ -0,0 +1,411 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include "VssValuePersistence.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'K', 'V', 'S', 'S', 'S', 'N', 'P', '1'};
+const char WAL_PREFIX[] = "values.";
+const char WAL_SUFFIX[] = ".wal";
+/** Wake up the writer early, if this much data is pending */
+const size_t MAX_PENDING_BYTES = 1024 * 1024;
+
+template <typename T>
+void appendRaw(std::string &out, T value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readRaw(const char *&pos, const char *end, T &value) {
+  if (static_cast<size_t>(end - pos) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&value, pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+/** FNV-1a, detects torn and partially written records */
+uint32_t checksum(const char *data, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/** Record layout: payload size, checksum, payload. The payload holds path,
+ *  attribute, timestamp and the serialized value */
+void encodeRecord(std::string &out, const std::string &path, VssAttribute attr, const VssSample &sample) {
+  std::string payload;
+  appendRaw<uint16_t>(payload, static_cast<uint16_t>(path.size()));
+  payload.append(path);
+  appendRaw<uint8_t>(payload, static_cast<uint8_t>(attr));
+  appendRaw<uint64_t>(payload, sample.ts_s);
+  appendRaw<uint32_t>(payload, sample.ts_ns);
+  sample.value.serialize(payload);
+
+  appendRaw<uint32_t>(out, static_cast<uint32_t>(payload.size()));
+  appendRaw<uint32_t>(out, checksum(payload.data(), payload.size()));
+  out.append(payload);
+}
+
+bool decodeRecord(const char *&pos, const char *end, std::string &path, VssAttribute &attr,
+                  VssSample &sample) {
+  uint32_t size, sum;
+  if (!readRaw(pos, end, size) || !readRaw(pos, end, sum) || static_cast<size_t>(end - pos) < size ||
+      checksum(pos, size) != sum) {
+    return false;
+  }
+  const char *payload = pos;
+  const char *payloadEnd = pos + size;
+  uint16_t pathSize;
+  uint8_t attribute;
+  if (!readRaw(payload, payloadEnd, pathSize) || static_cast<size_t>(payloadEnd - payload) < pathSize) {
+    return false;
+  }
+  path.assign(payload, pathSize);
+  payload += pathSize;
+  if (!readRaw(payload, payloadEnd, attribute) || attribute > static_cast<uint8_t>(VssAttribute::TARGET_VALUE) ||
+      !readRaw(payload, payloadEnd, sample.ts_s) || !readRaw(payload, payloadEnd, sample.ts_ns) ||
+      !VssValue::deserialize(payload, payloadEnd, sample.value)) {
+    return false;
+  }
+  attr = static_cast<VssAttribute>(attribute);
+  pos = payloadEnd;
+  return true;
+}
+
+std::string readFile(const boost::filesystem::path &file) {
+  std::ifstream is(file.string(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+bool writeAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+/** Makes a rename or unlink in directory durable */
+void syncDirectory(const boost::filesystem::path &directory) {
+  int fd = open(directory.string().c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+}
+
+/** Returns the generation of a log file name, or false if it is none */
+bool walGeneration(const std::string &name, uint64_t &generation) {
+  const size_t prefix = sizeof(WAL_PREFIX) - 1;
+  const size_t suffix = sizeof(WAL_SUFFIX) - 1;
+  if (name.size() <= prefix + suffix || name.compare(0, prefix, WAL_PREFIX) != 0 ||
+      name.compare(name.size() - suffix, suffix, WAL_SUFFIX) != 0) {
+    return false;
+  }
+  std::string number = name.substr(prefix, name.size() - prefix - suffix);
+  if (number.size() > 19 || number.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  generation = std::stoull(number);
+  return true;
+}
+
+}  // namespace
+
+bool syncPolicyFromString(const std::string &name, VssSyncPolicy &policy) {
+  if (name == "none") {
+    policy = VssSyncPolicy::NONE;
+  } else if (name == "interval") {
+    policy = VssSyncPolicy::INTERVAL;
+  } else if (name == "always") {
+    policy = VssSyncPolicy::ALWAYS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+VssValuePersistence::VssValuePersistence(std::shared_ptr<ILogger> loggerUtil, VssPersistenceConfig config)
+  : logger_(loggerUtil), config_(std::move(config)) {
+  boost::filesystem::create_directories(config_.directory);
+}
+
+VssValuePersistence::~VssValuePersistence() {
+  stop();
+}
+
+boost::filesystem::path VssValuePersistence::walPath(uint64_t generation) const {
+  return config_.directory / (WAL_PREFIX + std::to_string(generation) + WAL_SUFFIX);
+}
+
+boost::filesystem::path VssValuePersistence::snapshotPath() const {
+  return config_.directory / "values.snapshot";
+}
+
+size_t VssValuePersistence::replay(const RecordFunc &apply) {
+  size_t count = 0;
+  std::string path;
+  VssAttribute attr;
+  VssSample sample;
+
+  // the snapshot contains everything up to the first log generation not yet compacted
+  uint64_t firstGeneration = 0;
+  if (boost::filesystem::exists(snapshotPath())) {
+    std::string content = readFile(snapshotPath());
+    const char *pos = content.data();
+    const char *end = pos + content.size();
+    uint32_t records;
+    if (content.size() < sizeof(SNAPSHOT_MAGIC) || memcmp(pos, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+      logger_->Log(LogLevel::WARNING, "VssValuePersistence: Ignoring invalid snapshot " + snapshotPath().string());
+    } else {
+      pos += sizeof(SNAPSHOT_MAGIC);
+      if (readRaw(pos, end, firstGeneration) && readRaw(pos, end, records)) {
+        for (uint32_t i = 0; i < records && decodeRecord(pos, end, path, attr, sample); i++) {
+          apply(path, attr, sample);
+          count++;
+        }
+      }
+    }
+  }
+
+  std::vector<uint64_t> generations;
+  for (auto &entry : boost::filesystem::directory_iterator(config_.directory)) {
+    uint64_t generation;
+    if (walGeneration(entry.path().filename().string(), generation) && generation >= firstGeneration) {
+      generations.push_back(generation);
+    }
+  }
+  std::sort(generations.begin(), generations.end());
+  for (uint64_t generation : generations) {
+    std::string content = readFile(walPath(generation));
+    const char *pos = content.data();
+    const char *end = pos + content.size();
+    while (pos < end && decodeRecord(pos, end, path, attr, sample)) {
+      apply(path, attr, sample);
+      count++;
+    }
+    if (pos < end) {
+      logger_->Log(LogLevel::WARNING, "VssValuePersistence: Skipping " + std::to_string(end - pos)
+                   + " bytes of incomplete records in " + walPath(generation).string());
+    }
+  }
+
+  std::lock_guard<std::mutex> fileLock(fileMutex_);
+  generation_ = std::max(firstGeneration, generations.empty() ? 0 : generations.back() + 1);
+  logger_->Log(LogLevel::INFO, "VssValuePersistence: Restored " + std::to_string(count) + " records from "
+               + config_.directory.string());
+  return count;
+}
+
+// Needs to be called with fileMutex_ held
+void VssValuePersistence::openLog() {
+  fd_ = open(walPath(generation_).string().c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Can not open " + walPath(generation_).string() + ": " + strerror(errno));
+  }
+  walBytes_ = 0;
+  syncDirectory(config_.directory);
+}
+
+void VssValuePersistence::start(SnapshotFunc snapshot) {
+  snapshot_ = std::move(snapshot);
+  {
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    openLog();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = true;
+  writer_ = std::thread(&VssValuePersistence::writerLoop, this);
+}
+
+void VssValuePersistence::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  wakeup_.notify_all();
+  writer_.join();
+
+  std::lock_guard<std::mutex> fileLock(fileMutex_);
+  flushLocked(config_.syncPolicy != VssSyncPolicy::NONE);
+  close(fd_);
+  fd_ = -1;
+}
+
+// Needs to be called with fileMutex_ held
+void VssValuePersistence::writeRecords(const std::string &data, bool sync) {
+  if (fd_ < 0 || data.empty()) {
+    return;
+  }
+  if (!writeAll(fd_, data.data(), data.size())) {
+    logger_->Log(LogLevel::ERROR, "VssValuePersistence: Writing " + walPath(generation_).string() + " failed: "
+                 + strerror(errno));
+    return;
+  }
+  walBytes_ += data.size();
+  bytes_ += data.size();
+  if (sync) {
+    fdatasync(fd_);
+    syncs_++;
+  }
+}
+
+// Needs to be called with fileMutex_ held
+void VssValuePersistence::flushLocked(bool sync) {
+  std::string pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending.swap(buffer_);
+  }
+  writeRecords(pending, sync);
+}
+
+void VssValuePersistence::append(const std::string &path, VssAttribute attr, const VssSample &sample) {
+  std::string record;
+  encodeRecord(record, path, attr, sample);
+  records_++;
+
+  bool wakeWriter;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.append(record);
+    wakeWriter = buffer_.size() >= MAX_PENDING_BYTES;
+  }
+  if (wakeWriter) {
+    wakeup_.notify_one();
+  }
+}
+
+void VssValuePersistence::commit() {
+  if (config_.syncPolicy == VssSyncPolicy::ALWAYS) {
+    // records of concurrent sets are written and synced together
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    flushLocked(true);
+  }
+}
+
+void VssValuePersistence::flush() {
+  std::lock_guard<std::mutex> fileLock(fileMutex_);
+  flushLocked(config_.syncPolicy != VssSyncPolicy::NONE);
+}
+
+void VssValuePersistence::compact() {
+  std::lock_guard<std::mutex> compactLock(compactMutex_);
+
+  // Start a new log generation first. The snapshot is taken afterwards, so it
+  // contains everything written to older generations
+  uint64_t firstGeneration;
+  {
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    flushLocked(true);
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    generation_++;
+    openLog();
+    firstGeneration = generation_;
+  }
+
+  std::string content(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  appendRaw<uint64_t>(content, firstGeneration);
+  size_t countOffset = content.size();
+  appendRaw<uint32_t>(content, 0);
+  uint32_t records = 0;
+  if (snapshot_) {
+    snapshot_([&](const std::string &path, VssAttribute attr, const VssSample &sample) {
+      encodeRecord(content, path, attr, sample);
+      records++;
+    });
+  }
+  memcpy(&content[countOffset], &records, sizeof(records));
+
+  boost::filesystem::path tmpPath = snapshotPath();
+  tmpPath += ".tmp";
+  int fd = open(tmpPath.string().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0 || !writeAll(fd, content.data(), content.size()) || fsync(fd) != 0) {
+    logger_->Log(LogLevel::ERROR, "VssValuePersistence: Writing snapshot " + tmpPath.string() + " failed: "
+                 + strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+    }
+    return;
+  }
+  close(fd);
+  boost::filesystem::rename(tmpPath, snapshotPath());
+  syncDirectory(config_.directory);
+
+  for (auto &entry : boost::filesystem::directory_iterator(config_.directory)) {
+    uint64_t generation;
+    if (walGeneration(entry.path().filename().string(), generation) && generation < firstGeneration) {
+      boost::system::error_code ec;
+      boost::filesystem::remove(entry.path(), ec);
+    }
+  }
+  logger_->Log(LogLevel::VERBOSE, "VssValuePersistence: Wrote snapshot with " + std::to_string(records)
+               + " records");
+}
+
+void VssValuePersistence::writerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    wakeup_.wait_for(lock, config_.syncInterval);
+    lock.unlock();
+
+    bool compactionDue;
+    {
+      std::lock_guard<std::mutex> fileLock(fileMutex_);
+      flushLocked(config_.syncPolicy != VssSyncPolicy::NONE);
+      compactionDue = walBytes_ >= config_.compactionThreshold;
+    }
+    if (compactionDue) {
+      compact();
+    }
+
+    lock.lock();
+  }
+}
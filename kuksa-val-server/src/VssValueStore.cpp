@@ -0,0 +1,591 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include "VssValueStore.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "exception.hpp"
+
+using jsoncons::json;
+
+VssDatatype datatypeFromString(const std::string &datatype) {
+  static const std::unordered_map<std::string, VssDatatype> datatypes = {
+    {"boolean", VssDatatype::BOOLEAN},
+    {"uint8", VssDatatype::UINT8},
+    {"int8", VssDatatype::INT8},
+    {"uint16", VssDatatype::UINT16},
+    {"int16", VssDatatype::INT16},
+    {"uint32", VssDatatype::UINT32},
+    {"int32", VssDatatype::INT32},
+    {"uint64", VssDatatype::UINT64},
+    {"int64", VssDatatype::INT64},
+    {"float", VssDatatype::FLOAT},
+    {"double", VssDatatype::DOUBLE},
+    {"string", VssDatatype::STRING},
+    {"boolean[]", VssDatatype::BOOLEAN_ARRAY},
+    {"uint8[]", VssDatatype::UINT8_ARRAY},
+    {"int8[]", VssDatatype::INT8_ARRAY},
+    {"uint16[]", VssDatatype::UINT16_ARRAY},
+    {"int16[]", VssDatatype::INT16_ARRAY},
+    {"uint32[]", VssDatatype::UINT32_ARRAY},
+    {"int32[]", VssDatatype::INT32_ARRAY},
+    {"uint64[]", VssDatatype::UINT64_ARRAY},
+    {"int64[]", VssDatatype::INT64_ARRAY},
+    {"float[]", VssDatatype::FLOAT_ARRAY},
+    {"double[]", VssDatatype::DOUBLE_ARRAY},
+    {"string[]", VssDatatype::STRING_ARRAY},
+  };
+  auto it = datatypes.find(datatype);
+  if (it == datatypes.end()) {
+    return VssDatatype::UNKNOWN;
+  }
+  return it->second;
+}
+
+bool isArrayDatatype(VssDatatype datatype) {
+  return datatype >= VssDatatype::BOOLEAN_ARRAY;
+}
+
+bool isScalarDatatype(VssDatatype datatype) {
+  return datatype != VssDatatype::UNKNOWN && datatype != VssDatatype::STRING && !isArrayDatatype(datatype);
+}
+
+VssDatatype elementDatatype(VssDatatype arrayDatatype) {
+  if (!isArrayDatatype(arrayDatatype)) {
+    return arrayDatatype;
+  }
+  return static_cast<VssDatatype>(static_cast<uint8_t>(arrayDatatype) - static_cast<uint8_t>(VssDatatype::BOOLEAN_ARRAY)
+                                  + static_cast<uint8_t>(VssDatatype::BOOLEAN));
+}
+
+VssDatatype VssValue::arrayOf(VssDatatype datatype) {
+  if (datatype == VssDatatype::UNKNOWN || isArrayDatatype(datatype)) {
+    return datatype;
+  }
+  return static_cast<VssDatatype>(static_cast<uint8_t>(datatype) - static_cast<uint8_t>(VssDatatype::BOOLEAN)
+                                  + static_cast<uint8_t>(VssDatatype::BOOLEAN_ARRAY));
+}
+
+/** Booleans may still be given as "true"/"false" strings inside arrays, as
+ *  the array check of the sanitizer does not rewrite elements */
+static bool boolFromJson(const json &value) {
+  if (value.is_bool()) {
+    return value.as<bool>();
+  }
+  return value.as<std::string>() == "true";
+}
+
+template <typename T>
+static VssValue numArrayFromJson(const json &value) {
+  std::vector<T> elements;
+  elements.reserve(value.size());
+  for (const auto &element : value.array_range()) {
+    elements.push_back(element.as<T>());
+  }
+  return VssValue::fromArray<T>(elements.data(), elements.size());
+}
+
+VssValue VssValue::fromJson(VssDatatype datatype, const json &value) {
+  switch (datatype) {
+    case VssDatatype::BOOLEAN:
+      return fromScalar<bool>(boolFromJson(value));
+    case VssDatatype::UINT8:
+      return fromScalar<uint8_t>(value.as<uint8_t>());
+    case VssDatatype::INT8:
+      return fromScalar<int8_t>(value.as<int8_t>());
+    case VssDatatype::UINT16:
+      return fromScalar<uint16_t>(value.as<uint16_t>());
+    case VssDatatype::INT16:
+      return fromScalar<int16_t>(value.as<int16_t>());
+    case VssDatatype::UINT32:
+      return fromScalar<uint32_t>(value.as<uint32_t>());
+    case VssDatatype::INT32:
+      return fromScalar<int32_t>(value.as<int32_t>());
+    case VssDatatype::UINT64:
+      return fromScalar<uint64_t>(value.as<uint64_t>());
+    case VssDatatype::INT64:
+      return fromScalar<int64_t>(value.as<int64_t>());
+    case VssDatatype::FLOAT:
+      return fromScalar<float>(value.as<float>());
+    case VssDatatype::DOUBLE:
+      return fromScalar<double>(value.as<double>());
+    case VssDatatype::STRING:
+      return fromString(value.as<std::string>());
+    case VssDatatype::BOOLEAN_ARRAY: {
+      // std::vector<bool> is not contiguous, so go through bytes
+      std::vector<unsigned char> elements;
+      elements.reserve(value.size());
+      for (const auto &element : value.array_range()) {
+        elements.push_back(boolFromJson(element) ? 1 : 0);
+      }
+      VssValue v = fromArray<uint8_t>(elements.data(), elements.size());
+      v.datatype_ = VssDatatype::BOOLEAN_ARRAY;
+      return v;
+    }
+    case VssDatatype::UINT8_ARRAY:
+      return numArrayFromJson<uint8_t>(value);
+    case VssDatatype::INT8_ARRAY:
+      return numArrayFromJson<int8_t>(value);
+    case VssDatatype::UINT16_ARRAY:
+      return numArrayFromJson<uint16_t>(value);
+    case VssDatatype::INT16_ARRAY:
+      return numArrayFromJson<int16_t>(value);
+    case VssDatatype::UINT32_ARRAY:
+      return numArrayFromJson<uint32_t>(value);
+    case VssDatatype::INT32_ARRAY:
+      return numArrayFromJson<int32_t>(value);
+    case VssDatatype::UINT64_ARRAY:
+      return numArrayFromJson<uint64_t>(value);
+    case VssDatatype::INT64_ARRAY:
+      return numArrayFromJson<int64_t>(value);
+    case VssDatatype::FLOAT_ARRAY:
+      return numArrayFromJson<float>(value);
+    case VssDatatype::DOUBLE_ARRAY:
+      return numArrayFromJson<double>(value);
+    case VssDatatype::STRING_ARRAY: {
+      std::vector<std::string> elements;
+      elements.reserve(value.size());
+      for (const auto &element : value.array_range()) {
+        elements.push_back(element.as<std::string>());
+      }
+      return fromStringArray(std::move(elements));
+    }
+    case VssDatatype::UNKNOWN:
+      break;
+  }
+  throw genException("Can not store value of unknown datatype");
+}
+
+template <typename T, typename J>
+static json numArrayToJson(const VssValue &value) {
+  json result = json::array();
+  const T *data = value.arrayData<T>();
+  for (size_t i = 0; i < value.arraySize(); i++) {
+    result.push_back(static_cast<J>(data[i]));
+  }
+  return result;
+}
+
+json VssValue::toJson() const {
+  switch (datatype_) {
+    case VssDatatype::BOOLEAN:
+      return json(get<bool>());
+    case VssDatatype::UINT8:
+      return json(static_cast<uint64_t>(get<uint8_t>()));
+    case VssDatatype::INT8:
+      return json(static_cast<int64_t>(get<int8_t>()));
+    case VssDatatype::UINT16:
+      return json(static_cast<uint64_t>(get<uint16_t>()));
+    case VssDatatype::INT16:
+      return json(static_cast<int64_t>(get<int16_t>()));
+    case VssDatatype::UINT32:
+      return json(static_cast<uint64_t>(get<uint32_t>()));
+    case VssDatatype::INT32:
+      return json(static_cast<int64_t>(get<int32_t>()));
+    case VssDatatype::UINT64:
+      return json(get<uint64_t>());
+    case VssDatatype::INT64:
+      return json(get<int64_t>());
+    case VssDatatype::FLOAT:
+      return json(static_cast<double>(get<float>()));
+    case VssDatatype::DOUBLE:
+      return json(get<double>());
+    case VssDatatype::STRING:
+      return json(string_);
+    case VssDatatype::BOOLEAN_ARRAY: {
+      json result = json::array();
+      const uint8_t *data = arrayData<uint8_t>();
+      for (size_t i = 0; i < count_; i++) {
+        result.push_back(data[i] != 0);
+      }
+      return result;
+    }
+    case VssDatatype::UINT8_ARRAY:
+      return numArrayToJson<uint8_t, uint64_t>(*this);
+    case VssDatatype::INT8_ARRAY:
+      return numArrayToJson<int8_t, int64_t>(*this);
+    case VssDatatype::UINT16_ARRAY:
+      return numArrayToJson<uint16_t, uint64_t>(*this);
+    case VssDatatype::INT16_ARRAY:
+      return numArrayToJson<int16_t, int64_t>(*this);
+    case VssDatatype::UINT32_ARRAY:
+      return numArrayToJson<uint32_t, uint64_t>(*this);
+    case VssDatatype::INT32_ARRAY:
+      return numArrayToJson<int32_t, int64_t>(*this);
+    case VssDatatype::UINT64_ARRAY:
+      return numArrayToJson<uint64_t, uint64_t>(*this);
+    case VssDatatype::INT64_ARRAY:
+      return numArrayToJson<int64_t, int64_t>(*this);
+    case VssDatatype::FLOAT_ARRAY:
+      return numArrayToJson<float, double>(*this);
+    case VssDatatype::DOUBLE_ARRAY:
+      return numArrayToJson<double, double>(*this);
+    case VssDatatype::STRING_ARRAY: {
+      json result = json::array();
+      for (const auto &element : strings_) {
+        result.push_back(element);
+      }
+      return result;
+    }
+    case VssDatatype::UNKNOWN:
+      break;
+  }
+  return json(jsoncons::null_type());
+}
+
+size_t VssValue::heapSize() const {
+  size_t bytes = string_.capacity() + packed_.capacity();
+  for (const auto &element : strings_) {
+    bytes += sizeof(std::string) + element.capacity();
+  }
+  return bytes;
+}
+
+template <typename T>
+static void appendRaw(std::string &out, T value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readRaw(const char *&pos, const char *end, T &value) {
+  if (static_cast<size_t>(end - pos) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&value, pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+static bool readString(const char *&pos, const char *end, std::string &value) {
+  uint32_t length;
+  if (!readRaw(pos, end, length) || static_cast<size_t>(end - pos) < length) {
+    return false;
+  }
+  value.assign(pos, length);
+  pos += length;
+  return true;
+}
+
+/** Size of a single element of a numeric or boolean array */
+static size_t packedElementSize(VssDatatype arrayDatatype) {
+  switch (elementDatatype(arrayDatatype)) {
+    case VssDatatype::UINT16:
+    case VssDatatype::INT16:
+      return 2;
+    case VssDatatype::UINT32:
+    case VssDatatype::INT32:
+    case VssDatatype::FLOAT:
+      return 4;
+    case VssDatatype::UINT64:
+    case VssDatatype::INT64:
+    case VssDatatype::DOUBLE:
+      return 8;
+    default:
+      return 1;
+  }
+}
+
+/** Layout: datatype, then 8 bytes for scalars, length and characters for
+ *  strings, element count and elements for arrays */
+void VssValue::serialize(std::string &out) const {
+  appendRaw<uint8_t>(out, static_cast<uint8_t>(datatype_));
+  if (datatype_ == VssDatatype::UNKNOWN) {
+    return;
+  }
+  if (datatype_ == VssDatatype::STRING) {
+    appendRaw<uint32_t>(out, static_cast<uint32_t>(string_.size()));
+    out.append(string_);
+  } else if (datatype_ == VssDatatype::STRING_ARRAY) {
+    appendRaw<uint32_t>(out, static_cast<uint32_t>(strings_.size()));
+    for (const auto &element : strings_) {
+      appendRaw<uint32_t>(out, static_cast<uint32_t>(element.size()));
+      out.append(element);
+    }
+  } else if (isArrayDatatype(datatype_)) {
+    appendRaw<uint32_t>(out, static_cast<uint32_t>(count_));
+    appendRaw<uint32_t>(out, static_cast<uint32_t>(packed_.size()));
+    out.append(reinterpret_cast<const char *>(packed_.data()), packed_.size());
+  } else {
+    out.append(reinterpret_cast<const char *>(scalar_), sizeof(scalar_));
+  }
+}
+
+bool VssValue::deserialize(const char *&pos, const char *end, VssValue &value) {
+  uint8_t datatype;
+  if (!readRaw(pos, end, datatype) || datatype > static_cast<uint8_t>(VssDatatype::STRING_ARRAY)) {
+    return false;
+  }
+  VssValue v;
+  v.datatype_ = static_cast<VssDatatype>(datatype);
+  if (v.datatype_ == VssDatatype::STRING) {
+    if (!readString(pos, end, v.string_)) {
+      return false;
+    }
+  } else if (v.datatype_ == VssDatatype::STRING_ARRAY) {
+    uint32_t count;
+    if (!readRaw(pos, end, count)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      std::string element;
+      if (!readString(pos, end, element)) {
+        return false;
+      }
+      v.strings_.push_back(std::move(element));
+    }
+    v.count_ = count;
+  } else if (isArrayDatatype(v.datatype_)) {
+    uint32_t count, bytes;
+    if (!readRaw(pos, end, count) || !readRaw(pos, end, bytes) || static_cast<size_t>(end - pos) < bytes ||
+        bytes != count * packedElementSize(v.datatype_)) {
+      return false;
+    }
+    v.count_ = count;
+    v.packed_.assign(pos, pos + bytes);
+    pos += bytes;
+  } else if (v.datatype_ != VssDatatype::UNKNOWN) {
+    if (static_cast<size_t>(end - pos) < sizeof(v.scalar_)) {
+      return false;
+    }
+    memcpy(v.scalar_, pos, sizeof(v.scalar_));
+    pos += sizeof(v.scalar_);
+  }
+  value = std::move(v);
+  return true;
+}
+
+bool attributeFromString(const std::string &attr, VssAttribute &attribute) {
+  if (attr == "value") {
+    attribute = VssAttribute::VALUE;
+    return true;
+  }
+  if (attr == "targetValue") {
+    attribute = VssAttribute::TARGET_VALUE;
+    return true;
+  }
+  return false;
+}
+
+VssSignalHistory::VssSignalHistory(VssDatatype datatype, size_t capacity) : timestamps_(std::max<size_t>(capacity, 1)) {
+  reset(datatype);
+}
+
+void VssSignalHistory::reset(VssDatatype datatype) {
+  datatype_ = datatype;
+  head_ = 0;
+  count_ = 0;
+  if (isScalarDatatype(datatype)) {
+    scalars_.assign(timestamps_.size(), 0);
+    values_.clear();
+    values_.shrink_to_fit();
+  } else {
+    scalars_.clear();
+    scalars_.shrink_to_fit();
+    values_.assign(timestamps_.size(), VssValue());
+  }
+}
+
+void VssSignalHistory::append(const VssSample &sample) {
+  std::lock_guard<std::mutex> lock_guard(mutex_);
+  if (sample.value.datatype() != datatype_) {
+    reset(sample.value.datatype());
+  }
+  uint64_t ts = sample.ts_s * 1000000000ull + sample.ts_ns;
+  if (count_ > 0) {
+    // concurrent setters or a clock stepping back may deliver older samples,
+    // they are recorded as of the newest one, so the buffer stays sorted
+    ts = std::max(ts, timestamps_[(head_ + timestamps_.size() - 1) % timestamps_.size()]);
+  }
+  timestamps_[head_] = ts;
+  if (isScalarDatatype(datatype_)) {
+    scalars_[head_] = sample.value.scalarBits();
+  } else {
+    values_[head_] = sample.value;
+  }
+  head_ = (head_ + 1) % timestamps_.size();
+  if (count_ < timestamps_.size()) {
+    count_++;
+  }
+}
+
+std::vector<VssSample> VssSignalHistory::query(uint64_t from_ns, uint64_t to_ns) const {
+  std::lock_guard<std::mutex> lock_guard(mutex_);
+  // binary search for the oldest sample not before from_ns
+  size_t low = 0, high = count_;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (timestamps_[slotIndex(mid)] < from_ns) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  std::vector<VssSample> samples;
+  bool scalar = isScalarDatatype(datatype_);
+  for (size_t i = low; i < count_; i++) {
+    size_t index = slotIndex(i);
+    uint64_t ts = timestamps_[index];
+    if (ts > to_ns) {
+      break;
+    }
+    VssSample sample;
+    sample.value = scalar ? VssValue::fromScalarBits(datatype_, scalars_[index]) : values_[index];
+    sample.ts_s = ts / 1000000000ull;
+    sample.ts_ns = ts % 1000000000ull;
+    samples.push_back(std::move(sample));
+  }
+  return samples;
+}
+
+size_t VssSignalHistory::size() const {
+  std::lock_guard<std::mutex> lock_guard(mutex_);
+  return count_;
+}
+
+size_t VssSignalHistory::memoryFootprint() const {
+  std::lock_guard<std::mutex> lock_guard(mutex_);
+  size_t bytes = sizeof(VssSignalHistory) + timestamps_.capacity() * sizeof(uint64_t)
+                 + scalars_.capacity() * sizeof(uint64_t) + values_.capacity() * sizeof(VssValue);
+  for (const auto &value : values_) {
+    bytes += value.heapSize();
+  }
+  return bytes;
+}
+
+bool VssSignalSlot::load(VssAttribute attr, VssSample &sample) const {
+  const Cell &cell = cells_[static_cast<size_t>(attr)];
+  VssDatatype datatype;
+  uint64_t bits;
+  std::shared_ptr<const VssValue> value;
+  for (;;) {
+    uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      // a store is in progress, it only takes a few instructions
+      std::this_thread::yield();
+      continue;
+    }
+    datatype = cell.datatype.load(std::memory_order_relaxed);
+    bits = cell.scalarBits.load(std::memory_order_relaxed);
+    sample.ts_s = cell.ts_s.load(std::memory_order_relaxed);
+    sample.ts_ns = cell.ts_ns.load(std::memory_order_relaxed);
+    if (datatype != VssDatatype::UNKNOWN && !isScalarDatatype(datatype)) {
+      PointerGuard guard(pointerLock_);
+      value = cell.value;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (cell.sequence.load(std::memory_order_relaxed) == sequence) {
+      break;
+    }
+  }
+  if (datatype == VssDatatype::UNKNOWN) {
+    return false;
+  }
+  sample.value = value ? *value : VssValue::fromScalarBits(datatype, bits);
+  return true;
+}
+
+void VssSignalSlot::store(VssAttribute attr, const VssSample &sample, const CommitFunc &committed) {
+  Cell &cell = cells_[static_cast<size_t>(attr)];
+  VssDatatype datatype = sample.value.datatype();
+  // allocated before and released after the locks
+  std::shared_ptr<const VssValue> value;
+  if (datatype != VssDatatype::UNKNOWN && !isScalarDatatype(datatype)) {
+    value = std::make_shared<const VssValue>(sample.value);
+  }
+
+  std::lock_guard<std::mutex> lock_guard(storeMutex_);
+  uint64_t sequence = cell.sequence.load(std::memory_order_relaxed);
+  cell.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  cell.datatype.store(datatype, std::memory_order_relaxed);
+  cell.scalarBits.store(value ? 0 : sample.value.scalarBits(), std::memory_order_relaxed);
+  cell.ts_s.store(sample.ts_s, std::memory_order_relaxed);
+  cell.ts_ns.store(sample.ts_ns, std::memory_order_relaxed);
+  if (value || cell.value) {
+    PointerGuard guard(pointerLock_);
+    cell.value.swap(value);
+  }
+  cell.sequence.store(sequence + 2, std::memory_order_release);
+
+  if (attr == VssAttribute::VALUE && history_) {
+    history_->append(sample);
+  }
+  if (committed) {
+    committed(sample);
+  }
+}
+
+std::shared_ptr<VssSignalHistory> VssSignalSlot::history() const {
+  PointerGuard guard(pointerLock_);
+  return history_;
+}
+
+void VssSignalSlot::setHistory(std::shared_ptr<VssSignalHistory> history) {
+  std::lock_guard<std::mutex> lock_guard(storeMutex_);
+  PointerGuard guard(pointerLock_);
+  history_.swap(history);
+}
+
+std::shared_ptr<VssSignalSlot> VssValueStore::getOrCreateSlot(const std::string &path, VssDatatype datatype) {
+  auto &slot = slots_[path];
+  if (!slot) {
+    slot = std::make_shared<VssSignalSlot>(datatype);
+  } else {
+    slot->setDatatype(datatype);
+  }
+  return slot;
+}
+
+std::shared_ptr<VssSignalSlot> VssValueStore::findSlot(const std::string &path) const {
+  auto it = slots_.find(path);
+  if (it == slots_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void VssValueStore::forEachSlot(const std::function<void(const std::string &, const VssSignalSlot &)> &func) const {
+  for (const auto &entry : slots_) {
+    func(entry.first, *entry.second);
+  }
+}
+
+size_t VssValueStore::memoryFootprint() const {
+  size_t bytes = 0;
+  for (const auto &entry : slots_) {
+    bytes += entry.first.capacity() + sizeof(entry) + sizeof(VssSignalSlot);
+    for (auto attr : {VssAttribute::VALUE, VssAttribute::TARGET_VALUE}) {
+      VssSample sample;
+      if (entry.second->load(attr, sample)) {
+        bytes += sample.value.heapSize();
+      }
+    }
+    auto history = entry.second->history();
+    if (history) {
+      bytes += history->memoryFootprint();
+    }
+  }
+  return bytes;
+}
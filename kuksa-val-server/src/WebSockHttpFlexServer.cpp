@@ -45,12 +45,14 @@
 #include <regex>
 #include <stdexcept>
 #include <list>
+#include <array>
 
 #include "ssl_stream.hpp"
 
 #include "WebSockHttpFlexServer.hpp"
 
 #include "IVssCommandProcessor.hpp"
+#include "JsonResponses.hpp"
 #include "KuksaChannel.hpp"
 #include "ILogger.hpp"
 
@@ -68,6 +70,8 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
   class SslHttpSession;
   class BeastListener;
 
+  void logAccessCacheStats(const KuksaChannel &channel);
+
 /**
  * @class ConnectionHandler
  * @brief Helper class to handle connection between \ref KuksaChannel and actual sessions
@@ -164,7 +168,11 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
        */
       void RemoveClient(const PlainWebsocketSession * session) {
         std::lock_guard<std::mutex> lock(mPlainWebSock_);
-        connPlainWebSock_.erase(session);
+        auto conn = connPlainWebSock_.find(session);
+        if (conn != connPlainWebSock_.end()) {
+          logAccessCacheStats(*conn->second);
+          connPlainWebSock_.erase(conn);
+        }
       }
 
       /**
@@ -173,7 +181,11 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
        */
       void RemoveClient(const SslWebsocketSession * session) {
         std::lock_guard<std::mutex> lock(mSslWebSock_);
-        connSslWebSock_.erase(session);
+        auto conn = connSslWebSock_.find(session);
+        if (conn != connSslWebSock_.end()) {
+          logAccessCacheStats(*conn->second);
+          connSslWebSock_.erase(conn);
+        }
       }
 
       /**
@@ -208,6 +220,16 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
 
   std::shared_ptr<ILogger> logger;
 
+  /// Report how many access checks of a closed connection were cached
+  void logAccessCacheStats(const KuksaChannel &channel) {
+    const VssAccessCache *cache = channel.getAccessCache();
+    if (cache == nullptr) {
+      return;
+    }
+    logger->Log(LogLevel::VERBOSE, "Access cache of connection " + std::to_string(channel.getConnID()) + ": " +
+                cache->stats().toString() + ", released caches: " + VssAccessCache::totalStats().toString());
+  }
+
   const unsigned DEFAULT_TIMEOUT_VALUE   = std::numeric_limits<unsigned int>::max();   // in seconds
   const unsigned WEBSOCKET_TIMEOUT_VALUE = DEFAULT_TIMEOUT_VALUE;
   const unsigned HTTP_TIMEOUT_VALUE      = DEFAULT_TIMEOUT_VALUE;
@@ -249,7 +271,6 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       }
 
       boost::beast::multi_buffer bufferRead_;
-      boost::beast::multi_buffer bufferWrite_;
       char ping_state_ = 0;
 
       mutable std::mutex queueMutex;
@@ -260,7 +281,21 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
       boost::asio::steady_timer timer_;
       RequestHandler requestHandler_;
       KuksaChannel channel;
-      std::list<std::string> writeQueue_;
+      // A queued message is either text, or a message shared with other
+      // sessions, which is sent with the subscriptionId in text spliced in.
+      // Messages are written from here, without copying them
+      struct OutgoingMessage {
+        std::string text;
+        std::shared_ptr<const SharedMessage> shared;
+
+        std::array<boost::asio::const_buffer, 3> buffers() const {
+          if (!shared) {
+            return {boost::asio::buffer(text), boost::asio::const_buffer(), boost::asio::const_buffer()};
+          }
+          return {boost::asio::buffer(shared->head), boost::asio::buffer(text), boost::asio::buffer(shared->tail)};
+        }
+      };
+      std::list<OutgoingMessage> writeQueue_;
     public:
       // Construct the session
       explicit WebSocketSession(boost::asio::io_context& ioc,
@@ -437,16 +472,46 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         bufferRead_.consume(bytesTransferred); // clear existing buffer data
 
         // send response
-        write(response);
+        write(std::move(response));
 
         // do another read
         doRead();
       }
 
-      void write(const std::string &message) {
+      size_t pendingWrites() const {
         std::unique_lock<std::mutex> lock(queueMutex);
+        return writeQueue_.size();
+      }
 
-        writeQueue_.push_back(message);
+      // Closes the connection from any thread, without waiting for a client
+      // which does not read
+      void disconnect() {
+        boost::asio::post(
+            strand_,
+            std::bind(
+                &WebSocketSession::onDisconnect,
+                derived().shared_from_this()));
+      }
+
+      void onDisconnect() {
+        connHandler.RemoveClient(&derived());
+        // aborts the pending read and writes, their handlers release the session
+        timer_.cancel();
+        derived().closeSocket();
+      }
+
+      void write(std::string message) {
+        enqueue(OutgoingMessage{std::move(message), nullptr});
+      }
+
+      void write(std::shared_ptr<const SharedMessage> message, const std::string &subscriptionId) {
+        enqueue(OutgoingMessage{subscriptionId, std::move(message)});
+      }
+
+      void enqueue(OutgoingMessage message) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+
+        writeQueue_.push_back(std::move(message));
 
         // there can be only one async_write request at any single time,
         // so queue additional transfers
@@ -454,12 +519,14 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return;
         }
 
-        boost::asio::buffer_copy(bufferWrite_.prepare(message.size()), boost::asio::buffer(message));
-        bufferWrite_.commit(message.size()); // commit copied data for write
+        writeFront();
+      }
 
+      // queueMutex needs to be held
+      void writeFront() {
         // send message
         derived().ws().async_write(
-            bufferWrite_.data(),
+            writeQueue_.front().buffers(),
             boost::asio::bind_executor(
                 strand_,
                 std::bind(
@@ -469,7 +536,7 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
                     std::placeholders::_2)));
       }
 
-      void onWrite(boost::system::error_code ec, std::size_t bytesTransferred) {
+      void onWrite(boost::system::error_code ec, std::size_t /*bytesTransferred*/) {
         // Happens when the timer closes the socket
         if(ec == boost::asio::error::operation_aborted)
           return;
@@ -479,29 +546,13 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
           return;
         }
 
-        // Clear the buffer
-        bufferWrite_.consume(bytesTransferred);
-
         std::unique_lock<std::mutex> lock(queueMutex);
 
         writeQueue_.pop_front();
 
         // check if there is more to write
         if (!writeQueue_.empty()) {
-          auto message = writeQueue_.front();
-          boost::asio::buffer_copy(bufferWrite_.prepare(message.size()), boost::asio::buffer(message));
-          bufferWrite_.commit(message.size()); // commit copied data for write
-
-          // send message
-          derived().ws().async_write(
-              bufferWrite_.data(),
-              boost::asio::bind_executor(
-                  strand_,
-                  std::bind(
-                      &WebSocketSession::onWrite,
-                      derived().shared_from_this(),
-                      std::placeholders::_1,
-                      std::placeholders::_2)));
+          writeFront();
         }
       }
   };
@@ -524,6 +575,12 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         return ws_;
       }
 
+      // Called by the base class
+      void closeSocket() {
+        boost::system::error_code ec;
+        ws_.next_layer().close(ec);
+      }
+
       // Start the asynchronous operation
       template<class Body, class Allocator>
       void run(http::request<Body, http::basic_fields<Allocator>> req) {
@@ -595,6 +652,12 @@ namespace websocket = boost::beast::websocket;  // from <boost/beast/websocket.h
         return ws_;
       }
 
+      // Called by the base class
+      void closeSocket() {
+        boost::system::error_code ec;
+        ws_.next_layer().next_layer().close(ec);
+      }
+
       // Start the asynchronous operation
       template<class Body, class Allocator>
       void run(http::request<Body, http::basic_fields<Allocator>> req) {
@@ -1280,7 +1343,7 @@ std::string WebSockHttpFlexServer::HandleRequest(const std::string &req_json, Ku
     }
   }
 
-  return response.as<std::string>();
+  return JsonResponses::serialize(response);
 }
 
 void WebSockHttpFlexServer::AddListener(ObserverType type,
@@ -1428,6 +1491,75 @@ bool WebSockHttpFlexServer::SendToConnection(ConnectionId connID, const std::str
   return isFound;
 }
 
+bool WebSockHttpFlexServer::SendSharedToConnection(ConnectionId connID,
+                                                   std::shared_ptr<const SharedMessage> message,
+                                                   const std::string &subscriptionId) {
+  {
+    auto session = reinterpret_cast<PlainWebsocketSession *>(connID);
+    std::lock_guard<std::mutex> lock(connHandler.mPlainWebSock_);
+    auto iter = connHandler.connPlainWebSock_.find(session);
+    if (iter != std::end(connHandler.connPlainWebSock_)) {
+      session->write(std::move(message), subscriptionId);
+      return true;
+    }
+  }
+  {
+    auto session = reinterpret_cast<SslWebsocketSession *>(connID);
+    std::lock_guard<std::mutex> lock(connHandler.mSslWebSock_);
+    auto iter = connHandler.connSslWebSock_.find(session);
+    if (iter != std::end(connHandler.connSslWebSock_)) {
+      session->write(std::move(message), subscriptionId);
+      return true;
+    }
+  }
+  // no websocket session, let SendToConnection deal with it
+  return SendToConnection(connID, message->head + subscriptionId + message->tail);
+}
+
+size_t WebSockHttpFlexServer::PendingWrites(ConnectionId connID) {
+  {
+    auto session = reinterpret_cast<PlainWebsocketSession *>(connID);
+    std::lock_guard<std::mutex> lock(connHandler.mPlainWebSock_);
+    auto iter = connHandler.connPlainWebSock_.find(session);
+    if (iter != std::end(connHandler.connPlainWebSock_)) {
+      return session->pendingWrites();
+    }
+  }
+  {
+    auto session = reinterpret_cast<SslWebsocketSession *>(connID);
+    std::lock_guard<std::mutex> lock(connHandler.mSslWebSock_);
+    auto iter = connHandler.connSslWebSock_.find(session);
+    if (iter != std::end(connHandler.connSslWebSock_)) {
+      return session->pendingWrites();
+    }
+  }
+  // HTTP responses are not queued
+  return 0;
+}
+
+void WebSockHttpFlexServer::CloseConnection(ConnectionId connID) {
+  {
+    auto session = reinterpret_cast<PlainWebsocketSession *>(connID);
+    std::lock_guard<std::mutex> lock(connHandler.mPlainWebSock_);
+    auto iter = connHandler.connPlainWebSock_.find(session);
+    if (iter != std::end(connHandler.connPlainWebSock_)) {
+      logger_->Log(LogLevel::INFO, "Closing connection " + std::to_string(connID));
+      session->disconnect();
+      return;
+    }
+  }
+  {
+    auto session = reinterpret_cast<SslWebsocketSession *>(connID);
+    std::lock_guard<std::mutex> lock(connHandler.mSslWebSock_);
+    auto iter = connHandler.connSslWebSock_.find(session);
+    if (iter != std::end(connHandler.connSslWebSock_)) {
+      logger_->Log(LogLevel::INFO, "Closing connection " + std::to_string(connID));
+      session->disconnect();
+      return;
+    }
+  }
+}
+
 void WebSockHttpFlexServer::Start() {
   if (!isInitialized)
   {
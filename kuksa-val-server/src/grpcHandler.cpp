@@ -30,6 +30,7 @@
 #include "ILogger.hpp"
 #include "IVssDatabase.hpp"
 #include "SubscriptionHandler.hpp"
+#include "VssGrpcStreamWriter.hpp"
 
 using namespace std;
 using grpc::Channel;
@@ -46,47 +47,51 @@ using kuksa::SubscribeResponse;
 grpcHandler handler;
 
 // Helper functions
-void grpcHandler::grpc_send_object_to_stream(
-    std::shared_ptr<ILogger> logger, const std::string& vssdatatype,
-    const jsoncons::json& data,
-    grpc::ServerReaderWriter<kuksa::SubscribeResponse, kuksa::SubscribeRequest>*
-        stream) {
-  SubscribeResponse resp;
-  resp.mutable_status()->set_statuscode(200);
-  grpcHandler::grpc_fill_value(logger, vssdatatype, data,
-                               resp.mutable_values());
-  try {
-    stream->Write(resp);
-  } catch (std::exception& e) {
-    logger->Log(LogLevel::WARNING,
-                "Error pushing data to GRPC subscriber: " + string(e.what()));
-  }
+void grpcHandler::grpc_fill_subscribe_response(const std::string& vssdatatype,
+                                               const jsoncons::json& signal,
+                                               SubscribeResponse* resp) {
+  resp->mutable_status()->set_statuscode(200);
+  grpcHandler::grpc_fill_signal(vssdatatype, signal, resp->mutable_values());
 }
 
 void grpcHandler::grpc_fill_value(
     [[maybe_unused]] std::shared_ptr<ILogger> logger,
     const std::string& vssdatatype, const jsoncons::json& data,
     kuksa::Value* grpcvalue, const std::string& attr) {
+  grpcHandler::grpc_fill_signal(vssdatatype, data["data"], grpcvalue, attr);
+}
+
+// Fills path (or id) and value of a single signal given as {"path": ..., "dp": ...}
+void grpcHandler::grpc_fill_signal(const std::string& vssdatatype,
+                                   const jsoncons::json& signal,
+                                   kuksa::Value* grpcvalue,
+                                   const std::string& attr) {
+  const jsoncons::json& dp = signal["dp"];
   if ((vssdatatype == "uint8") || (vssdatatype == "uint16") ||
       (vssdatatype == "uint32")) {
-    grpcvalue->set_valueuint32(data["data"]["dp"][attr].as<uint32_t>());
+    grpcvalue->set_valueuint32(dp[attr].as<uint32_t>());
   } else if ((vssdatatype == "int8") || (vssdatatype == "int16") ||
              (vssdatatype == "int32")) {
-    grpcvalue->set_valueint32(data["data"]["dp"][attr].as<int32_t>());
+    grpcvalue->set_valueint32(dp[attr].as<int32_t>());
   } else if (vssdatatype == "uint64") {
-    grpcvalue->set_valueuint64(data["data"]["dp"][attr].as<uint64_t>());
+    grpcvalue->set_valueuint64(dp[attr].as<uint64_t>());
   } else if (vssdatatype == "int64") {
-    grpcvalue->set_valueint64(data["data"]["dp"][attr].as<int64_t>());
+    grpcvalue->set_valueint64(dp[attr].as<int64_t>());
   } else if (vssdatatype == "float") {
-    grpcvalue->set_valuefloat(data["data"]["dp"][attr].as<float>());
+    grpcvalue->set_valuefloat(dp[attr].as<float>());
   } else if (vssdatatype == "double") {
-    grpcvalue->set_valuedouble(data["data"]["dp"][attr].as<double>());
+    grpcvalue->set_valuedouble(dp[attr].as<double>());
   } else if (vssdatatype == "boolean") {
-    grpcvalue->set_valuebool(data["data"]["dp"][attr].as<bool>());
+    grpcvalue->set_valuebool(dp[attr].as<bool>());
   } else {  // Treat as a string
-    grpcvalue->set_valuestring(data["data"]["dp"][attr].as<string>());
+    grpcvalue->set_valuestring(dp[attr].as<string>());
+  }
+  // signals requested by id are identified by their id only
+  if (signal.contains("id")) {
+    grpcvalue->set_id(signal["id"].as<uint32_t>());
+  } else {
+    grpcvalue->set_path(signal["path"].as<std::string>());
   }
-  grpcvalue->set_path(data["data"]["path"].as<std::string>());
 }
 
 // class for reading certificates
@@ -275,7 +280,8 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     }
 
     // Return if no paths are given
-    if (request->path().size() == 0) {
+    int requested = request->path().size() + request->id().size();
+    if (requested == 0) {
       reply->mutable_status()->set_statuscode(400);
       reply->mutable_status()->set_statusdescription("No valid path found.");
       return Status::OK;
@@ -297,21 +303,28 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
 
     bool singleFailure = false;
 
-    for (int i = 0; i < request->path().size(); i++) {
+    if (request->type() != kuksa::RequestType::METADATA) {
+      // All paths are read at once, so the values belong together
       req_json["requestId"] =
           boost::uuids::to_string(boost::uuids::random_generator()());
-      req_json["path"] = request->path()[i];
+      if (request->path().size() > 0) {
+        jsoncons::json paths = jsoncons::json::array();
+        for (int i = 0; i < request->path().size(); i++) {
+          paths.push_back(request->path()[i]);
+        }
+        req_json["paths"] = std::move(paths);
+      }
+      if (request->id().size() > 0) {
+        jsoncons::json ids = jsoncons::json::array();
+        for (int i = 0; i < request->id().size(); i++) {
+          ids.push_back(request->id()[i]);
+        }
+        req_json["ids"] = std::move(ids);
+      }
 
       try {
         auto Processor = handler.getGrpcProcessor();
-        std::string result;
-        jsoncons::json resJson;
-        if (request->type() != kuksa::RequestType::METADATA) {
-          resJson = Processor->processGet(*kc, req_json);
-        } else {
-          resJson = Processor->processGetMetaData(req_json);
-        }
-
+        jsoncons::json resJson = Processor->processGet(*kc, req_json);
         if (resJson.contains("error")) {  // Failure Case
           uint32_t code = resJson["error"]["number"].as<unsigned int>();
           std::string reason = resJson["error"]["reason"].as_string() + " " +
@@ -320,39 +333,56 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
           reply->mutable_status()->set_statusdescription(reason);
           singleFailure = true;
         } else {  // Success Case
-          auto val = reply->add_values();
-          if (request->type() != kuksa::RequestType::METADATA) {
-            string datatype;
-            try {
-              datatype = database->getDatatypeForPath(
-                  VSSPath::fromVSS(request->path()[i]));
-              stringstream ss;
-              ss << "Datatype for " << request->path()[i] << " is " << datatype;
-              logger->Log(LogLevel::INFO, ss.str());
-            } catch (std::exception& e) {
-              stringstream ss;
-              ss << "Error getting datatype for " << request->path()[i] << ": "
-                 << e.what();
-              logger->Log(LogLevel::WARNING, ss.str());
-            }
-
-            grpcHandler::grpc_fill_value(logger, datatype, resJson, val, attr);
-
+          for (const auto& signal : resJson["data"].array_range()) {
+            auto val = reply->add_values();
+            grpcHandler::grpc_fill_signal(
+                signal.get_with_default<std::string>("datatype", ""), signal,
+                val, attr);
             val->mutable_timestamp()->set_seconds(
-                resJson["data"]["dp"]["ts_s"].as<uint64_t>());
+                signal["dp"]["ts_s"].as<uint64_t>());
             val->mutable_timestamp()->set_nanos(
-                resJson["data"]["dp"]["ts_ns"].as<uint32_t>());
-          } else {
-            val->set_valuestring(resJson["metadata"].as_string());
+                signal["dp"]["ts_ns"].as<uint32_t>());
           }
         }
       } catch (std::exception& e) {
         singleFailure = true;
         logger->Log(LogLevel::ERROR, e.what());
       }
+    } else {
+      for (int i = 0; i < requested; i++) {
+        req_json["requestId"] =
+            boost::uuids::to_string(boost::uuids::random_generator()());
+
+        try {
+          if (i < request->path().size()) {
+            req_json["path"] = request->path()[i];
+          } else {
+            req_json["path"] =
+                VSSPath::fromId(request->id()[i - request->path().size()])
+                    .getVSSPath();
+          }
+          auto Processor = handler.getGrpcProcessor();
+          jsoncons::json resJson = Processor->processGetMetaData(req_json);
+
+          if (resJson.contains("error")) {  // Failure Case
+            uint32_t code = resJson["error"]["number"].as<unsigned int>();
+            std::string reason = resJson["error"]["reason"].as_string() + " " +
+                                 resJson["error"]["message"].as_string();
+            reply->mutable_status()->set_statuscode(code);
+            reply->mutable_status()->set_statusdescription(reason);
+            singleFailure = true;
+          } else {  // Success Case
+            auto val = reply->add_values();
+            val->set_valuestring(resJson["metadata"].as_string());
+          }
+        } catch (std::exception& e) {
+          singleFailure = true;
+          logger->Log(LogLevel::ERROR, e.what());
+        }
+      }
     }
 
-    if (singleFailure && request->path().size() > 1) {
+    if (singleFailure && requested > 1) {
       reply->mutable_status()->set_statuscode(400);
       reply->mutable_status()->set_statusdescription(
           "One or more paths could not be resolved. Try individual requests.");
@@ -394,38 +424,65 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
         attr = "value";
       }
       req_json["attribute"] = attr;
+      req_json["requestId"] =
+          boost::uuids::to_string(boost::uuids::random_generator()());
       bool singleFailure = false;
 
+      // All values of one request are set as one batch, so either all of
+      // them are applied or none is.
+      jsoncons::json values = jsoncons::json::array();
       for (int i = 0; i < request->values().size(); i++) {
         auto val = request->values()[i];
-        req_json["requestId"] =
-            boost::uuids::to_string(boost::uuids::random_generator()());
-        req_json["path"] = val.path();
+        jsoncons::json entry;
 
         try {
-          std::string datatype =
-              database->getDatatypeForPath(VSSPath::fromVSS(val.path()));
+          VSSPath path = VSSPath::fromVSS(val.path());
+          if (val.id() != 0) {
+            path = VSSPath::fromId(val.id());
+            entry["id"] = val.id();
+          } else {
+            entry["path"] = val.path();
+          }
+          std::string datatype = database->getDatatypeForPath(path);
 
           if ((datatype == "uint8") || (datatype == "uint16") ||
               (datatype == "uint32")) {
-            req_json[attr] = val.valueuint32();
+            entry[attr] = val.valueuint32();
           } else if ((datatype == "int8") || (datatype == "int16") ||
                      (datatype == "int32")) {
-            req_json[attr] = val.valueint32();
+            entry[attr] = val.valueint32();
           } else if (datatype == "uint64") {
-            req_json[attr] = val.valueuint64();
+            entry[attr] = val.valueuint64();
           } else if (datatype == "int64") {
-            req_json[attr] = val.valueint64();
+            entry[attr] = val.valueint64();
           } else if (datatype == "float") {
-            req_json[attr] = val.valuefloat();
+            entry[attr] = val.valuefloat();
           } else if (datatype == "double") {
-            req_json[attr] = val.valuedouble();
+            entry[attr] = val.valuedouble();
           } else if (datatype == "boolean") {
-            req_json[attr] = val.valuebool();
+            entry[attr] = val.valuebool();
           } else {  // Treat as a string
-            req_json[attr] = val.valuestring();
+            entry[attr] = val.valuestring();
           }
+          values.push_back(std::move(entry));
+        } catch (std::exception& e) {
+          singleFailure = true;
+          logger->Log(LogLevel::ERROR, e.what());
+        }
+      }
 
+      if (!singleFailure && !values.empty()) {
+        if (values.size() == 1) {
+          if (values[0].contains("id")) {
+            req_json["id"] = values[0]["id"];
+          } else {
+            req_json["path"] = values[0]["path"];
+          }
+          req_json[attr] = values[0][attr];
+        } else {
+          req_json["values"] = std::move(values);
+        }
+        try {
           auto Processor = handler.getGrpcProcessor();
           auto resJson = Processor->processSet(*kc, req_json);
           if (resJson.contains("error")) {  // Failure Case
@@ -435,10 +492,6 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
             reply->mutable_status()->set_statuscode(code);
             reply->mutable_status()->set_statusdescription(reason);
             singleFailure = true;
-          } else {  // Success Case
-            reply->mutable_status()->set_statuscode(200);
-            reply->mutable_status()->set_statusdescription(
-                "Set request successfully processed");
           }
         } catch (std::exception& e) {
           singleFailure = true;
@@ -449,8 +502,8 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
       if (singleFailure && request->values().size() > 1) {
         reply->mutable_status()->set_statuscode(400);
         reply->mutable_status()->set_statusdescription(
-            "One or more paths could not be resolved. Try individual "
-            "requests.");
+            "One or more paths could not be set. None of the values "
+            "was applied.");
       } else if (!singleFailure) {
         reply->mutable_status()->set_statuscode(200);
         reply->mutable_status()->set_statusdescription(
@@ -479,6 +532,10 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
       stream->Write(response);
       return Status::OK;
     }
+    // notifications are written by the thread of the writer, responses to
+    // requests go through it too, so writes to the stream do not overlap
+    auto writer = std::make_shared<VssGrpcStreamWriter>(logger, stream, context);
+    kc->grpcWriter = writer;
 
     jsoncons::json req_json, resp_json;
     std::unordered_map<subscription_keys_t, std::string, SubscriptionKeyHasher>
@@ -488,6 +545,7 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     while (stream->Read(&request)) {
       auto Processor = handler.getGrpcProcessor();
       // Create appropriate subscribe request
+      req_json = jsoncons::json();
       auto uuid = boost::uuids::random_generator()();
       req_json["requestId"] = boost::uuids::to_string(uuid);
 
@@ -495,7 +553,11 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
       if (subscribe) {  // Send a subscribe request
         req_json["action"] = "subscribe";
         auto path = request.path();
-        req_json["path"] = path;
+        if (request.id() != 0) {
+          req_json["id"] = request.id();
+        } else {
+          req_json["path"] = path;
+        }
         auto iter = AttributeStringMap.find(request.type());
         std::string attr;
         if (iter != AttributeStringMap.end()) {
@@ -514,14 +576,17 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
                                  resp_json["error"]["message"].as_string();
             response.mutable_status()->set_statuscode(code);
             response.mutable_status()->set_statusdescription(reason);
-            stream->Write(response);
+            writer->writeNow(response);
           } else {  // Success Case
             response.mutable_status()->set_statuscode(200);
             response.mutable_status()->set_statusdescription(
                 "Subscribe request successfully processed");
-            stream->Write(response);
+            writer->writeNow(response);
 
-            subscription_keys_t key = subscription_keys_t(path, attr);
+            subscription_keys_t key = subscription_keys_t(
+                request.id() != 0 ? VSSPath::fromId(request.id())
+                                  : VSSPath::fromVSS(path),
+                attr);
             currentSubs[key] = resp_json["subscriptionId"].as_string();
             auto subsMap = (kc->grpcSubsMap).get();
             auto id = boost::uuids::string_generator()(
@@ -544,8 +609,17 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
         }
 
         // Check if the path to unsubscribe exists
-        subscription_keys_t key = subscription_keys_t(request.path(), attr);
-        if (currentSubs.find(key) !=
+        VSSPath unsubscribePath = VSSPath::fromVSS(request.path());
+        bool knownPath = true;
+        if (request.id() != 0) {
+          try {
+            unsubscribePath = VSSPath::fromId(request.id());
+          } catch (std::out_of_range&) {
+            knownPath = false;
+          }
+        }
+        subscription_keys_t key = subscription_keys_t(unsubscribePath, attr);
+        if (knownPath && currentSubs.find(key) !=
             currentSubs.end()) {  // Path is currently subscribed
           req_json["subscriptionId"] = currentSubs[key];
           resp_json = Processor->processUnsubscribe(*kc, req_json);
@@ -556,7 +630,7 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
                                  resp_json["error"]["message"].as_string();
             response.mutable_status()->set_statuscode(code);
             response.mutable_status()->set_statusdescription(reason);
-            stream->Write(response);
+            writer->writeNow(response);
           } else {  // Success Case
             auto subsMap = (kc->grpcSubsMap).get();
             subsMap->erase(boost::uuids::string_generator()(currentSubs[key]));
@@ -565,13 +639,13 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
             response.mutable_status()->set_statuscode(200);
             response.mutable_status()->set_statusdescription(
                 "Unsubscribe request successfully processed");
-            stream->Write(response);
+            writer->writeNow(response);
           }
         } else {  // Path is not subscribed. So unsubscribe wont work.
           response.mutable_status()->set_statuscode(400);
           response.mutable_status()->set_statusdescription(
               "Subscribe request error. No valid subscription existed");
-          stream->Write(response);
+          writer->writeNow(response);
         }
       }
 
@@ -588,8 +662,143 @@ class RequestServiceImpl final : public kuksa_grpc_if::Service {
     // logger->Log(LogLevel::VERBOSE, "On close VALID Subs is:
     // "+std::to_string(kc->grpcSubsMap->size()));
 
+    if (kc->getAccessCache() != nullptr) {
+      logger->Log(LogLevel::VERBOSE, "Access cache of connection " + std::to_string(kc->getConnID()) + ": " +
+                  kc->getAccessCache()->stats().toString() + ", released caches: " +
+                  VssAccessCache::totalStats().toString());
+    }
+
     subhandler->unsubscribeAll(*kc);
     kc->grpcSubsMap->clear();
+    writer->close();
+    kc->grpcWriter = nullptr;
+    return Status::OK;
+  }
+
+  Status getHistory(ServerContext* context,
+                    const kuksa::GetHistoryRequest* request,
+                    kuksa::GetHistoryResponse* reply) override {
+    stringstream msg;
+    msg << "gRPC getHistory invoked for " << request->path() << " by "
+        << context->peer();
+    logger->Log(LogLevel::INFO, msg.str());
+
+    // Check if authorized and get the corresponding KuksaChannel
+    KuksaChannel* kc = authChecker(context);
+    if (kc == NULL) {
+      reply->mutable_status()->set_statuscode(404);
+      reply->mutable_status()->set_statusdescription("No Authorization.");
+      return Status::OK;
+    }
+
+    jsoncons::json req_json;
+    req_json["action"] = "getHistory";
+    req_json["requestId"] =
+        boost::uuids::to_string(boost::uuids::random_generator()());
+    req_json["path"] = request->path();
+    if (request->has_starttime()) {
+      req_json["startTime"] = request->starttime().seconds() * 1000 +
+                              request->starttime().nanos() / 1000000;
+    }
+    if (request->has_endtime()) {
+      req_json["endTime"] = request->endtime().seconds() * 1000 +
+                            request->endtime().nanos() / 1000000;
+    }
+
+    try {
+      auto Processor = handler.getGrpcProcessor();
+      auto resJson = Processor->processGetHistory(*kc, req_json);
+      if (resJson.contains("error")) {  // Failure Case
+        uint32_t code = resJson["error"]["number"].as<unsigned int>();
+        std::string reason = resJson["error"]["reason"].as_string() + " " +
+                             resJson["error"]["message"].as_string();
+        reply->mutable_status()->set_statuscode(code);
+        reply->mutable_status()->set_statusdescription(reason);
+        return Status::OK;
+      }
+
+      jsoncons::json signals = resJson["data"];
+      if (!signals.is_array()) {
+        jsoncons::json single = jsoncons::json::array();
+        single.push_back(signals);
+        signals = single;
+      }
+      for (const auto& signal : signals.array_range()) {
+        std::string path = signal["path"].as<std::string>();
+        std::string datatype = database->getDatatypeForPath(VSSPath::fromVSS(path));
+        for (const auto& dp : signal["dp"].array_range()) {
+          jsoncons::json sample;
+          sample["path"] = path;
+          sample["dp"] = dp;
+          jsoncons::json data;
+          data["data"] = sample;
+          auto val = reply->add_values();
+          grpcHandler::grpc_fill_value(logger, datatype, data, val);
+          val->mutable_timestamp()->set_seconds(dp["ts_s"].as<uint64_t>());
+          val->mutable_timestamp()->set_nanos(dp["ts_ns"].as<uint32_t>());
+        }
+      }
+      reply->mutable_status()->set_statuscode(200);
+      reply->mutable_status()->set_statusdescription(
+          "Get history request successfully processed");
+    } catch (std::exception& e) {
+      logger->Log(LogLevel::ERROR, e.what());
+      reply->mutable_status()->set_statuscode(500);
+      reply->mutable_status()->set_statusdescription(e.what());
+    }
+    return Status::OK;
+  }
+
+  Status resolve(ServerContext* context, const kuksa::ResolveRequest* request,
+                 kuksa::ResolveResponse* reply) override {
+    stringstream msg;
+    msg << "gRPC resolve invoked for " << request->path().size()
+        << " path(s) by " << context->peer();
+    logger->Log(LogLevel::INFO, msg.str());
+
+    // Like metadata, ids can be resolved without authorization. Access is
+    // checked when they are used
+    if (request->path().size() == 0) {
+      reply->mutable_status()->set_statuscode(400);
+      reply->mutable_status()->set_statusdescription("No valid path found.");
+      return Status::OK;
+    }
+
+    jsoncons::json req_json;
+    req_json["action"] = "resolve";
+    req_json["requestId"] =
+        boost::uuids::to_string(boost::uuids::random_generator()());
+    jsoncons::json paths = jsoncons::json::array();
+    for (int i = 0; i < request->path().size(); i++) {
+      paths.push_back(request->path()[i]);
+    }
+    req_json["paths"] = std::move(paths);
+
+    try {
+      auto Processor = handler.getGrpcProcessor();
+      auto resJson = Processor->processResolve(req_json);
+      if (resJson.contains("error")) {  // Failure Case
+        uint32_t code = resJson["error"]["number"].as<unsigned int>();
+        std::string reason = resJson["error"]["reason"].as_string() + " " +
+                             resJson["error"]["message"].as_string();
+        reply->mutable_status()->set_statuscode(code);
+        reply->mutable_status()->set_statusdescription(reason);
+        return Status::OK;
+      }
+
+      for (const auto& entry : resJson["data"].array_range()) {
+        auto resolved = reply->add_paths();
+        resolved->set_path(entry["path"].as<std::string>());
+        resolved->set_id(entry["id"].as<uint32_t>());
+      }
+      reply->mutable_status()->set_statuscode(200);
+      reply->mutable_status()->set_statusdescription(
+          "Resolve request successfully processed");
+    } catch (std::exception& e) {
+      logger->Log(LogLevel::ERROR, e.what());
+      reply->mutable_status()->set_statuscode(500);
+      reply->mutable_status()->set_statusdescription(e.what());
+    }
     return Status::OK;
   }
 
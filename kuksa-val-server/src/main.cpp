@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctime>
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <string>
@@ -38,6 +39,7 @@
 #include "AccessChecker.hpp"
 #include "Authenticator.hpp"
 #include "BasicLogger.hpp"
+#include "JsonResponses.hpp"
 #include "SubscriptionHandler.hpp"
 #include "VssCommandProcessor.hpp"
 #include "VssDatabase.hpp"
@@ -47,6 +49,8 @@
 #include "exception.hpp"
 #include "grpcHandler.hpp"
 #include "OverlayLoader.hpp"
+#include "VssModelCompiler.hpp"
+#include "VssValuePersistence.hpp"
 
 
 #include "../buildinfo.h"
@@ -118,6 +122,18 @@ int main(int argc, const char *argv[]) {
       "log-level = ALL\n")
     ("vss", program_options::value<boost::filesystem::path>()->required(), "[mandatory] Path to VSS data file describing VSS data tree structure which `kuksa-val-server` shall handle. Sample 'vss_release_4.0.json' file can be found under [data](./data/vss-core/vss_release_4.0.json)")
     ("overlays", program_options::value<boost::filesystem::path>(), "Path to a directory cotaiing additional VSS models. All json files will be applied on top of the main vss file given by the -vss parameter in alphanumerical order")
+    ("vss-compiled", program_options::value<boost::filesystem::path>(), "Path to a compiled binary VSS model. If it has been compiled from the current vss file and overlays, the server starts from it without parsing JSON. Otherwise it is regenerated after loading vss file and overlays.")
+    ("compile-only", program_options::bool_switch()->default_value(false), "Only (re)generate the compiled VSS model given by --vss-compiled and exit")
+    ("persistence-dir", program_options::value<boost::filesystem::path>(), "If provided, signal values are stored in this directory and restored after a restart")
+    ("persistence-sync", program_options::value<string>()->default_value("interval"),
+        "When to sync stored values to disk\nnone: write every sync interval, leave syncing to the OS\ninterval: write and sync every sync interval\nalways: write and sync on every set")
+    ("persistence-sync-interval", program_options::value<int>()->default_value(200),
+        "Interval in ms in which stored values are written")
+    ("history", program_options::value<vector<string>>()->composing(),
+        "Record the last values of all signals matching PATH[:SIZE] in memory, e.g. `Vehicle.Speed:600` or `Vehicle.Cabin.*`. "
+        "Parameter can be provided multiple times. Recorded values can be queried with getHistory")
+    ("history-size", program_options::value<int>()->default_value(1000),
+        "Number of values recorded per signal, if not given in --history")
     ("cert-path", program_options::value<boost::filesystem::path>()->required()->default_value(boost::filesystem::path(".")),
       "[mandatory] Directory path where 'Server.pem', 'Server.key' and 'jwt.key.pub' are located. ")
     ("insecure", program_options::bool_switch()->default_value(false), "By default, `kuksa-val-server` shall accept only SSL (TLS) secured connections. If provided, `kuksa-val-server` shall also accept plain un-secured connections for Web-Socket and GRPC API connections, and also shall not fail connections due to self-signed certificates.")
@@ -126,6 +142,14 @@ int main(int argc, const char *argv[]) {
       "If provided, `kuksa-val-server` shall use different server address than default _'localhost'_")
     ("port", program_options::value<int>()->default_value(8090),
         "If provided, `kuksa-val-server` shall use different server port than default '8090' value")
+    ("dispatch-threads", program_options::value<unsigned>()->default_value(0),
+        "Number of threads sending subscription notifications. Each client connection is served by one of them. 0 uses one thread per CPU core")
+    ("subscriber-queue-size", program_options::value<size_t>()->default_value(1000),
+        "Number of subscription notifications queued at most for a client, which does not keep up with receiving them")
+    ("subscriber-overflow", program_options::value<string>()->default_value("conflate"),
+        "What happens to a notification for a client whose queue is full\nconflate: replace the queued value of the same subscription, if there is none drop the oldest notification\ndrop-oldest: drop the oldest notification\ndisconnect: cancel all subscriptions of the client and close its connection")
+    ("pretty-json", program_options::bool_switch()->default_value(false),
+        "Indent JSON messages sent to clients, for debugging. By default they are written compactly")
     ("record", program_options::value<string>() -> default_value("noRecord"),
         "Enables recording into log file, for later being replayed into the server \nnoRecord: no data will be recorded\nrecordSet: record setting values only\nrecordSetAndGet: record getting value and setting value")
     ("record-path",program_options::value<string>() -> default_value("."),
@@ -161,6 +185,16 @@ int main(int argc, const char *argv[]) {
       std::cout << "Update cert-path to "
                 << variables["cert-path"].as<boost::filesystem::path>().string()
                 << std::endl;
+      if (variables.count("persistence-dir")) {
+        auto persistence_path = variables["persistence-dir"].as<boost::filesystem::path>();
+        variables.at("persistence-dir").value() =
+            boost::filesystem::absolute(persistence_path, configFilePath.parent_path());
+      }
+      if (variables.count("vss-compiled")) {
+        auto compiled_path = variables["vss-compiled"].as<boost::filesystem::path>();
+        variables.at("vss-compiled").value() =
+            boost::filesystem::absolute(compiled_path, configFilePath.parent_path());
+      }
     } else if (!variables["config-file"].defaulted()) {
       std::cerr << "Could not open config file: " << configFile << std::endl;
     }
@@ -225,9 +259,27 @@ int main(int argc, const char *argv[]) {
     auto mqttPublisher = std::make_shared<MQTTPublisher>(
         logger, "vss", variables);
 
+    unsigned dispatchThreads = variables["dispatch-threads"].as<unsigned>();
+    if (dispatchThreads == 0) {
+      dispatchThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    JsonResponses::setPrettyPrint(variables["pretty-json"].as<bool>());
+
+    SubscriberQueueConfig queueConfig;
+    queueConfig.capacity = variables["subscriber-queue-size"].as<size_t>();
+    if (!overflowPolicyFromString(variables["subscriber-overflow"].as<string>(), queueConfig.overflowPolicy)) {
+      throw std::runtime_error("subscriber-overflow option \"" + variables["subscriber-overflow"].as<string>() + "\" is invalid");
+    }
     auto subHandler = std::make_shared<SubscriptionHandler>(
-        logger, httpServer, tokenValidator, accessCheck);
+        logger, httpServer, tokenValidator, accessCheck, dispatchThreads, queueConfig);
     subHandler->addPublisher(mqttPublisher);
+    // drop subscriptions as soon as the token of their channel expires
+    std::weak_ptr<SubscriptionHandler> expiringSubHandler = subHandler;
+    tokenValidator->setTokenExpiryHandler([expiringSubHandler]() {
+      if (auto handler = expiringSubHandler.lock()) {
+        handler->unsubscribeExpired();
+      }
+    });
 
     std::shared_ptr<VssDatabase> database = std::make_shared<VssDatabase>(logger,subHandler);
 
@@ -247,8 +299,76 @@ int main(int argc, const char *argv[]) {
     auto cmdProcessor = std::make_shared<VssCommandProcessor>(
         logger, database, tokenValidator, accessCheck, subHandler);
 
-    database->initJsonTree(vss_path);
-    applyOverlays(logger, overlayfiles ,database);
+    bool compiledModelLoaded = false;
+    uint64_t modelHash = 0;
+    if (variables.count("vss-compiled")) {
+      auto compiledPath = variables["vss-compiled"].as<boost::filesystem::path>();
+      modelHash = compiledModelHash(vss_path, overlayfiles);
+      VssCompiledModel model;
+      if (!variables["compile-only"].as<bool>() && loadCompiledModel(compiledPath, modelHash, model)) {
+        database->initCompiledModel(std::move(model));
+        compiledModelLoaded = true;
+        logger->Log(LogLevel::INFO, "main: Loaded compiled VSS model " + compiledPath.string());
+      }
+    } else if (variables["compile-only"].as<bool>()) {
+      throw std::runtime_error("--compile-only needs --vss-compiled");
+    }
+
+    if (!compiledModelLoaded) {
+      database->initJsonTree(vss_path);
+      applyOverlays(logger, overlayfiles ,database);
+
+      if (variables.count("vss-compiled")) {
+        auto compiledPath = variables["vss-compiled"].as<boost::filesystem::path>();
+        // defaults and overlay values are in the value store by now
+        try {
+          writeCompiledModel(compiledPath, database->getTree(true), modelHash);
+          logger->Log(LogLevel::INFO, "main: Wrote compiled VSS model " + compiledPath.string());
+        } catch (std::exception &e) {
+          // only a startup cache, e.g. on a read-only file system the server runs without it
+          if (variables["compile-only"].as<bool>()) {
+            throw;
+          }
+          logger->Log(LogLevel::WARNING, "main: Can not write compiled VSS model " + compiledPath.string()
+                      + ": " + e.what());
+        }
+      }
+    }
+    if (variables["compile-only"].as<bool>()) {
+      return 0;
+    }
+
+    if (variables.count("persistence-dir")) {
+      VssPersistenceConfig persistenceConfig;
+      persistenceConfig.directory = variables["persistence-dir"].as<boost::filesystem::path>();
+      if (!syncPolicyFromString(variables["persistence-sync"].as<string>(), persistenceConfig.syncPolicy)) {
+        throw std::runtime_error("persistence-sync option \"" + variables["persistence-sync"].as<string>() + "\" is invalid");
+      }
+      persistenceConfig.syncInterval = std::chrono::milliseconds(variables["persistence-sync-interval"].as<int>());
+      database->enablePersistence(std::make_shared<VssValuePersistence>(logger, persistenceConfig));
+    }
+
+    if (variables.count("history")) {
+      for (const auto &pattern : variables["history"].as<vector<string>>()) {
+        string path = pattern;
+        int size = variables["history-size"].as<int>();
+        auto separator = pattern.rfind(':');
+        if (separator != string::npos) {
+          path = pattern.substr(0, separator);
+          try {
+            size = std::stoi(pattern.substr(separator + 1));
+          } catch (std::exception &) {
+            size = 0;
+          }
+        }
+        if (size <= 0) {
+          throw std::runtime_error("history option \"" + pattern + "\" is invalid");
+        }
+        if (database->enableHistory(VSSPath::fromVSS(path), size) == 0) {
+          logger->Log(LogLevel::WARNING, "main: No signals found to record history for " + path);
+        }
+      }
+    }
 
     if(variables.count("mqtt.publish")){
         string path_to_publish = variables["mqtt.publish"].as<string>();
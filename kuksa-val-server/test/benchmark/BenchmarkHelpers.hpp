@@ -0,0 +1,91 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+/** Common helpers for benchmarks */
+
+#ifndef __BENCHMARKHELPERS_HPP__
+#define __BENCHMARKHELPERS_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "ISubscriptionHandler.hpp"
+
+/** Subscription handler dropping every notification, so benchmarks only
+ *  measure the component under test */
+class NullSubscriptionHandler : public ISubscriptionHandler {
+  public:
+    SubscriptionId subscribe(KuksaChannel&, std::shared_ptr<IVssDatabase>,
+                             const VSSPath&, const std::string&) override { return SubscriptionId(); }
+    int unsubscribe(SubscriptionId) override { return 0; }
+    int unsubscribeAll(KuksaChannel) override { return 0; }
+    int unsubscribeExpired() override { return 0; }
+    int publishForVSSPath(const VSSPath, const std::string&, const std::string&, const jsoncons::json&) override { return 0; }
+    int publishForVSSPaths(const std::vector<VssSignalUpdate>&, const std::string&) override { return 0; }
+
+    std::shared_ptr<IServer> getServer() override { return nullptr; }
+    int startThread() override { return 0; }
+    int stopThread() override { return 0; }
+    bool isThreadRunning() const override { return false; }
+    void addPublisher(std::shared_ptr<IPublisher>) override {}
+};
+
+/** Thread counts to measure: 1, 2, 4, ... up to the number of hardware threads */
+inline std::vector<unsigned> benchmarkThreadCounts() {
+  unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> counts;
+  for (unsigned n = 1; n < maxThreads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(maxThreads);
+  return counts;
+}
+
+/** Runs op(threadIndex, iteration) in the given number of threads for the
+ *  given duration. Returns the total number of operations completed */
+inline uint64_t runThreads(unsigned threads, std::chrono::milliseconds duration,
+                           const std::function<void(unsigned, uint64_t)> &op) {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total{0};
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      uint64_t count = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        op(t, count);
+        count++;
+      }
+      total += count;
+    });
+  }
+  std::this_thread::sleep_for(duration);
+  stop = true;
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  return total;
+}
+
+#endif
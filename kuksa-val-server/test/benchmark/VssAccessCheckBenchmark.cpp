@@ -0,0 +1,145 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Measures read access checks for all leaves of the VSS tree, with the
+ *  permissions of a token granting 1 to 256 keys. For every number of keys
+ *  the mean time per check of
+ *  - parsing the permissions and matching every key as regex, as done
+ *    before permissions were compiled
+ *  - AccessChecker with the compiled VssPermissionMatcher
+ *  is reported.
+ *
+ *  Usage: VssAccessCheckBenchmark [vss.json] [iterations]
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "AccessChecker.hpp"
+#include "BasicLogger.hpp"
+#include "BenchmarkHelpers.hpp"
+#include "KuksaChannel.hpp"
+#include "VssDatabase.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** Access check as implemented before VssPermissionMatcher */
+bool legacyCheckSignalAccess(const KuksaChannel &channel, const std::string &path,
+                             const std::string &requiredPermission) {
+  jsoncons::json permissions;
+  if (!channel.getPermissions().empty()) {
+    permissions = jsoncons::json::parse(channel.getPermissions().as_string());
+  } else {
+    permissions = jsoncons::json::parse("{}");
+  }
+  std::string permissionValue = permissions.get_with_default(path, "");
+  if (permissionValue.empty()) {
+    for (auto permission : permissions.object_range()) {
+      std::string pathString(permission.key());
+      auto path_regex = std::regex{std::regex_replace(pathString, std::regex("\\*"), std::string(".*"))};
+      std::smatch base_match;
+      if (std::regex_match(path, base_match, path_regex)) {
+        permissionValue = permission.value().as<std::string>();
+      }
+    }
+  }
+  return permissionValue.find(requiredPermission) != std::string::npos;
+}
+
+/** Permissions with the given number of keys, mixing exact paths and
+ *  wildcards like typical tokens */
+jsoncons::json permissionsWithKeys(const std::vector<std::string> &leaves, size_t keys) {
+  jsoncons::json permissions;
+  for (size_t i = 0; i < keys && i < leaves.size(); i++) {
+    const std::string &leaf = leaves[(i * 7919) % leaves.size()];
+    if (i % 4 == 0) {
+      permissions.insert_or_assign(leaf.substr(0, leaf.rfind('.')) + ".*", "r");
+    } else {
+      permissions.insert_or_assign(leaf, "rw");
+    }
+  }
+  return permissions;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  unsigned iterations = argc > 2 ? std::stoi(argv[2]) : 3;
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+  db.initJsonTree(vssFile);
+
+  std::vector<VSSPath> paths;
+  std::vector<std::string> leaves;
+  for (const auto &path : db.getLeafPaths(VSSPath::fromVSS("Vehicle"))) {
+    paths.push_back(path);
+    leaves.push_back(path.getVSSGen1Path());
+  }
+
+  AccessChecker accessChecker(nullptr);
+  const std::vector<size_t> keyCounts = {1, 4, 16, 64, 256};
+
+  std::cout << "keys;signals;legacy_us;compiled_us;speedup" << std::endl;
+  for (size_t keys : keyCounts) {
+    std::string serialized;
+    permissionsWithKeys(leaves, keys).dump(serialized);
+    KuksaChannel channel;
+    channel.setAuthorized(true);
+    channel.setPermissions(serialized);
+
+    size_t legacyGranted = 0;
+    auto start = Clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+      for (const auto &leaf : leaves) {
+        legacyGranted += legacyCheckSignalAccess(channel, leaf, "r") ? 1 : 0;
+      }
+    }
+    double legacy = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    size_t compiledGranted = 0;
+    start = Clock::now();
+    for (unsigned i = 0; i < iterations; i++) {
+      for (const auto &path : paths) {
+        compiledGranted += accessChecker.checkReadAccess(channel, path) ? 1 : 0;
+      }
+    }
+    double compiled = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    if (legacyGranted != compiledGranted) {
+      // expected only where the legacy regex let '.' match any character
+      std::cerr << "Granted checks differ for " << keys << " keys: " << legacyGranted << " vs " << compiledGranted
+                << std::endl;
+    }
+    double checks = static_cast<double>(iterations) * leaves.size();
+    std::cout << keys << ";" << leaves.size() << ";" << legacy / checks << ";" << compiled / checks << ";"
+              << legacy / compiled << std::endl;
+  }
+  return 0;
+}
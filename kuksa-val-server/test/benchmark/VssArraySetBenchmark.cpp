@@ -0,0 +1,130 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Measures validation and setSignal of array signals with 1k to 64k
+ *  elements. For every datatype and size the mean time of
+ *  - validating element by element, as done before arrays were checked in bulk
+ *  - the bulk validation of VssSignalDescriptor
+ *  - a complete setSignal
+ *  is reported.
+ *
+ *  Usage: VssArraySetBenchmark [vss.json] [iterations]
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BasicLogger.hpp"
+#include "BenchmarkHelpers.hpp"
+#include "KuksaChannel.hpp"
+#include "VssDatabase.hpp"
+#include "VssSignalDescriptor.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+jsoncons::json arrayValue(const std::string &datatype, size_t count) {
+  jsoncons::json value(jsoncons::json_array_arg);
+  value.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    if (datatype == "float[]") {
+      value.push_back(static_cast<double>(i % 1000) * 0.5);
+    } else {
+      value.push_back(i % 200);
+    }
+  }
+  return value;
+}
+
+/** Mean time of op in microseconds */
+template <typename Op>
+double meanUs(unsigned iterations, Op op) {
+  auto start = Clock::now();
+  for (unsigned i = 0; i < iterations; i++) {
+    op();
+  }
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  unsigned iterations = argc > 2 ? std::stoi(argv[2]) : 100;
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+  db.initJsonTree(vssFile);
+
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {
+      "Benchmark": {"type": "branch", "description": "Array signals for benchmarking", "children": {
+        "Raw": {"type": "sensor", "datatype": "uint8[]", "description": "Raw bytes", "max": 250},
+        "Points": {"type": "sensor", "datatype": "float[]", "description": "Point list", "min": -1000, "max": 1000}}}}}}
+  )");
+  db.updateJsonTree(channel, overlay);
+
+  const std::vector<std::pair<std::string, VSSPath>> signals = {
+    {"uint8[]", VSSPath::fromVSS("Vehicle/Benchmark/Raw")},
+    {"float[]", VSSPath::fromVSS("Vehicle/Benchmark/Points")}};
+  const std::vector<size_t> sizes = {1024, 4096, 16384, 65536};
+
+  std::cout << "datatype;elements;per_element_us;bulk_us;set_us;bulk_elements_per_us" << std::endl;
+  for (const auto &signal : signals) {
+    jsoncons::json meta;
+    meta["datatype"] = signal.first;
+    auto descriptor = VssSignalDescriptor::compile(meta);
+    jsoncons::json elementMeta;
+    elementMeta["datatype"] = signal.first.substr(0, signal.first.size() - 2);
+    auto elementDescriptor = VssSignalDescriptor::compile(elementMeta);
+
+    for (size_t size : sizes) {
+      const jsoncons::json value = arrayValue(signal.first, size);
+
+      double perElement = meanUs(iterations, [&]() {
+        for (auto element : value.array_range()) {
+          elementDescriptor->sanitize(element);
+        }
+        jsoncons::json copy = value;
+        VssValue::fromJson(descriptor->datatype(), copy);
+      });
+      double bulk = meanUs(iterations, [&]() {
+        jsoncons::json copy = value;
+        descriptor->sanitize(copy);
+      });
+      double set = meanUs(iterations, [&]() {
+        jsoncons::json copy = value;
+        db.setSignal(signal.second, "value", copy);
+      });
+
+      std::cout << signal.first << ";" << size << ";" << perElement << ";" << bulk << ";" << set << ";"
+                << size / bulk << std::endl;
+    }
+  }
+  return 0;
+}
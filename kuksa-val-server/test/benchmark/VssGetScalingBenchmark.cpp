@@ -0,0 +1,91 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Measures VssDatabase::getSignal throughput with 1 to N reader threads.
+ *  Optionally one writer thread keeps setting values in parallel.
+ *
+ *  Usage: VssGetScalingBenchmark [vss.json] [duration_ms] [with-writer]
+ */
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "BasicLogger.hpp"
+#include "BenchmarkHelpers.hpp"
+#include "VssDatabase.hpp"
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  std::chrono::milliseconds duration(argc > 2 ? std::stoi(argv[2]) : 1000);
+  bool withWriter = argc > 3 && std::string(argv[3]) == "with-writer";
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+  db.initJsonTree(vssFile);
+
+  std::vector<VSSPath> paths;
+  for (const auto &path : db.getLeafPaths(VSSPath::fromVSS("Vehicle"))) {
+    if (db.getDatatypeForPath(path) == "float") {
+      jsoncons::json value = 1.0;
+      db.setSignal(path, "value", value);
+      paths.push_back(path);
+    }
+  }
+  if (paths.empty()) {
+    std::cerr << "No float signals found in " << vssFile << std::endl;
+    return 1;
+  }
+
+  std::cout << "threads;gets_per_s;scaling" << std::endl;
+  double baseline = 0;
+  for (unsigned threads : benchmarkThreadCounts()) {
+    std::atomic<bool> stopWriter{false};
+    std::thread writer;
+    if (withWriter) {
+      writer = std::thread([&]() {
+        uint64_t i = 0;
+        while (!stopWriter) {
+          jsoncons::json value = static_cast<double>(i);
+          db.setSignal(paths[i % paths.size()], "value", value);
+          i++;
+        }
+      });
+    }
+
+    uint64_t gets = runThreads(threads, duration, [&](unsigned t, uint64_t i) {
+      db.getSignal(paths[(i * 7 + t) % paths.size()], "value", true);
+    });
+
+    stopWriter = true;
+    if (writer.joinable()) {
+      writer.join();
+    }
+
+    double perSecond = gets * 1000.0 / duration.count();
+    if (baseline == 0) {
+      baseline = perSecond;
+    }
+    std::cout << threads << ";" << static_cast<uint64_t>(perSecond) << ";" << perSecond / baseline << std::endl;
+  }
+  return 0;
+}
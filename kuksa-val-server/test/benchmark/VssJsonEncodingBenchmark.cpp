@@ -0,0 +1,116 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+
+/** Measures encoding of typical websocket messages, pretty printed and
+ *  compact: a subscription notification as encoded once per update by
+ *  VssNotificationPayload, a batched get response and an error response.
+ *  For every message and format the size in bytes and the mean encoding
+ *  time in ns is reported.
+ *
+ *  Usage: VssJsonEncodingBenchmark [iterations]
+ */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JsonResponses.hpp"
+#include "VssNotificationPayload.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+jsoncons::json signal(const std::string &path, double value) {
+  jsoncons::json data;
+  data["path"] = path;
+  data["dp"]["value"] = value;
+  data["dp"]["ts"] = "2022-05-04T11:17:05.1651663025Z";
+  return data;
+}
+
+jsoncons::json getResponse() {
+  jsoncons::json answer;
+  answer["action"] = "get";
+  answer["requestId"] = "8756";
+  jsoncons::json data = jsoncons::json::array();
+  for (int row = 1; row <= 2; row++) {
+    for (int pos = 1; pos <= 3; pos++) {
+      std::string seat = "Vehicle.Cabin.Seat.Row" + std::to_string(row) + ".Pos" + std::to_string(pos);
+      data.push_back(signal(seat + ".Height", 200 + pos));
+      data.push_back(signal(seat + ".Position", 100 + row));
+    }
+  }
+  answer["data"] = data;
+  answer["ts"] = "2022-05-04T11:17:05.1651663025Z";
+  return answer;
+}
+
+struct Message {
+  std::string name;
+  // encodes the message once, returns its size
+  std::function<size_t()> encode;
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  unsigned iterations = argc > 1 ? std::stoi(argv[1]) : 100000;
+
+  jsoncons::json notification;
+  notification["path"] = "Vehicle.Speed";
+  notification["dp"]["value"] = 87.5;
+  notification["dp"]["ts_s"] = 1651663025;
+  notification["dp"]["ts_ns"] = 165166302;
+  const jsoncons::json get = getResponse();
+  const jsoncons::json error = JsonResponses::noAccess("8757", "set", "No write access to Vehicle.Speed");
+
+  std::vector<Message> messages = {
+    {"subscription", [&] {
+      VssNotificationPayload payload("float", notification);
+      auto message = payload.websocketMessage();
+      // a subscriptionId is spliced in for every subscriber
+      return message->head.size() + 36 + message->tail.size();
+    }},
+    {"get", [&] { return JsonResponses::serialize(get).size(); }},
+    {"error", [&] { return JsonResponses::serialize(error).size(); }},
+  };
+
+  std::cout << "message;format;bytes_per_message;ns_per_message" << std::endl;
+  for (const auto &message : messages) {
+    for (bool pretty : {true, false}) {
+      JsonResponses::setPrettyPrint(pretty);
+      size_t bytes = message.encode();
+      auto start = Clock::now();
+      for (unsigned i = 0; i < iterations; i++) {
+        message.encode();
+      }
+      double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+      std::cout << message.name << ";" << (pretty ? "pretty" : "compact") << ";" << bytes << ";"
+                << ns / iterations << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Reports the memory used by the VSS tree. Compares the current layout
+ *  (single metadata tree plus value store) with the previous one, which kept
+ *  a second full copy of the tree as meta_tree__.
+ *
+ *  Usage: VssMemoryFootprintBenchmark [vss.json]
+ */
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "BasicLogger.hpp"
+#include "VssDatabase.hpp"
+
+/** Resident set size of this process in bytes, read from /proc */
+static size_t residentSetSize() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+
+  size_t rssStart = residentSetSize();
+  VssDatabase db(logger, nullptr);
+  db.initJsonTree(vssFile);
+  size_t rssSingle = residentSetSize();
+
+  // the previous layout held an additional copy of the complete tree
+  jsoncons::json metaTreeCopy = db.getTree();
+  size_t rssDouble = residentSetSize();
+
+  size_t treeBytes = VssDatabase::jsonMemoryFootprint(metaTreeCopy);
+  size_t totalBytes = db.getMemoryFootprint();
+
+  std::cout << "VSS file                     : " << vssFile << std::endl;
+  std::cout << "Estimated tree size          : " << treeBytes << " bytes" << std::endl;
+  std::cout << "Estimated tree+index+values  : " << totalBytes << " bytes" << std::endl;
+  std::cout << "RSS growth, single tree      : " << (rssSingle - rssStart) << " bytes" << std::endl;
+  std::cout << "RSS growth, with second copy : " << (rssDouble - rssStart) << " bytes" << std::endl;
+  std::cout << "Saved by dropping meta_tree__: " << (rssDouble - rssSingle) << " bytes (RSS), "
+            << treeBytes << " bytes (estimated)" << std::endl;
+
+  return metaTreeCopy.is_object() ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Measures the cost of value persistence. For every sync policy a feeder
+ *  sets float signals at a given rate (0 meaning as fast as possible) and the
+ *  achieved rate, the mean setSignal latency and the log throughput are
+ *  reported. Afterwards the startup time, i.e. loading the VSS file and
+ *  replaying the recorded values, is measured with the log as written and
+ *  after compacting it into a snapshot.
+ *
+ *  Usage: VssPersistenceBenchmark [vss.json] [duration_ms] [directory]
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BasicLogger.hpp"
+#include "BenchmarkHelpers.hpp"
+#include "VssDatabase.hpp"
+#include "VssValuePersistence.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<VSSPath> floatSignals(VssDatabase &db) {
+  std::vector<VSSPath> paths;
+  for (const auto &path : db.getLeafPaths(VSSPath::fromVSS("Vehicle"))) {
+    if (db.getDatatypeForPath(path) == "float") {
+      paths.push_back(path);
+    }
+  }
+  return paths;
+}
+
+/** Time to start a database from vssFile, replaying all values in directory */
+double startupMs(std::shared_ptr<ILogger> logger, const std::string &vssFile, const VssPersistenceConfig &config) {
+  auto start = Clock::now();
+  VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+  db.initJsonTree(vssFile);
+  db.enablePersistence(std::make_shared<VssValuePersistence>(logger, config));
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  std::chrono::milliseconds duration(argc > 2 ? std::stoi(argv[2]) : 2000);
+  boost::filesystem::path directory = argc > 3 ? argv[3] : "persistence_benchmark";
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  const std::vector<std::pair<std::string, VssSyncPolicy>> policies = {
+    {"none", VssSyncPolicy::NONE}, {"interval", VssSyncPolicy::INTERVAL}, {"always", VssSyncPolicy::ALWAYS}};
+  const std::vector<unsigned> rates = {1000, 10000, 100000, 0};
+
+  std::cout << "policy;target_sets_per_s;sets_per_s;mean_set_us;wal_bytes_per_s;syncs_per_s" << std::endl;
+  for (const auto &policy : policies) {
+    for (unsigned rate : rates) {
+      boost::filesystem::remove_all(directory);
+      VssPersistenceConfig config;
+      config.directory = directory;
+      config.syncPolicy = policy.second;
+      // measure the log only, compaction is covered by the startup measurement
+      config.compactionThreshold = SIZE_MAX;
+      auto persistence = std::make_shared<VssValuePersistence>(logger, config);
+
+      VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+      db.initJsonTree(vssFile);
+      db.enablePersistence(persistence);
+      std::vector<VSSPath> paths = floatSignals(db);
+      if (paths.empty()) {
+        std::cerr << "No float signals found in " << vssFile << std::endl;
+        return 1;
+      }
+
+      uint64_t sets = 0;
+      Clock::duration busy(0);
+      auto start = Clock::now();
+      auto end = start + duration;
+      while (Clock::now() < end) {
+        if (rate > 0) {
+          std::this_thread::sleep_until(start + std::chrono::microseconds(sets * 1000000 / rate));
+        }
+        jsoncons::json value = static_cast<double>(sets % 250);
+        auto before = Clock::now();
+        db.setSignal(paths[sets % paths.size()], "value", value);
+        busy += Clock::now() - before;
+        sets++;
+      }
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      persistence->flush();
+
+      std::cout << policy.first << ";" << rate << ";" << static_cast<uint64_t>(sets / seconds) << ";"
+                << std::chrono::duration<double, std::micro>(busy).count() / sets << ";"
+                << static_cast<uint64_t>(persistence->bytesWritten() / seconds) << ";"
+                << static_cast<uint64_t>(persistence->syncs() / seconds) << std::endl;
+    }
+  }
+
+  // the directory holds the log of the last run, i.e. as many records as it could write
+  VssPersistenceConfig config;
+  config.directory = directory;
+  std::cout << std::endl << "variant;startup_ms" << std::endl;
+  {
+    boost::filesystem::path empty = directory / "empty";
+    VssPersistenceConfig emptyConfig;
+    emptyConfig.directory = empty;
+    std::cout << "no values;" << startupMs(logger, vssFile, emptyConfig) << std::endl;
+  }
+  std::cout << "replay log;" << startupMs(logger, vssFile, config) << std::endl;
+  {
+    VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+    db.initJsonTree(vssFile);
+    auto persistence = std::make_shared<VssValuePersistence>(logger, config);
+    db.enablePersistence(persistence);
+    persistence->compact();
+  }
+  std::cout << "replay snapshot;" << startupMs(logger, vssFile, config) << std::endl;
+
+  boost::filesystem::remove_all(directory);
+  return 0;
+}
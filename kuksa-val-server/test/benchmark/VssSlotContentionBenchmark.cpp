@@ -0,0 +1,169 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Contention microbenchmark for a single hot signal: N readers hammer the
+ *  same slot, once alone and once with a writer storing as fast as it can.
+ *  Reads per second for increasing N show how reads scale. Compares the
+ *  sequence locked VssSignalSlot (with a float and a string value), a
+ *  shared_ptr swapped with std::atomic_load/std::atomic_store, a slot guarded
+ *  by a mutex, and finally runs the same mix through
+ *  VssDatabase::getSignal/setSignal on Vehicle.Speed.
+ *
+ *  Usage: VssSlotContentionBenchmark [vss.json] [duration_ms]
+ */
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "BasicLogger.hpp"
+#include "BenchmarkHelpers.hpp"
+#include "VssDatabase.hpp"
+#include "VssValueStore.hpp"
+
+namespace {
+
+struct Result {
+  uint64_t reads;
+  uint64_t writes;
+};
+
+/** Runs readers threads calling read(), while one thread calls write(i) if
+ *  withWriter is set */
+template <typename Read, typename Write>
+Result contend(unsigned readers, bool withWriter, std::chrono::milliseconds duration, Read read, Write write) {
+  std::atomic<bool> stop{false};
+  uint64_t writes = 0;
+  std::thread writer;
+  if (withWriter) {
+    writer = std::thread([&]() {
+      while (!stop.load(std::memory_order_relaxed)) {
+        write(writes++);
+      }
+    });
+  }
+  uint64_t reads = runThreads(readers, duration, [&](unsigned, uint64_t) { read(); });
+  stop = true;
+  if (writer.joinable()) {
+    writer.join();
+  }
+  return Result{reads, writes};
+}
+
+void print(const std::string &variant, unsigned readers, bool withWriter, std::chrono::milliseconds duration,
+           const Result &res) {
+  std::cout << variant << ";" << readers << ";" << (withWriter ? 1 : 0) << ";"
+            << static_cast<uint64_t>(res.reads * 1000.0 / duration.count()) << ";"
+            << static_cast<uint64_t>(res.reads * 1000.0 / duration.count() / readers) << ";"
+            << static_cast<uint64_t>(res.writes * 1000.0 / duration.count()) << std::endl;
+}
+
+VssSample floatSample(uint64_t i) {
+  VssSample sample;
+  sample.value = VssValue::fromScalar<float>(static_cast<float>(i));
+  sample.ts_s = i;
+  return sample;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  std::chrono::milliseconds duration(argc > 2 ? std::stoi(argv[2]) : 1000);
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  VssDatabase db(logger, std::make_shared<NullSubscriptionHandler>());
+  db.initJsonTree(vssFile);
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  jsoncons::json initial = 0.0;
+  db.setSignal(speed, "value", initial);
+
+  std::cout << "variant;readers;writers;reads_per_s;reads_per_s_per_reader;writes_per_s" << std::endl;
+  for (bool withWriter : {false, true}) {
+    for (unsigned readers : benchmarkThreadCounts()) {
+      VssSignalSlot slot(VssDatatype::FLOAT);
+      slot.store(VssAttribute::VALUE, floatSample(0));
+      Result seqlockSlot = contend(readers, withWriter, duration,
+        [&]() {
+          VssSample sample;
+          slot.load(VssAttribute::VALUE, sample);
+          volatile float v = sample.value.get<float>();
+          (void)v;
+        },
+        [&](uint64_t i) { slot.store(VssAttribute::VALUE, floatSample(i)); });
+      print("seqlock-slot", readers, withWriter, duration, seqlockSlot);
+
+      VssSignalSlot stringSlot(VssDatatype::STRING);
+      VssSample text;
+      text.value = VssValue::fromString("ECU firmware version 1.2.3");
+      stringSlot.store(VssAttribute::VALUE, text);
+      Result seqlockString = contend(readers, withWriter, duration,
+        [&]() {
+          VssSample sample;
+          stringSlot.load(VssAttribute::VALUE, sample);
+          volatile size_t size = sample.value.getString().size();
+          (void)size;
+        },
+        [&](uint64_t i) {
+          text.ts_s = i;
+          stringSlot.store(VssAttribute::VALUE, text);
+        });
+      print("seqlock-slot-string", readers, withWriter, duration, seqlockString);
+
+      // the previous slot implementation, libstdc++ guards these with a small
+      // global pool of mutexes
+      auto shared = std::make_shared<const VssSample>(floatSample(0));
+      Result sharedSlot = contend(readers, withWriter, duration,
+        [&]() {
+          auto sample = std::atomic_load(&shared);
+          volatile float v = sample->value.get<float>();
+          (void)v;
+        },
+        [&](uint64_t i) { std::atomic_store(&shared, std::make_shared<const VssSample>(floatSample(i))); });
+      print("shared_ptr-slot", readers, withWriter, duration, sharedSlot);
+
+      std::mutex mutex;
+      VssSample guarded;
+      Result mutexSlot = contend(readers, withWriter, duration,
+        [&]() {
+          std::lock_guard<std::mutex> lock(mutex);
+          volatile float v = guarded.value.get<float>();
+          (void)v;
+        },
+        [&](uint64_t i) {
+          std::lock_guard<std::mutex> lock(mutex);
+          guarded = floatSample(i);
+        });
+      print("mutex-slot", readers, withWriter, duration, mutexSlot);
+
+      Result database = contend(readers, withWriter, duration,
+        [&]() { db.getSignal(speed, "value", false); },
+        [&](uint64_t i) {
+          jsoncons::json value = static_cast<double>(i % 250);
+          db.setSignal(speed, "value", value);
+        });
+      print("VssDatabase", readers, withWriter, duration, database);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,177 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+/** Measures how fast subscription notifications are sent to websocket
+ *  connections, for 1 up to the number of hardware threads dispatch threads.
+ *  For every thread count
+ *  - notifications per second with all connections consuming fast
+ *  - the median time until a connection got all notifications, while one
+ *    other connection takes 1 ms per notification
+ *  are reported.
+ *
+ *  Usage: VssSubscriptionDispatchBenchmark [vss.json] [connections] [updates]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "AccessChecker.hpp"
+#include "BasicLogger.hpp"
+#include "BenchmarkHelpers.hpp"
+#include "KuksaChannel.hpp"
+#include "SubscriptionHandler.hpp"
+#include "VssDatabase.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** Counts notifications per connection instead of sending them */
+class CountingServer : public IServer {
+  public:
+    CountingServer(const std::vector<ConnectionId> &connections, unsigned updates, bool slowConsumer)
+      : received(connections.size()), done(connections.size()), updates_(updates),
+        slowConsumer_(slowConsumer), start_(Clock::now()) {
+      for (size_t i = 0; i < connections.size(); i++) {
+        index_[connections[i]] = i;
+      }
+    }
+
+    void AddListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) override {}
+    void RemoveListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) override {}
+    bool SendToConnection(ConnectionId connID, const std::string &) override {
+      return count(connID);
+    }
+    // like the websocket server, keep the shared message instead of copying it
+    bool SendSharedToConnection(ConnectionId connID, std::shared_ptr<const SharedMessage>,
+                                const std::string &) override {
+      return count(connID);
+    }
+
+    void start() { start_ = Clock::now(); }
+
+    std::vector<std::atomic<unsigned>> received;
+    // ms after start until all notifications of a connection were sent
+    std::vector<double> done;
+    std::atomic<size_t> completed{0};
+
+  private:
+    bool count(ConnectionId connID) {
+      size_t index = index_.at(connID);
+      if (index == 0 && slowConsumer_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (++received[index] == updates_) {
+        done[index] = std::chrono::duration<double, std::milli>(Clock::now() - start_).count();
+        completed++;
+      }
+      return true;
+    }
+
+    std::unordered_map<ConnectionId, size_t> index_;
+    unsigned updates_;
+    bool slowConsumer_;
+    Clock::time_point start_;
+};
+
+struct Result {
+  double notificationsPerSecond;
+  double medianCompletionMs;
+};
+
+Result measure(std::shared_ptr<VssDatabase> db, const VSSPath &path, unsigned threads,
+               unsigned connections, unsigned updates, bool slowConsumer) {
+  // connection ids are session addresses in the server, spread like them
+  std::vector<ConnectionId> ids;
+  for (unsigned c = 0; c < connections; c++) {
+    ids.push_back(0x7f0000001000ull + c * 0x230ull);
+  }
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  auto server = std::make_shared<CountingServer>(ids, updates, slowConsumer);
+  auto accessChecker = std::make_shared<AccessChecker>(nullptr);
+  // every notification needs to arrive, none may be conflated
+  SubscriberQueueConfig queueConfig;
+  queueConfig.capacity = updates;
+  SubscriptionHandler handler(logger, server, nullptr, accessChecker, threads, queueConfig);
+
+  jsoncons::json permissions;
+  permissions["Vehicle.*"] = "r";
+  for (ConnectionId id : ids) {
+    KuksaChannel channel;
+    channel.setConnID(id);
+    channel.setType(KuksaChannel::Type::WEBSOCKET_PLAIN);
+    channel.setPermissions(permissions);
+    handler.subscribe(channel, db, path, "value");
+  }
+
+  server->start();
+  auto start = Clock::now();
+  for (unsigned i = 0; i < updates; i++) {
+    jsoncons::json data;
+    data["path"] = path.getVSSPath();
+    data["dp"]["value"] = i;
+    data["dp"]["ts_s"] = 1650000000 + i;
+    data["dp"]["ts_ns"] = 500;
+    handler.publishForVSSPath(path, "uint32", "value", data);
+  }
+  while (server->completed < connections) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  handler.stopThread();
+
+  // the slow connection itself is not part of the median
+  std::vector<double> done(server->done.begin() + 1, server->done.end());
+  std::nth_element(done.begin(), done.begin() + done.size() / 2, done.end());
+  return Result{static_cast<double>(connections) * updates / seconds, done[done.size() / 2]};
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string vssFile = argc > 1 ? argv[1] : "test_vss_release_latest.json";
+  unsigned connections = argc > 2 ? std::stoi(argv[2]) : 256;
+  unsigned updates = argc > 3 ? std::stoi(argv[3]) : 200;
+
+  auto logger = std::make_shared<BasicLogger>(static_cast<uint8_t>(LogLevel::NONE));
+  auto db = std::make_shared<VssDatabase>(logger, std::make_shared<NullSubscriptionHandler>());
+  db->initJsonTree(vssFile);
+  const VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+
+  std::cout << "threads;connections;notifications_per_s;median_completion_ms;median_completion_ms_with_slow_consumer"
+            << std::endl;
+  for (unsigned threads : benchmarkThreadCounts()) {
+    Result fast = measure(db, path, threads, connections, updates, false);
+    Result slow = measure(db, path, threads, connections, updates, true);
+    std::cout << threads << ";" << connections << ";" << fast.notificationsPerSecond << ";"
+              << fast.medianCompletionMs << ";" << slow.medianCompletionMs << std::endl;
+  }
+  return 0;
+}
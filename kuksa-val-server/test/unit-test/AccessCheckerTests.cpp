@@ -277,4 +277,141 @@ BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_PathWriteForAllPathsNotHaveWri
   BOOST_TEST(accChecker->checkPathWriteAccess(channel, jsonPaths) == false);
 }
 
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_PathMatchesWildcard_Shall_UseWildcardPermissions) {
+  KuksaChannel channel;
+  jsoncons::json permissions;
+
+  // setup
+  permissions.insert_or_assign("Vehicle.Acceleration.*", "r");
+  permissions.insert_or_assign("Vehicle.Acceleration.L*", "rw");
+
+  channel.setConnID(11);
+  channel.setAuthorized(true);
+  channel.setPermissions(permissions);
+
+  // verify, last matching key in key order wins
+  BOOST_TEST(accChecker->checkReadAccess(channel, VSSPath::fromVSS("Vehicle.Acceleration.Vertical")) == true);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Acceleration.Vertical")) == false);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Acceleration.Lateral")) == true);
+  BOOST_TEST(accChecker->checkReadAccess(channel, VSSPath::fromVSS("Vehicle.Speed")) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_PathMatchesExactAndWildcard_Shall_UseExactPermissions) {
+  KuksaChannel channel;
+  jsoncons::json permissions;
+
+  // setup
+  permissions.insert_or_assign("Vehicle.Acceleration.Vertical", "r");
+  permissions.insert_or_assign("Vehicle.*", "rw");
+
+  channel.setConnID(11);
+  channel.setAuthorized(true);
+  channel.setPermissions(permissions);
+
+  // verify
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Acceleration.Vertical")) == false);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Acceleration.Lateral")) == true);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_WildcardPrefixDiffers_Shall_ReturnFalse) {
+  KuksaChannel channel;
+  jsoncons::json permissions;
+
+  // setup, '.' only matches itself
+  permissions.insert_or_assign("Vehicle.Cabin.Door.Row1.*", "rw");
+
+  channel.setConnID(11);
+  channel.setAuthorized(true);
+  channel.setPermissions(permissions);
+
+  // verify
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Cabin.Door.Row1.Left.IsOpen")) == true);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Cabin.Door.Row10.Left.IsOpen")) == false);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Cabin.Door.Row1xLeft")) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_UnauthorizedChannel_When_NoPermissionsSet_Shall_ReturnFalse) {
+  KuksaChannel channel;
+
+  channel.setConnID(11);
+
+  // verify
+  BOOST_TEST(accChecker->checkReadAccess(channel, VSSPath::fromVSS("Vehicle.Speed")) == false);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, VSSPath::fromVSS("Vehicle.Speed")) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_PermissionsMalformed_Shall_ReturnFalse) {
+  KuksaChannel channel;
+
+  channel.setConnID(11);
+  channel.setAuthorized(true);
+  channel.setPermissions(std::string("{\"Vehicle.*\": \"rw\""));
+
+  // verify
+  BOOST_TEST(accChecker->checkReadAccess(channel, VSSPath::fromVSS("Vehicle.Speed")) == false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_PathCheckedTwice_Shall_UseCachedDecision) {
+  KuksaChannel channel;
+  jsoncons::json permissions;
+
+  // setup
+  permissions.insert_or_assign("Vehicle.Acceleration.*", "r");
+
+  channel.setConnID(11);
+  channel.setAuthorized(true);
+  channel.setPermissions(permissions);
+
+  // decisions are cached by id, only paths of the model have one
+  VSSPath path = VSSPath::internVSSGen2("Vehicle/Acceleration/Vertical");
+
+  // verify, write check reuses the decision of the read check
+  BOOST_TEST(accChecker->checkReadAccess(channel, path) == true);
+  BOOST_TEST(accChecker->checkWriteAccess(channel, path) == false);
+  BOOST_TEST(accChecker->checkReadAccess(channel, path) == true);
+
+  BOOST_TEST(channel.getAccessCache()->stats().hits == 2);
+  BOOST_TEST(channel.getAccessCache()->stats().misses == 1);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AccessCache_When_Released_Shall_AddToTotalStats) {
+  VssAccessCache::Stats before = VssAccessCache::totalStats();
+  {
+    VssAccessCache cache;
+    uint8_t permissions = 0;
+    cache.store(7, 3);
+    BOOST_TEST(cache.lookup(7, permissions) == true);
+    BOOST_TEST(cache.lookup(8, permissions) == false);
+
+    // checks only count in the cache itself while it is in use
+    BOOST_TEST(VssAccessCache::totalStats().hits == before.hits);
+    BOOST_TEST(VssAccessCache::totalStats().misses == before.misses);
+  }
+  BOOST_TEST(VssAccessCache::totalStats().hits == before.hits + 1);
+  BOOST_TEST(VssAccessCache::totalStats().misses == before.misses + 1);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_PermissionsChange_Shall_NotUseCachedDecision) {
+  KuksaChannel channel;
+  jsoncons::json permissions;
+
+  // setup
+  permissions.insert_or_assign("Vehicle.Acceleration.*", "r");
+
+  channel.setConnID(11);
+  channel.setAuthorized(true);
+  channel.setPermissions(permissions);
+
+  VSSPath path = VSSPath::fromVSS("Vehicle.Acceleration.Vertical");
+  BOOST_TEST(accChecker->checkWriteAccess(channel, path) == false);
+
+  // verify, a copy of the channel keeps the permissions it was made with
+  KuksaChannel copy = channel;
+  permissions.insert_or_assign("Vehicle.Acceleration.*", "rw");
+  channel.setPermissions(permissions);
+
+  BOOST_TEST(accChecker->checkWriteAccess(channel, path) == true);
+  BOOST_TEST(accChecker->checkWriteAccess(copy, path) == false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -203,4 +203,68 @@ BOOST_AUTO_TEST_CASE(Given_BadToken_When_Validate_Shall_ReturnError)
   BOOST_TEST(res == -1);
 }
 
+BOOST_AUTO_TEST_CASE(Given_KnownToken_When_ValidateAgain_Shall_NotVerifyTokenAgain)
+{
+  KuksaChannel channel;
+  KuksaChannel otherChannel;
+
+  // expectations
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+
+  picojson::value picoJson;
+  picojson::parse(picoJson, R"({"Vehicle.Drivetrain.*" : "rw"})");
+
+  auto token = jwt::create()
+    .set_type("JWT")
+    .set_algorithm("RS256")
+    .set_issued_at(std::chrono::system_clock::now())
+    .set_expires_at(std::chrono::system_clock::now() + std::chrono::hours(24))
+    .set_payload_claim("kuksa-vss", jwt::claim(picoJson))
+    .sign(jwt::algorithm::rs256{validPubKey, validPrivateKey});
+
+  auth->updatePubKey(validPubKey);
+  auto res = auth->validate(channel, token);
+
+  // verify
+
+  // a cached token is neither decoded nor verified, which would log its claims
+  MOCK_RESET(logMock->Log);
+  MOCK_EXPECT(logMock->Log).never();
+
+  BOOST_TEST(auth->validate(otherChannel, token) == res);
+  BOOST_TEST(otherChannel.isAuthorized() == true);
+  BOOST_TEST(otherChannel.getPermissionMatcher()->canWrite("Vehicle.Drivetrain.Transmission.Gear") == true);
+  BOOST_TEST(auth->isStillValid(otherChannel) == true);
+}
+
+BOOST_AUTO_TEST_CASE(Given_KnownToken_When_PubKeyChanged_Shall_VerifyTokenAgain)
+{
+  KuksaChannel channel;
+
+  // expectations
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+
+  picojson::value picoJson;
+  picojson::parse(picoJson, R"({"Vehicle.Drivetrain.*" : "rw"})");
+
+  auto token = jwt::create()
+    .set_type("JWT")
+    .set_algorithm("RS256")
+    .set_issued_at(std::chrono::system_clock::now())
+    .set_expires_at(std::chrono::system_clock::now() + std::chrono::hours(24))
+    .set_payload_claim("kuksa-vss", jwt::claim(picoJson))
+    .sign(jwt::algorithm::rs256{validPubKey, validPrivateKey});
+
+  auth->updatePubKey(validPubKey);
+  BOOST_TEST(auth->validate(channel, token) > 0);
+
+  // verify
+
+  auth->updatePubKey("");
+  BOOST_TEST(auth->validate(channel, token) == -1);
+  BOOST_TEST(auth->isStillValid(channel) == false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -32,7 +32,11 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <atomic>
+#include <condition_variable>
 #include <list>
+#include <map>
+#include <mutex>
 #include <thread>
 #include <fstream>
 
@@ -49,6 +53,7 @@
 #include "JsonResponses.hpp"
 #include "SubscriptionHandler.hpp"
 #include "UnitTestHelpers.hpp"
+#include "VssGrpcStreamWriter.hpp"
 #include "kuksa.pb.h"
 
 
@@ -62,6 +67,94 @@ namespace {
 
   std::unique_ptr<SubscriptionHandler> subHandler;
 
+  // records notified values, called from all dispatch threads
+  struct RecordingServer : public IServer {
+    void AddListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) override {}
+    void RemoveListener(ObserverType, std::shared_ptr<IVssCommandProcessor>) override {}
+    bool SendToConnection(ConnectionId connID, const std::string &message) override {
+      jsoncons::json response = jsoncons::json::parse(message);
+      std::lock_guard<std::mutex> lock(mutex);
+      messages.push_back(message);
+      values[connID].push_back(response["data"]["dp"]["value"].as<std::string>());
+      subscriptionIds[connID].insert(response["subscriptionId"].as<std::string>());
+      return true;
+    }
+    bool SendSharedToConnection(ConnectionId connID, std::shared_ptr<const SharedMessage> message,
+                                const std::string &subscriptionId) override {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        sharedMessages.insert(message.get());
+      }
+      return SendToConnection(connID, message->head + subscriptionId + message->tail);
+    }
+    // simulates clients not reading their messages
+    size_t PendingWrites(ConnectionId) override { return backlog; }
+    void CloseConnection(ConnectionId connID) override {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed.insert(connID);
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    std::map<ConnectionId, std::vector<std::string>> values;
+    std::map<ConnectionId, std::set<std::string>> subscriptionIds;
+    std::set<const SharedMessage *> sharedMessages;
+    std::set<ConnectionId> closed;
+    std::atomic<size_t> backlog{0};
+  };
+
+  // gRPC subscribe stream of a client, which does not read until released
+  struct BlockingStream : public VssGrpcStreamWriter::Stream {
+    void SendInitialMetadata() override {}
+    bool NextMessageSize(uint32_t *sz) override { *sz = 0; return false; }
+    bool Read(kuksa::SubscribeRequest *) override { return false; }
+    bool Write(const kuksa::SubscribeResponse &, grpc::WriteOptions) override {
+      std::unique_lock<std::mutex> lock(mutex);
+      released.wait(lock, [this] { return !blocked; });
+      writes++;
+      return true;
+    }
+    void release() {
+      std::lock_guard<std::mutex> lock(mutex);
+      blocked = false;
+      released.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable released;
+    bool blocked = true;
+    std::atomic<unsigned> writes{0};
+  };
+
+  // publishes values 0 to count - 1 to a single websocket client, which
+  // stops reading until all are published
+  std::vector<std::string> publishToSlowClient(SubscriptionHandler &handler,
+                                               RecordingServer &server,
+                                               unsigned count,
+                                               SubscriptionId *subscriptionId = nullptr) {
+    VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+    MOCK_EXPECT(dbMock->pathExists).with(vsspath).returns(true);
+    MOCK_EXPECT(dbMock->pathIsReadable).with(vsspath).returns(true);
+    MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, vsspath).returns(true);
+
+    KuksaChannel channel;
+    channel.setConnID(1000);
+    SubscriptionId subId;
+    BOOST_CHECK_NO_THROW(subId = handler.subscribe(channel, dbMock, vsspath, "value"));
+    if (subscriptionId != nullptr) {
+      *subscriptionId = subId;
+    }
+
+    server.backlog = 1000;
+    for (unsigned index = 0; index < count; index++) {
+      BOOST_TEST(handler.publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, std::to_string(index))) == 0);
+    }
+    server.backlog = 0;
+    usleep(100000); // allow for dispatch thread to retry
+    handler.stopThread();
+    return server.values[1000];
+  }
+
   // Pre-test initialization and post-test desctruction of common resources
   struct TestSuiteFixture {
     TestSuiteFixture() {
@@ -109,15 +202,10 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_SubscribeRequest_Shall_SubscribeCli
     .returns(true);
 
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   SubscriptionId res;
-  BOOST_CHECK_NO_THROW(res = subHandler->subscribe(channel, dbMock, vsspath.getVSSPath(), "value"));
+  BOOST_CHECK_NO_THROW(res = subHandler->subscribe(channel, dbMock, vsspath, "value"));
 
   BOOST_TEST(res.version() == 4);
 }
@@ -156,18 +244,13 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_SubscribeRequestOnDifferentPaths_Sh
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
   for (unsigned index = 0; index < paths; index++) {
     SubscriptionId res;
 
-    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(channel, dbMock, vsspath[index].getVSSPath(), "value"));
+    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(channel, dbMock, vsspath[index], "value"));
     BOOST_TEST(res.version() == 4);
 
     // check that the value is different from previously returned
@@ -211,18 +294,13 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_SubscribeRequestOnSinglePath_Sha
     .with(mock::any, vsspath)
     .returns(true);
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
   for (auto &ch : channels) {
     SubscriptionId res;
 
-    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(ch, dbMock, vsspath.getVSSPath(), "value"));
+    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(ch, dbMock, vsspath, "value"));
     BOOST_TEST(res.version() == 4);
 
     // check that the value is different from previously returned
@@ -274,11 +352,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_SubscribeRequestOnDifferentPaths
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   unsigned index = 0;
@@ -286,7 +359,7 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_SubscribeRequestOnDifferentPaths
   for (auto &ch : channels) {
     SubscriptionId res;
 
-    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(ch, dbMock, vsspath[index].getVSSPath(), "value"));
+    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(ch, dbMock, vsspath[index], "value"));
     BOOST_TEST(res.version() == 4);
 
     // check that the value is different from previously returned
@@ -329,18 +402,13 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_UnsubscribeRequestOnDifferentPaths_
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
   for (unsigned index = 0; index < paths; index++) {
     SubscriptionId res;
 
-    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(channel, dbMock, vsspath[index].getVSSPath(), "value"));
+    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(channel, dbMock, vsspath[index], "value"));
     BOOST_TEST(res.version() == 4);
 
     // check that the value is different from previously returned
@@ -387,18 +455,13 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_Unsubscribe_Shall_UnsubscribeAll
     .with(mock::any, vsspath)
     .returns(true);
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::set<SubscriptionId> resSet;
   for (auto &ch : channels) {
     SubscriptionId res;
 
-    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(ch, dbMock, vsspath.getVSSPath(), "value"));
+    BOOST_CHECK_NO_THROW(res = subHandler->subscribe(ch, dbMock, vsspath, "value"));
     BOOST_TEST(res.version() == 4);
 
     // check that the value is different from previously returned
@@ -446,18 +509,13 @@ BOOST_AUTO_TEST_CASE(Given_SingleClient_When_MultipleSignalsSubscribedAndUpdated
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::map<unsigned, SubscriptionId> resMap;
   for (unsigned index = 0; index < paths; index++) {
     SubscriptionId subId;
 
-    BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(channel, dbMock, vsspath[index].getVSSPath(), "value"));
+    BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(channel, dbMock, vsspath[index], "value"));
 
     BOOST_TEST(subId.version() == 4);
     resMap[index] = subId;
@@ -537,11 +595,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   // subscribe every client to every signal
@@ -550,7 +603,7 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
     for (unsigned index = 0; index < paths; index++) {
       SubscriptionId subId;
 
-      BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(ch, dbMock, vsspath[index].getVSSPath(), "value"));
+      BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(ch, dbMock, vsspath[index], "value"));
 
       BOOST_TEST(subId.version() == 4);
       resMap[subId] = index;
@@ -666,11 +719,6 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
       .returns(true);
   }
 
-  // load data tree
-  // TODO: remove when this implicit dependency is removed
-  std::ifstream is("test_vss_release_latest.json");
-  is >> dbMock->data_tree__;
-
   // verify
 
   std::vector<SubscriptionId> removedSubId;
@@ -680,7 +728,7 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
     for (unsigned index = 0; index < paths; index++) {
       SubscriptionId subId;
 
-      BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(ch, dbMock, vsspath[index].getVSSPath(), "value"));
+      BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(ch, dbMock, vsspath[index], "value"));
 
       BOOST_TEST(subId.version() == 4);
       resMap[subId] = index;
@@ -734,4 +782,266 @@ BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_MultipleSignalsSubscribedAndUpda
   BOOST_TEST(subHandler->publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, std::to_string(index))) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(Given_SingleClient_When_TokenExpired_Shall_NotNotifyAndUnsubscribe)
+{
+  KuksaChannel channel;
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+
+  // setup
+
+  channel.setConnID(131313);
+  channel.setAuthorized(true);
+
+  // expectations
+
+  MOCK_EXPECT(dbMock->pathExists).once().with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).once().with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).once().with(mock::any, vsspath).returns(true);
+  MOCK_EXPECT(serverMock->SendToConnection).never();
+
+  // verify
+
+  SubscriptionId subId;
+  BOOST_CHECK_NO_THROW(subId = subHandler->subscribe(channel, dbMock, vsspath, "value"));
+
+  // expiring the token also expires the copy stored for the subscription
+  channel.expireToken();
+
+  BOOST_TEST(subHandler->publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, "1")) == 0);
+  usleep(10000); // allow for subthread handler to run
+
+  BOOST_TEST(subHandler->unsubscribeExpired() == 0);
+  BOOST_TEST(subHandler->unsubscribe(subId) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(Given_MultipleDispatchThreads_When_SignalUpdated_Shall_NotifyEachClientInOrder)
+{
+  auto server = std::make_shared<RecordingServer>();
+  SubscriptionHandler handler(logMock, server, authMock, accCheckMock, 4);
+
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  const unsigned clients = 16;
+  const unsigned updates = 20;
+
+  // expectations
+
+  MOCK_EXPECT(dbMock->pathExists).with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, vsspath).returns(true);
+
+  // verify
+
+  for (unsigned client = 0; client < clients; client++) {
+    KuksaChannel channel;
+    channel.setConnID(1000 + client);
+    BOOST_CHECK_NO_THROW(handler.subscribe(channel, dbMock, vsspath, "value"));
+  }
+  for (unsigned index = 0; index < updates; index++) {
+    BOOST_TEST(handler.publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, std::to_string(index))) == 0);
+  }
+  usleep(100000); // allow for dispatch threads to run
+  handler.stopThread();
+
+  BOOST_TEST(server->values.size() == clients);
+  for (const auto &client : server->values) {
+    BOOST_TEST(client.second.size() == updates);
+    for (unsigned index = 0; index < client.second.size(); index++) {
+      BOOST_TEST(client.second[index] == std::to_string(index));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Given_SlowClient_When_QueueFullWithConflation_Shall_ReplaceQueuedValue)
+{
+  auto server = std::make_shared<RecordingServer>();
+  SubscriberQueueConfig config;
+  config.capacity = 4;
+  config.overflowPolicy = VssOverflowPolicy::CONFLATE;
+  SubscriptionHandler handler(logMock, server, authMock, accCheckMock, 1, config);
+
+  std::vector<std::string> values = publishToSlowClient(handler, *server, 10);
+
+  std::vector<std::string> expected{"0", "1", "2", "9"};
+  BOOST_TEST(values == expected, boost::test_tools::per_element());
+  BOOST_TEST(handler.getDispatchStats().conflated == 6u);
+  BOOST_TEST(handler.getDispatchStats().dropped == 0u);
+  BOOST_TEST(server->closed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Given_SlowClient_When_QueueFullWithDropOldest_Shall_KeepNewestValues)
+{
+  auto server = std::make_shared<RecordingServer>();
+  SubscriberQueueConfig config;
+  config.capacity = 4;
+  config.overflowPolicy = VssOverflowPolicy::DROP_OLDEST;
+  SubscriptionHandler handler(logMock, server, authMock, accCheckMock, 1, config);
+
+  std::vector<std::string> values = publishToSlowClient(handler, *server, 10);
+
+  std::vector<std::string> expected{"6", "7", "8", "9"};
+  BOOST_TEST(values == expected, boost::test_tools::per_element());
+  BOOST_TEST(handler.getDispatchStats().dropped == 6u);
+  BOOST_TEST(handler.getDispatchStats().conflated == 0u);
+  BOOST_TEST(server->closed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Given_SlowClient_When_QueueFullWithDisconnect_Shall_CloseConnection)
+{
+  auto server = std::make_shared<RecordingServer>();
+  SubscriberQueueConfig config;
+  config.capacity = 4;
+  config.overflowPolicy = VssOverflowPolicy::DISCONNECT;
+  SubscriptionHandler handler(logMock, server, authMock, accCheckMock, 1, config);
+
+  SubscriptionId subId;
+  std::vector<std::string> values = publishToSlowClient(handler, *server, 10, &subId);
+
+  BOOST_TEST(values.empty());
+  BOOST_TEST(handler.getDispatchStats().disconnected == 1u);
+  // subscription is already gone
+  BOOST_TEST(handler.unsubscribe(subId) == -1);
+  // and the client is told by closing its connection
+  BOOST_TEST(server->closed == std::set<ConnectionId>{1000}, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(Given_GrpcClientNotReading_When_SignalUpdated_Shall_NotifyOtherClients)
+{
+  auto server = std::make_shared<RecordingServer>();
+  SubscriberQueueConfig config;
+  config.capacity = 8;
+  config.overflowPolicy = VssOverflowPolicy::DROP_OLDEST;
+  // both clients share the only dispatch thread
+  SubscriptionHandler handler(logMock, server, authMock, accCheckMock, 1, config);
+
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  const unsigned updates = 200;
+  BlockingStream stream;
+
+  // expectations
+
+  MOCK_EXPECT(dbMock->pathExists).with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, vsspath).returns(true);
+
+  // verify
+
+  KuksaChannel websocketChannel;
+  websocketChannel.setConnID(1000);
+  websocketChannel.setType(KuksaChannel::Type::WEBSOCKET_PLAIN);
+  BOOST_CHECK_NO_THROW(handler.subscribe(websocketChannel, dbMock, vsspath, "value"));
+
+  KuksaChannel grpcChannel;
+  grpcChannel.setConnID(2000);
+  grpcChannel.setType(KuksaChannel::Type::GRPC);
+  grpcChannel.grpcSubsMap = std::make_shared<gRPCSubscriptionMap_t>();
+  grpcChannel.grpcWriter = std::make_shared<VssGrpcStreamWriter>(logMock, &stream, nullptr);
+  SubscriptionId grpcSubId;
+  BOOST_CHECK_NO_THROW(grpcSubId = handler.subscribe(grpcChannel, dbMock, vsspath, "value"));
+  // only the writer of the channel writes to the stream
+  (*grpcChannel.grpcSubsMap)[grpcSubId] = nullptr;
+
+  for (unsigned index = 0; index < updates; index++) {
+    BOOST_TEST(handler.publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, std::to_string(index))) == 0);
+    usleep(1000); // allow for dispatch thread to run
+  }
+  usleep(100000);
+
+  // the blocked stream neither stalls the dispatch thread, nor is it sent
+  // more than the queue of the subscriber holds
+  {
+    std::lock_guard<std::mutex> lock(server->mutex);
+    BOOST_TEST(server->values[1000].size() == updates);
+  }
+  BOOST_TEST(stream.writes == 0u);
+  BOOST_TEST(grpcChannel.grpcWriter->pendingWrites() < updates);
+  BOOST_TEST(handler.getDispatchStats().dropped > 0u);
+
+  stream.release();
+  usleep(100000); // allow for writer and dispatch thread to catch up
+  handler.stopThread();
+  grpcChannel.grpcWriter->close();
+
+  BOOST_TEST(stream.writes + handler.getDispatchStats().dropped == updates);
+}
+
+BOOST_AUTO_TEST_CASE(Given_MultipleClients_When_SignalUpdated_Shall_SerializeNotificationOnce)
+{
+  auto server = std::make_shared<RecordingServer>();
+  SubscriptionHandler handler(logMock, server, authMock, accCheckMock, 4);
+
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+  const unsigned clients = 8;
+  std::map<ConnectionId, std::string> subIds;
+
+  // expectations
+
+  MOCK_EXPECT(dbMock->pathExists).with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, vsspath).returns(true);
+
+  // verify
+
+  for (unsigned client = 0; client < clients; client++) {
+    KuksaChannel channel;
+    channel.setConnID(1000 + client);
+    SubscriptionId subId;
+    BOOST_CHECK_NO_THROW(subId = handler.subscribe(channel, dbMock, vsspath, "value"));
+    subIds[channel.getConnID()] = boost::uuids::to_string(subId);
+  }
+  BOOST_TEST(handler.publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, "42")) == 0);
+  usleep(100000); // allow for dispatch threads to run
+  handler.stopThread();
+
+  // one message for all clients, each with its own subscriptionId
+  BOOST_TEST(server->sharedMessages.size() == 1u);
+  BOOST_TEST(server->values.size() == clients);
+  for (const auto &client : server->subscriptionIds) {
+    BOOST_TEST(client.second.size() == 1u);
+    BOOST_TEST(*client.second.begin() == subIds[client.first]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Given_PrettyPrintSetting_When_SignalUpdated_Shall_FormatNotification)
+{
+  VSSPath vsspath = VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical");
+
+  // expectations
+
+  MOCK_EXPECT(dbMock->pathExists).with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsReadable).with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, vsspath).returns(true);
+
+  // verify
+
+  for (bool pretty : {false, true}) {
+    JsonResponses::setPrettyPrint(pretty);
+    auto server = std::make_shared<RecordingServer>();
+    SubscriptionHandler handler(logMock, server, authMock, accCheckMock);
+    KuksaChannel channel;
+    channel.setConnID(1000);
+    BOOST_CHECK_NO_THROW(handler.subscribe(channel, dbMock, vsspath, "value"));
+    BOOST_TEST(handler.publishForVSSPath(vsspath, "int16", "value", packDataInJson(vsspath, "42")) == 0);
+    usleep(100000); // allow for dispatch thread to run
+    handler.stopThread();
+
+    BOOST_TEST(server->messages.size() == 1u);
+    BOOST_TEST(server->values[1000] == std::vector<std::string>{"42"}, boost::test_tools::per_element());
+    // compact messages have no whitespace outside of values
+    BOOST_TEST((server->messages[0].find_first_of(" \n") != std::string::npos) == pretty);
+  }
+  JsonResponses::setPrettyPrint(false);
+}
+
+BOOST_AUTO_TEST_CASE(Given_OverflowPolicyName_When_Parsed_Shall_ReturnPolicy)
+{
+  VssOverflowPolicy policy = VssOverflowPolicy::CONFLATE;
+  BOOST_TEST(overflowPolicyFromString("drop-oldest", policy));
+  BOOST_TEST((policy == VssOverflowPolicy::DROP_OLDEST));
+  BOOST_TEST(overflowPolicyFromString("disconnect", policy));
+  BOOST_TEST((policy == VssOverflowPolicy::DISCONNECT));
+  BOOST_TEST(overflowPolicyFromString("conflate", policy));
+  BOOST_TEST((policy == VssOverflowPolicy::CONFLATE));
+  BOOST_TEST(!overflowPolicyFromString("latest", policy));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
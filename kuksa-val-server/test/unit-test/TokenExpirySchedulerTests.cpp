@@ -0,0 +1,132 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <turtle/mock.hpp>
+#undef BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+#include <memory>
+
+#include "KuksaChannel.hpp"
+#include "ILoggerMock.hpp"
+#include "kuksa.pb.h"
+
+#include "TokenExpiryScheduler.hpp"
+
+namespace {
+  // common resources for tests
+  std::shared_ptr<ILoggerMock> logMock;
+
+  std::unique_ptr<TokenExpiryScheduler> scheduler;
+  unsigned handlerCalls;
+  int64_t now;
+
+  // Pre-test initialization and post-test desctruction of common resources
+  struct TestSuiteFixture {
+    TestSuiteFixture() {
+      logMock = std::make_shared<ILoggerMock>();
+      MOCK_EXPECT(logMock->Log).at_least(0); // ignore log events
+
+      scheduler = std::make_unique<TokenExpiryScheduler>(logMock);
+      handlerCalls = 0;
+      scheduler->setExpiryHandler([]() { handlerCalls++; });
+      now = TokenExpiryScheduler::now();
+    }
+    ~TestSuiteFixture() {
+      scheduler.reset();
+      logMock.reset();
+    }
+  };
+}
+
+// Define name of test suite and define test suite fixture for pre and post test handling
+BOOST_FIXTURE_TEST_SUITE(TokenExpirySchedulerTests, TestSuiteFixture)
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_ExpReached_Shall_ExpireChannelAndCopies) {
+  KuksaChannel channel;
+  channel.setAuthorized(true);
+  KuksaChannel copy = channel;
+
+  scheduler->schedule(channel, now + 5);
+
+  BOOST_TEST(scheduler->advance(now + 4) == 0u);
+  BOOST_TEST(channel.isAuthorized() == true);
+  BOOST_TEST(handlerCalls == 0u);
+
+  BOOST_TEST(scheduler->advance(now + 5) == 1u);
+  BOOST_TEST(channel.isAuthorized() == false);
+  BOOST_TEST(copy.isTokenExpired() == true);
+  BOOST_TEST(handlerCalls == 1u);
+  BOOST_TEST(scheduler->size() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Given_AuthorizedChannel_When_ExpMoreThanOneRoundAhead_Shall_ExpireOnlyAtExp) {
+  KuksaChannel channel;
+  channel.setAuthorized(true);
+
+  scheduler->schedule(channel, now + 3 * TokenExpiryScheduler::SLOTS + 7);
+
+  BOOST_TEST(scheduler->advance(now + TokenExpiryScheduler::SLOTS + 7) == 0u);
+  BOOST_TEST(scheduler->advance(now + 2 * TokenExpiryScheduler::SLOTS + 7) == 0u);
+  BOOST_TEST(channel.isTokenExpired() == false);
+
+  BOOST_TEST(scheduler->advance(now + 3 * TokenExpiryScheduler::SLOTS + 7) == 1u);
+  BOOST_TEST(channel.isTokenExpired() == true);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ReauthorizedChannel_When_OldTokenExpires_Shall_KeepNewAuthorization) {
+  KuksaChannel channel;
+  channel.setAuthorized(true);
+  KuksaChannel oldCopy = channel;
+  scheduler->schedule(channel, now + 5);
+
+  channel.setAuthorized(true);
+  scheduler->schedule(channel, now + 50);
+
+  BOOST_TEST(scheduler->advance(now + 5) == 1u);
+  BOOST_TEST(oldCopy.isTokenExpired() == true);
+  BOOST_TEST(channel.isAuthorized() == true);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ClosedChannel_When_SlotPassed_Shall_DropIt) {
+  {
+    KuksaChannel channel;
+    channel.setAuthorized(true);
+    scheduler->schedule(channel, now + 5);
+  }
+  BOOST_TEST(scheduler->size() == 1u);
+
+  BOOST_TEST(scheduler->advance(now + 5) == 0u);
+  BOOST_TEST(scheduler->size() == 0u);
+  BOOST_TEST(handlerCalls == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Given_UnauthorizedChannel_When_Schedule_Shall_Ignore) {
+  KuksaChannel channel;
+
+  scheduler->schedule(channel, now + 5);
+
+  BOOST_TEST(scheduler->size() == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
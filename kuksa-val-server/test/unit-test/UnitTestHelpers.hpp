@@ -26,12 +26,32 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <jsoncons/json.hpp>
+#include "ISubscriptionHandler.hpp"
 #include "JsonResponses.hpp"
 #include "VSSPath.hpp"
 
 #include <string>
 #include <boost/regex.hpp>
 
+// Subscription handler dropping every notification. Unlike the mock it may be
+// called from several threads
+class NullSubscriptionHandler : public ISubscriptionHandler {
+  public:
+    SubscriptionId subscribe(KuksaChannel&, std::shared_ptr<IVssDatabase>,
+                             const VSSPath&, const std::string&) override { return SubscriptionId(); }
+    int unsubscribe(SubscriptionId) override { return 0; }
+    int unsubscribeAll(KuksaChannel) override { return 0; }
+    int unsubscribeExpired() override { return 0; }
+    int publishForVSSPath(const VSSPath, const std::string&, const std::string&, const jsoncons::json&) override { return 0; }
+    int publishForVSSPaths(const std::vector<VssSignalUpdate>&, const std::string&) override { return 0; }
+
+    std::shared_ptr<IServer> getServer() override { return nullptr; }
+    int startThread() override { return 0; }
+    int stopThread() override { return 0; }
+    bool isThreadRunning() const override { return false; }
+    void addPublisher(std::shared_ptr<IPublisher>) override {}
+};
+
 //Verifies a timestamp exists and is of type string.
 static inline void verify_timestamp(const jsoncons::json &result) {
   std::string timestampKeyWord = "ts";
@@ -21,6 +21,10 @@
 
 
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 #include "VSSPath.hpp"
 
@@ -172,5 +176,90 @@ BOOST_AUTO_TEST_CASE(From_Auto_Empty) {
     BOOST_TEST(p.isGen1Origin() == false);
 }
 
+BOOST_AUTO_TEST_CASE(Interned_Gen1_Gen2_Same_Entry) {
+    VSSPath::internVSSGen2("Vehicle/Cabin/Door/Row1/Left/IsOpen");
+    VSSPath gen1 = VSSPath::fromVSS("Vehicle.Cabin.Door.Row1.Left.IsOpen");
+    VSSPath gen2 = VSSPath::fromVSS("Vehicle/Cabin/Door/Row1/Left/IsOpen");
+    BOOST_TEST(gen1.id() != 0u);
+    BOOST_TEST(gen1.id() == gen2.id());
+    BOOST_TEST(gen1.hash() == gen2.hash());
+    BOOST_TEST((gen1 == gen2));
+    BOOST_TEST(std::hash<VSSPath>()(gen1) == std::hash<VSSPath>()(gen2));
+    BOOST_TEST(gen1.isGen1Origin() == true);
+    BOOST_TEST(gen2.isGen1Origin() == false);
+    BOOST_TEST(gen1.to_string() == "Vehicle.Cabin.Door.Row1.Left.IsOpen");
+    BOOST_TEST(gen2.to_string() == "Vehicle/Cabin/Door/Row1/Left/IsOpen");
+}
+
+BOOST_AUTO_TEST_CASE(Interned_Known_Path_Not_Added_Again) {
+    VSSPath first = VSSPath::internVSSGen2("Vehicle/Body/Trunk/IsOpen");
+    size_t count = VSSPath::internedCount();
+    VSSPath again = VSSPath::fromVSS("Vehicle.Body.Trunk.IsOpen");
+    VSSPath json = VSSPath::fromJSON(first.getJSONPath(), false);
+    VSSPath interned = VSSPath::internVSSGen2("Vehicle/Body/Trunk/IsOpen");
+    BOOST_TEST(VSSPath::internedCount() == count);
+    BOOST_TEST(again.id() == first.id());
+    BOOST_TEST(json.id() == first.id());
+    BOOST_TEST(interned.id() == first.id());
+}
+
+BOOST_AUTO_TEST_CASE(Parsed_Unknown_Path_Not_Interned) {
+    size_t count = VSSPath::internedCount();
+    VSSPath parsed = VSSPath::fromVSS("Vehicle.Body.Hood.IsOpen");
+    BOOST_TEST(VSSPath::internedCount() == count);
+    BOOST_TEST(parsed.id() == 0u);
+
+    // still equal to the path, once the model adds it
+    VSSPath interned = VSSPath::internVSSGen2("Vehicle/Body/Hood/IsOpen");
+    BOOST_TEST(VSSPath::internedCount() == count + 1);
+    BOOST_TEST(interned.id() != 0u);
+    BOOST_TEST((parsed == interned));
+    BOOST_TEST(parsed.hash() == interned.hash());
+    BOOST_TEST(VSSPath::fromVSS("Vehicle.Body.Hood.IsOpen").id() == interned.id());
+}
+
+BOOST_AUTO_TEST_CASE(Interned_Different_Paths) {
+    VSSPath p1 = VSSPath::internVSSGen2("Vehicle/Speed");
+    VSSPath p2 = VSSPath::internVSSGen2("Vehicle/Speed/");
+    BOOST_TEST(p1.id() != p2.id());
+    BOOST_TEST((p1 != p2));
+    BOOST_TEST((p1 < p2));
+}
+
+BOOST_AUTO_TEST_CASE(Interned_Lazy_Paths_Shared) {
+    VSSPath p1 = VSSPath::internVSSGen2("Vehicle/Powertrain/Range");
+    VSSPath p2 = VSSPath::fromVSS("Vehicle.Powertrain.Range");
+    // materialized once per path, so all handles return the same string
+    BOOST_TEST(&p1.getJSONPath() == &p2.getJSONPath());
+    BOOST_TEST(&p1.getVSSGen1Path() == &p2.getVSSGen1Path());
+    BOOST_TEST(p2.getJSONPath() == "$['Vehicle']['children']['Powertrain']['children']['Range']");
+}
+
+BOOST_AUTO_TEST_CASE(Long_Gen1_Path) {
+    std::string gen1 = "Vehicle";
+    for (int i = 0; i < 40; i++) {
+        gen1 += ".Branch" + std::to_string(i);
+    }
+    std::string gen2 = gen1;
+    std::replace(gen2.begin(), gen2.end(), '.', '/');
+
+    VSSPath p = VSSPath::fromVSS(gen1);
+    BOOST_TEST(gen1.size() > VSSPath::MAX_INLINE_PATH);
+    BOOST_TEST(p.getVSSPath() == gen2);
+    BOOST_TEST(p.getVSSGen1Path() == gen1);
+    BOOST_TEST((p == VSSPath::fromVSS(gen2)));
+}
+
+BOOST_AUTO_TEST_CASE(From_Id) {
+    VSSPath::internVSSGen2("Vehicle/Cabin/Lights/IsDomeOn");
+    VSSPath p = VSSPath::fromVSS("Vehicle.Cabin.Lights.IsDomeOn");
+    VSSPath q = VSSPath::fromId(p.id());
+    BOOST_TEST((q == p));
+    BOOST_TEST(q.getVSSPath() == "Vehicle/Cabin/Lights/IsDomeOn");
+    BOOST_TEST(q.isGen1Origin() == false);
+    BOOST_CHECK_THROW(VSSPath::fromId(0), std::out_of_range);
+    BOOST_CHECK_THROW(VSSPath::fromId(std::numeric_limits<uint32_t>::max()), std::out_of_range);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -41,6 +41,7 @@
 #include "JsonResponses.hpp"
 #include "VssCommandProcessor.hpp"
 #include "VssDatabase.hpp"
+#include "VssSignalDescriptor.hpp"
 
 #include "exception.hpp"
 
@@ -488,6 +489,24 @@ BOOST_AUTO_TEST_CASE(float_array) {
   value.push_back("-4e38");
   BOOST_CHECK_THROW(db->checkAndSanitizeType(meta, value), outOfBoundException);
 }
+
+BOOST_AUTO_TEST_CASE(array_limits) {
+  auto descriptor = VssSignalDescriptor::compile(createDoublelimitedMeta("int16[]", -100, 100));
+  jsoncons::json value(jsoncons::json_array_arg, {"-100", "0", "100"});
+  VssValue native = descriptor->sanitize(value);
+  BOOST_TEST(native.arraySize() == 3);
+  BOOST_TEST(native.arrayData<int16_t>()[0] == -100);
+  BOOST_TEST(native.arrayData<int16_t>()[2] == 100);
+
+  value.push_back("101");
+  BOOST_CHECK_THROW(descriptor->sanitize(value), outOfBoundException);
+
+  jsoncons::json notAnArray = "5";
+  BOOST_CHECK_THROW(descriptor->sanitize(notAnArray), outOfBoundException);
+
+  jsoncons::json empty(jsoncons::json_array_arg);
+  BOOST_TEST(descriptor->sanitize(empty).arraySize() == 0);
+}
 //Only "limited" double tests, as "long double" might not be longer than double
 //on all platforms, using som "bigint" library is to expensive
 BOOST_AUTO_TEST_CASE(double_limits) {
@@ -581,4 +600,43 @@ BOOST_AUTO_TEST_CASE(bogus) {
 }
 
 
+BOOST_AUTO_TEST_CASE(descriptor_limits_native) {
+  auto descriptor = VssSignalDescriptor::compile(createDoublelimitedMeta("int16", -100, 100));
+  BOOST_TEST((descriptor->datatype() == VssDatatype::INT16));
+
+  jsoncons::json value = "-42";
+  VssValue native = descriptor->sanitize(value);
+  BOOST_TEST(native.get<int16_t>() == -42);
+  BOOST_TEST(value.as<int>() == -42);
+
+  value = "-101";
+  BOOST_CHECK_THROW(descriptor->sanitize(value), outOfBoundException);
+}
+
+BOOST_AUTO_TEST_CASE(descriptor_invalid_limit) {
+  jsoncons::json meta = createUnlimitedMeta("uint8");
+  meta["max"] = "not a number";
+  auto descriptor = VssSignalDescriptor::compile(meta);
+  jsoncons::json value = "5";
+  BOOST_CHECK_THROW(descriptor->sanitize(value), genException);
+}
+
+BOOST_AUTO_TEST_CASE(allowedtype_not_a_string) {
+  jsoncons::json meta = createAllowedMeta("[\"1\", \"2\"]");
+  jsoncons::json value = 1;
+  BOOST_CHECK_THROW(db->checkAndSanitizeType(meta, value), outOfBoundException);
+}
+
+BOOST_AUTO_TEST_CASE(leaf_limits_from_tree) {
+  VSSPath path = VSSPath::fromVSSGen1("Vehicle.Chassis.SteeringWheel.Extension");
+  jsoncons::json value = 101;
+  BOOST_CHECK_THROW(db->setSignal(path, "value", value), outOfBoundException);
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).once().returns(0);
+  value = "100";
+  db->setSignal(path, "value", value);
+  BOOST_TEST(db->getSignal(path, "value")["dp"]["value"].as<int>() == 100);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
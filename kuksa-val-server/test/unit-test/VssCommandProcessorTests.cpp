@@ -25,6 +25,7 @@
 #undef BOOST_BIND_GLOBAL_PLACEHOLDERS
 
 
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -304,6 +305,98 @@ BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_UserAuthorized_Shall_ReturnValue)
   BOOST_TEST(res == jsonGetResponseForSignal);
 }
 
+BOOST_AUTO_TEST_CASE(Given_ValidMultiGetQuery_When_UserAuthorized_Shall_ReadAllAtOnce)
+{
+  KuksaChannel channel;
+
+  string requestId = "1";
+  VSSPath dtc1 = VSSPath::fromVSSGen1("Signal.OBD.DTC1");
+  VSSPath dtc2 = VSSPath::fromVSSGen1("Signal.OBD.DTC2");
+  VSSPath dtc3 = VSSPath::fromVSSGen1("Signal.OBD.DTC3");
+
+  // setup
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonGetRequest = jsoncons::json::parse(R"(
+    {"action": "get", "requestId": "1", "paths": ["Signal.OBD.DTC1", "Signal.OBD.*"]}
+  )");
+
+  jsoncons::json jsonSignals = jsoncons::json::parse(R"(
+    [{"path": "Signal.OBD.DTC1", "dp": {"value": "1", "ts": "1970-01-01T00:00:00.0Z"}},
+     {"path": "Signal.OBD.DTC2", "dp": {"value": "2", "ts": "1970-01-01T00:00:00.0Z"}},
+     {"path": "Signal.OBD.DTC3", "dp": {"value": "3", "ts": "1970-01-01T00:00:00.0Z"}}]
+  )");
+
+  jsoncons::json jsonGetResponse;
+  jsonGetResponse["action"] = "get";
+  jsonGetResponse["requestId"] = requestId;
+  jsonGetResponse["data"] = jsonSignals;
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .once()
+    .with(mock::equal(dtc1))
+    .returns(std::list<VSSPath>{dtc1});
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .once()
+    .with(mock::equal(VSSPath::fromVSSGen1("Signal.OBD.*")))
+    .returns(std::list<VSSPath>{dtc2, dtc3});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).exactly(3).returns(true);
+  MOCK_EXPECT(dbMock->pathIsAttributable).exactly(3).returns(true);
+  MOCK_EXPECT(dbMock->getSignal).never();
+  MOCK_EXPECT(dbMock->getSignals)
+    .once()
+    .with(mock::call([&](const VssGetPairs &pairs) {
+            return pairs.size() == 3 && std::get<0>(pairs[0]) == dtc1 && std::get<0>(pairs[2]) == dtc3 &&
+                   std::get<1>(pairs[1]) == "value";
+          }), true)
+    .returns(jsonSignals);
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetRequest.as_string(), channel);
+
+  // verify
+  verify_and_erase_timestamp(res);
+
+  BOOST_TEST(res == jsonGetResponse);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidMultiGetQuery_When_OnePathNotReadable_Shall_ReadNothing)
+{
+  KuksaChannel channel;
+
+  VSSPath dtc1 = VSSPath::fromVSSGen1("Signal.OBD.DTC1");
+  VSSPath dtc2 = VSSPath::fromVSSGen1("Signal.OBD.DTC2");
+
+  // setup
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonGetRequest = jsoncons::json::parse(R"(
+    {"action": "get", "requestId": "1", "paths": ["Signal.OBD.DTC1", "Signal.OBD.DTC2"]}
+  )");
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths).with(mock::equal(dtc1)).returns(std::list<VSSPath>{dtc1});
+  MOCK_EXPECT(dbMock->getLeafPaths).with(mock::equal(dtc2)).returns(std::list<VSSPath>{dtc2});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, mock::equal(dtc1)).returns(true);
+  MOCK_EXPECT(accCheckMock->checkReadAccess).with(mock::any, mock::equal(dtc2)).returns(false);
+  MOCK_EXPECT(dbMock->pathIsAttributable).returns(true);
+  MOCK_EXPECT(dbMock->getSignals).never();
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(res.contains("error"));
+  BOOST_TEST(res["error"]["number"].as<std::string>() == "403");
+}
+
 BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_NoValueFromDB_Shall_ReturnError)
 {
   KuksaChannel channel;
@@ -356,6 +449,495 @@ BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_NoValueFromDB_Shall_ReturnError)
   BOOST_TEST(res == jsonPathNotFound);
 }
 
+///////////////////////////
+// Test GET HISTORY handling
+
+BOOST_AUTO_TEST_CASE(Given_ValidGetHistoryQuery_When_UserAuthorized_Shall_ReturnSamplesInRange)
+{
+  KuksaChannel channel;
+
+  jsoncons::json jsonGetHistoryRequest;
+  jsoncons::json jsonSignalData;
+  jsoncons::json jsonSignalDataPoint;
+  jsoncons::json jsonGetHistoryResponse;
+
+  string requestId = "1";
+  std::string path{"Vehicle.Speed"};
+  VSSPath vssPath = VSSPath::fromVSS(path);
+
+  // setup
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonGetHistoryRequest["action"] = "getHistory";
+  jsonGetHistoryRequest["path"] = path;
+  jsonGetHistoryRequest["requestId"] = requestId;
+  jsonGetHistoryRequest["startTime"] = 1000;
+  jsonGetHistoryRequest["endTime"] = 2000;
+
+  jsonSignalData["path"] = path;
+  jsonSignalDataPoint["value"] = "100";
+  jsonSignalDataPoint["ts"] = "1970-01-01T00:00:01.500000000Z";
+  jsonSignalData["dp"] = jsoncons::json::array();
+  jsonSignalData["dp"].push_back(jsonSignalDataPoint);
+
+  jsonGetHistoryResponse["action"] = "getHistory";
+  jsonGetHistoryResponse["requestId"] = requestId;
+  jsonGetHistoryResponse["data"] = jsonSignalData;
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .once()
+    .with(mock::equal(vssPath))
+    .returns(std::list<VSSPath>{vssPath});
+  MOCK_EXPECT(accCheckMock->checkReadAccess)
+    .once()
+    .with(mock::any, mock::equal(vssPath))
+    .returns(true);
+  // ms of the request are converted to an inclusive ns range
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(vssPath, 1000000000u, 2000999999u, true)
+    .returns(jsonSignalData);
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+
+  // verify
+  verify_and_erase_timestamp(res);
+
+  BOOST_TEST(res == jsonGetHistoryResponse);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidGetHistoryQuery_When_HistoryNotRecorded_Shall_ReturnError)
+{
+  KuksaChannel channel;
+  jsoncons::json jsonGetHistoryRequest;
+
+  std::string path{"Vehicle.Speed"};
+  VSSPath vssPath = VSSPath::fromVSS(path);
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonGetHistoryRequest["action"] = "getHistory";
+  jsonGetHistoryRequest["path"] = path;
+  jsonGetHistoryRequest["requestId"] = "1";
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths).once().returns(std::list<VSSPath>{vssPath});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).once().returns(true);
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(vssPath, 0u, std::numeric_limits<uint64_t>::max(), true)
+    .throws(notSetException("History of Vehicle/Speed is not recorded."));
+
+  auto res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+
+  BOOST_TEST(res["action"].as<string>() == "getHistory");
+  BOOST_TEST(res["error"]["number"].as<string>() == "404");
+}
+
+BOOST_AUTO_TEST_CASE(Given_GetHistoryQueryForBranch_When_SomeLeafsNotRecorded_Shall_ReturnRecordedLeafs)
+{
+  KuksaChannel channel;
+  jsoncons::json jsonGetHistoryRequest;
+  jsoncons::json jsonSignalData;
+
+  std::string path{"Vehicle.Acceleration"};
+  VSSPath vssPath = VSSPath::fromVSS(path);
+  VSSPath lateral = VSSPath::fromVSS("Vehicle.Acceleration.Lateral");
+  VSSPath vertical = VSSPath::fromVSS("Vehicle.Acceleration.Vertical");
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonGetHistoryRequest["action"] = "getHistory";
+  jsonGetHistoryRequest["path"] = path;
+  jsonGetHistoryRequest["requestId"] = "1";
+  jsonSignalData["path"] = "Vehicle.Acceleration.Vertical";
+  jsonSignalData["dp"] = jsoncons::json::array();
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .once()
+    .with(mock::equal(vssPath))
+    .returns(std::list<VSSPath>{lateral, vertical});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).exactly(2).returns(true);
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(lateral, 0u, std::numeric_limits<uint64_t>::max(), true)
+    .throws(notSetException("History of Vehicle/Acceleration/Lateral is not recorded."));
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(vertical, 0u, std::numeric_limits<uint64_t>::max(), true)
+    .returns(jsonSignalData);
+
+  auto res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+
+  BOOST_TEST(!res.contains("error"));
+  BOOST_TEST_REQUIRE(res["data"].size() == 1u);
+  BOOST_TEST(res["data"][0] == jsonSignalData);
+}
+
+BOOST_AUTO_TEST_CASE(Given_GetHistoryQueryForBranch_When_NoLeafRecorded_Shall_ReturnError)
+{
+  KuksaChannel channel;
+  jsoncons::json jsonGetHistoryRequest;
+
+  std::string path{"Vehicle.Acceleration"};
+  VSSPath lateral = VSSPath::fromVSS("Vehicle.Acceleration.Lateral");
+  VSSPath vertical = VSSPath::fromVSS("Vehicle.Acceleration.Vertical");
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonGetHistoryRequest["action"] = "getHistory";
+  jsonGetHistoryRequest["path"] = path;
+  jsonGetHistoryRequest["requestId"] = "1";
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths).once().returns(std::list<VSSPath>{lateral, vertical});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).exactly(2).returns(true);
+  MOCK_EXPECT(dbMock->getHistory)
+    .exactly(2)
+    .throws(notSetException("History is not recorded."));
+
+  auto res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+
+  BOOST_TEST(res["action"].as<string>() == "getHistory");
+  BOOST_TEST(res["error"]["number"].as<string>() == "404");
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidGetHistoryQuery_When_TimesBeyondRange_Shall_ClampRange)
+{
+  KuksaChannel channel;
+  jsoncons::json jsonGetHistoryRequest;
+  jsoncons::json jsonSignalData;
+
+  std::string path{"Vehicle.Speed"};
+  VSSPath vssPath = VSSPath::fromVSS(path);
+  // latest ms whose last ns still fits into uint64_t
+  uint64_t maxMs = 18446744073708u;
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonGetHistoryRequest["action"] = "getHistory";
+  jsonGetHistoryRequest["path"] = path;
+  jsonGetHistoryRequest["requestId"] = "1";
+  jsonSignalData["path"] = path;
+  jsonSignalData["dp"] = jsoncons::json::array();
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths).exactly(3).returns(std::list<VSSPath>{vssPath});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).exactly(3).returns(true);
+
+  // the last representable ms is still inclusive
+  jsonGetHistoryRequest["startTime"] = maxMs;
+  jsonGetHistoryRequest["endTime"] = maxMs;
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(vssPath, 18446744073708000000u, 18446744073708999999u, true)
+    .returns(jsonSignalData);
+  auto res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+  BOOST_TEST(!res.contains("error"));
+
+  // an end beyond is open ended instead of wrapping around
+  jsonGetHistoryRequest["startTime"] = 0;
+  jsonGetHistoryRequest["endTime"] = maxMs + 1;
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(vssPath, 0u, std::numeric_limits<uint64_t>::max(), true)
+    .returns(jsonSignalData);
+  res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+  BOOST_TEST(!res.contains("error"));
+
+  // a start beyond matches no sample
+  jsonGetHistoryRequest["startTime"] = std::numeric_limits<uint64_t>::max();
+  jsonGetHistoryRequest.erase("endTime");
+  MOCK_EXPECT(dbMock->getHistory)
+    .once()
+    .with(vssPath, std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max(), true)
+    .returns(jsonSignalData);
+  res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+  BOOST_TEST(!res.contains("error"));
+}
+
+BOOST_AUTO_TEST_CASE(Given_GetHistoryQuery_When_StartTimeNegative_Shall_ReturnError)
+{
+  KuksaChannel channel;
+  jsoncons::json jsonGetHistoryRequest;
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonGetHistoryRequest["action"] = "getHistory";
+  jsonGetHistoryRequest["path"] = "Vehicle.Speed";
+  jsonGetHistoryRequest["requestId"] = "1";
+  jsonGetHistoryRequest["startTime"] = -1;
+
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+
+  auto res = processor->processQuery(jsonGetHistoryRequest.as_string(), channel);
+
+  BOOST_TEST(res["action"].as<string>() == "getHistory");
+  BOOST_TEST(res["error"]["number"].as<string>() == "400");
+}
+
+///////////////////////////
+// Test resolve and requests by id
+
+BOOST_AUTO_TEST_CASE(Given_ValidResolveQuery_When_PathIsBranch_Shall_ReturnIdsOfLeafs)
+{
+  KuksaChannel channel;
+
+  // ids are only assigned to paths of the model
+  VSSPath::internVSSGen2("Signal/OBD/DTC1");
+  VSSPath::internVSSGen2("Signal/OBD/DTC2");
+  VSSPath dtc1 = VSSPath::fromVSSGen1("Signal.OBD.DTC1");
+  VSSPath dtc2 = VSSPath::fromVSSGen1("Signal.OBD.DTC2");
+
+  channel.setAuthorized(false);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonResolveRequest = jsoncons::json::parse(R"(
+    {"action": "resolve", "requestId": "1", "path": "Signal.OBD"}
+  )");
+
+  jsoncons::json jsonExpected;
+  jsonExpected["action"] = "resolve";
+  jsonExpected["requestId"] = "1";
+  jsonExpected["data"] = jsoncons::json::array();
+  jsoncons::json entry;
+  entry["path"] = "Signal.OBD.DTC1";
+  entry["id"] = dtc1.id();
+  jsonExpected["data"].push_back(entry);
+  entry["path"] = "Signal.OBD.DTC2";
+  entry["id"] = dtc2.id();
+  jsonExpected["data"].push_back(entry);
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths)
+    .once()
+    .with(mock::equal(VSSPath::fromVSSGen1("Signal.OBD")))
+    .returns(std::list<VSSPath>{dtc1, dtc2});
+  // access is checked when the ids are used
+  MOCK_EXPECT(accCheckMock->checkReadAccess).never();
+
+  // run UUT
+  auto res = processor->processQuery(jsonResolveRequest.as_string(), channel);
+
+  // verify
+  verify_and_erase_timestamp(res);
+
+  BOOST_TEST(dtc1.id() != dtc2.id());
+  BOOST_TEST(res == jsonExpected);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidResolveQuery_When_PathHasNoId_Shall_ReturnError)
+{
+  KuksaChannel channel;
+
+  // not part of the model, as if the path table was full when it was added
+  VSSPath noId = VSSPath::fromVSSGen1("Signal.OBD.NotInterned");
+
+  channel.setAuthorized(false);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonResolveRequest = jsoncons::json::parse(R"(
+    {"action": "resolve", "requestId": "1", "path": "Signal.OBD.NotInterned"}
+  )");
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths).once().returns(std::list<VSSPath>{noId});
+
+  // run UUT
+  auto res = processor->processQuery(jsonResolveRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(noId.id() == 0u);
+  BOOST_TEST(res.contains("error"));
+  BOOST_TEST(res["error"]["number"].as<std::string>() == "503");
+  BOOST_TEST(!res.contains("data"));
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidMultiGetQuery_When_GivenById_Shall_ReturnIds)
+{
+  KuksaChannel channel;
+
+  VSSPath dtc1 = VSSPath::internVSSGen2("Signal/OBD/DTC1");
+  VSSPath dtc2 = VSSPath::internVSSGen2("Signal/OBD/DTC2");
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonGetRequest;
+  jsonGetRequest["action"] = "get";
+  jsonGetRequest["requestId"] = "1";
+  jsonGetRequest["paths"] = jsoncons::json::array();
+  jsonGetRequest["paths"].push_back("Signal.OBD.DTC1");
+  jsonGetRequest["ids"] = jsoncons::json::array();
+  jsonGetRequest["ids"].push_back(dtc2.id());
+
+  jsoncons::json jsonSignals = jsoncons::json::parse(R"(
+    [{"path": "Signal.OBD.DTC1", "dp": {"value": "1", "ts": "1970-01-01T00:00:00.0Z"}},
+     {"path": "Signal/OBD/DTC2", "dp": {"value": "2", "ts": "1970-01-01T00:00:00.0Z"}}]
+  )");
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->getLeafPaths).with(mock::equal(dtc1)).returns(std::list<VSSPath>{dtc1});
+  MOCK_EXPECT(dbMock->getLeafPaths).with(mock::equal(dtc2)).returns(std::list<VSSPath>{dtc2});
+  MOCK_EXPECT(accCheckMock->checkReadAccess).exactly(2).returns(true);
+  MOCK_EXPECT(dbMock->pathIsAttributable).exactly(2).returns(true);
+  MOCK_EXPECT(dbMock->getSignals)
+    .once()
+    .with(mock::call([&](const VssGetPairs &pairs) {
+            return pairs.size() == 2 && std::get<0>(pairs[0]) == dtc1 && std::get<0>(pairs[1]) == dtc2;
+          }), true)
+    .returns(jsonSignals);
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(!res.contains("error"));
+  BOOST_TEST(!res["data"][0].contains("id"));
+  BOOST_TEST(res["data"][1]["id"].as<uint32_t>() == dtc2.id());
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_IdUnknown_Shall_ReturnError)
+{
+  KuksaChannel channel;
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonGetRequest;
+  jsonGetRequest["action"] = "get";
+  jsonGetRequest["requestId"] = "1";
+  // highest id there is, the tests never intern that many paths
+  jsonGetRequest["id"] = VSSPath::MAX_INTERNED_PATHS;
+
+  // expectations
+  MOCK_EXPECT(logMock->Log);
+  MOCK_EXPECT(dbMock->getLeafPaths).never();
+  MOCK_EXPECT(dbMock->getSignal).never();
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(res.contains("error"));
+  BOOST_TEST(res["error"]["number"].as<std::string>() == "404");
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_IdAboveLimit_Shall_ReturnError)
+{
+  KuksaChannel channel;
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonGetRequest;
+  jsonGetRequest["action"] = "get";
+  jsonGetRequest["requestId"] = "1";
+  jsonGetRequest["id"] = VSSPath::MAX_INTERNED_PATHS + 1;
+
+  // expectations
+  MOCK_EXPECT(logMock->Log);
+  MOCK_EXPECT(dbMock->getLeafPaths).never();
+  MOCK_EXPECT(dbMock->getSignal).never();
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetRequest.as_string(), channel);
+
+  // verify, rejected by the schema, not as unknown path
+  BOOST_TEST(res.contains("error"));
+  BOOST_TEST(res["error"]["number"].as<std::string>() == "400");
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidGetQuery_When_IdAboveUint32_Shall_ReturnError)
+{
+  KuksaChannel channel;
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonGetRequest;
+  jsonGetRequest["action"] = "get";
+  jsonGetRequest["requestId"] = "1";
+  // would be id 1, if narrowed to 32 bit
+  jsonGetRequest["id"] = uint64_t(std::numeric_limits<uint32_t>::max()) + 2;
+
+  // expectations
+  MOCK_EXPECT(logMock->Log);
+  MOCK_EXPECT(dbMock->getLeafPaths).never();
+  MOCK_EXPECT(dbMock->getSignal).never();
+
+  // run UUT
+  auto res = processor->processQuery(jsonGetRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(res.contains("error"));
+  BOOST_TEST(res["error"]["number"].as<std::string>() == "400");
+}
+
+BOOST_AUTO_TEST_CASE(Given_ValidSetQuery_When_GivenById_Shall_UpdateValue)
+{
+  KuksaChannel channel;
+
+  VSSPath vsspath = VSSPath::internVSSGen2("Vehicle/OBD/DTC1");
+
+  std::string perm = "{\"Vehicle.OBD.*\" : \"wr\"}";
+  channel.setPermissions(perm);
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonSetRequest;
+  jsonSetRequest["action"] = "set";
+  jsonSetRequest["id"] = vsspath.id();
+  jsonSetRequest["value"] = 123;
+  jsonSetRequest["requestId"] = "1";
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->pathExists).with(vsspath).returns(true);
+  MOCK_EXPECT(accCheckMock->checkWriteAccess)
+    .once()
+    .with(mock::any, mock::equal(vsspath))
+    .returns(true);
+  MOCK_EXPECT(dbMock->pathIsWritable).with(vsspath).returns(true);
+  MOCK_EXPECT(dbMock->pathIsAttributable).once().with(vsspath, "value").returns(true);
+  MOCK_EXPECT(dbMock->setSignal)
+    .once()
+    .with(vsspath, "value", mock::any).returns(jsoncons::json());
+
+  // run UUT
+  auto res = processor->processQuery(jsonSetRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(!res.contains("error"));
+  BOOST_TEST(res["action"].as<std::string>() == "set");
+}
+
 ///////////////////////////
 // Test SET handling
 
@@ -661,6 +1243,56 @@ BOOST_AUTO_TEST_CASE(Given_ValidSetQuery_When_UserAuthorized_Shall_UpdateValue)
   BOOST_TEST(res == jsonSignalValue);
 }
 
+BOOST_AUTO_TEST_CASE(Given_ValidMultiSetQuery_When_UserAuthorized_Shall_SetAllAtOnce)
+{
+  KuksaChannel channel;
+
+  jsoncons::json jsonSetRequest;
+  jsoncons::json jsonExpected;
+
+  string requestId = "1";
+  VSSPath dtc1 = VSSPath::fromVSSGen1("Vehicle.OBD.DTC1");
+  VSSPath dtc2 = VSSPath::fromVSSGen1("Vehicle.OBD.DTC2");
+
+  // setup
+  std::string perm = "{\"Vehicle.OBD.*\" : \"wr\"}";
+  channel.setPermissions(perm);
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsonSetRequest = jsoncons::json::parse(R"(
+    {"action": "set", "requestId": "1", "values": [
+      {"path": "Vehicle.OBD.DTC1", "value": "P0001"},
+      {"path": "Vehicle.OBD.DTC2", "value": "P0002"}]}
+  )");
+
+  jsonExpected["action"] = "set";
+  jsonExpected["requestId"] = requestId;
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  MOCK_EXPECT(dbMock->pathExists).returns(true);
+  MOCK_EXPECT(accCheckMock->checkWriteAccess).exactly(2).returns(true);
+  MOCK_EXPECT(dbMock->pathIsWritable).returns(true);
+  MOCK_EXPECT(dbMock->pathIsAttributable).exactly(2).returns(true);
+  MOCK_EXPECT(dbMock->setSignal).never();
+  MOCK_EXPECT(dbMock->setSignals)
+    .once()
+    .with(mock::call([&](const VssSetPairs &pairs) {
+            return pairs.size() == 2 && std::get<0>(pairs[0]) == dtc1 && std::get<0>(pairs[1]) == dtc2;
+          }), "value")
+    .returns(jsoncons::json::array());
+
+  // run UUT
+  auto res = processor->processQuery(jsonSetRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(res.contains("ts"));
+  jsonExpected["ts"]=res["ts"].as_string(); // ignoring timestamp difference for response
+  BOOST_TEST(res == jsonExpected);
+}
+
 ///////////////////////////
 // Test SET Target Value handling
 
@@ -865,7 +1497,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_UserAuthorized_Shall_ReturnS
   MOCK_EXPECT(logMock->Log).at_least( 1 );
 
   MOCK_EXPECT(subsHndlMock->subscribe)
-    .with(mock::any, dbMock, path, "value")
+    .with(mock::any, dbMock, VSSPath::fromVSS(path), "value")
     .returns(subscriptionId);
 
   // run UUT
@@ -881,6 +1513,38 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_UserAuthorized_Shall_ReturnS
   BOOST_TEST(res == jsonSignalValue);
 }
 
+BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_GivenById_Shall_SubscribeResolvedPath)
+{
+  KuksaChannel channel;
+
+  boost::uuids::uuid subscriptionId = boost::uuids::random_generator()();
+  VSSPath vsspath = VSSPath::internVSSGen2("Signal/OBD/DTC1");
+
+  channel.setAuthorized(true);
+  channel.setConnID(1);
+  channel.setType(KuksaChannel::Type::WEBSOCKET_SSL);
+
+  jsoncons::json jsonSubscribeRequest;
+  jsonSubscribeRequest["action"] = "subscribe";
+  jsonSubscribeRequest["id"] = vsspath.id();
+  jsonSubscribeRequest["requestId"] = "1";
+
+  // expectations
+  MOCK_EXPECT(logMock->Log).at_least( 1 );
+  // the path of the id is handed over as is, without a string round trip
+  MOCK_EXPECT(subsHndlMock->subscribe)
+    .once()
+    .with(mock::any, dbMock, vsspath, "value")
+    .returns(subscriptionId);
+
+  // run UUT
+  auto res = processor->processQuery(jsonSubscribeRequest.as_string(), channel);
+
+  // verify
+  BOOST_TEST(!res.contains("error"));
+  BOOST_TEST(res["subscriptionId"].as<std::string>() == boost::uuids::to_string(subscriptionId));
+}
+
 BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_UserAuthorizedButSubIdZero_Shall_ReturnError)
 {
   KuksaChannel channel;
@@ -916,7 +1580,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_UserAuthorizedButSubIdZero_S
   MOCK_EXPECT(logMock->Log).at_least( 1 );
 
   MOCK_EXPECT(subsHndlMock->subscribe)
-    .with(mock::any, dbMock, path, "value")
+    .with(mock::any, dbMock, VSSPath::fromVSS(path), "value")
     .throws(noPathFoundonTree(path));
 
   // run UUT
@@ -960,7 +1624,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_UserNotAuthorized_Shall_Retu
   MOCK_EXPECT(logMock->Log).at_least( 1 );
 
   MOCK_EXPECT(subsHndlMock->subscribe)
-    .with(mock::any, dbMock, path, "value")
+    .with(mock::any, dbMock, VSSPath::fromVSS(path), "value")
     .throws(noPermissionException(""));
 
   // run UUT
@@ -1003,7 +1667,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_PathNotValid_Shall_ReturnErr
   MOCK_EXPECT(logMock->Log).at_least( 1 );
 
   MOCK_EXPECT(subsHndlMock->subscribe)
-    .with(mock::any, dbMock, path, "value")
+    .with(mock::any, dbMock, VSSPath::fromVSS(path), "value")
     .throws(noPathFoundonTree(path));
 
   // run UUT
@@ -1048,7 +1712,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_OutOfBounds_Shall_ReturnErro
   MOCK_EXPECT(logMock->Log).at_least( 1 );
 
   MOCK_EXPECT(subsHndlMock->subscribe)
-    .with(mock::any, dbMock, path, "value")
+    .with(mock::any, dbMock, VSSPath::fromVSS(path), "value")
     .throws(genException(path));
 
   // run UUT
@@ -1092,7 +1756,7 @@ BOOST_AUTO_TEST_CASE(Given_ValidSubscribeQuery_When_SubHandlerThrowsNotExpectedE
   MOCK_EXPECT(logMock->Log).at_least( 1 );
 
   MOCK_EXPECT(subsHndlMock->subscribe)
-    .with(mock::any, dbMock, path, "value")
+    .with(mock::any, dbMock, VSSPath::fromVSS(path), "value")
     .throws(std::exception());
 
   // run UUT
@@ -26,8 +26,13 @@
 
 #include "UnitTestHelpers.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "ILoggerMock.hpp"
 #include "IAccessCheckerMock.hpp"
@@ -37,6 +42,25 @@
 
 #include "VssDatabase.hpp"
 
+/** Gives tests access to the nodes of the current snapshot */
+class VssDatabaseTestAccess {
+  public:
+    static std::shared_ptr<const void> node(VssDatabase &database, const VSSPath &path) {
+      auto snapshot = database.currentSnapshot();
+      auto it = snapshot->pathIndex.find(path);
+      return it == snapshot->pathIndex.end() ? nullptr : it->second;
+    }
+    static std::weak_ptr<const void> snapshot(VssDatabase &database) {
+      std::lock_guard<std::mutex> lock_guard(database.snapshotMutex_);
+      return database.snapshot_;
+    }
+    static std::shared_ptr<const void> slot(VssDatabase &database, const VSSPath &path) {
+      auto snapshot = database.currentSnapshot();
+      auto it = snapshot->pathIndex.find(path);
+      return it == snapshot->pathIndex.end() ? nullptr : it->second->slot;
+    }
+};
+
 namespace {
   // common resources for tests
   std::string validFilename{"test_vss_release_latest.json"};
@@ -519,4 +543,495 @@ BOOST_AUTO_TEST_CASE(getDataTypeForNonExistingPath) {
   BOOST_CHECK_THROW(db->getDatatypeForPath(VSSPath::fromVSS(path)), noPathFoundonTree);
 }
 
+
+/** path index tests **/
+BOOST_AUTO_TEST_CASE(pathIndex_When_UpdateJsonTree_Shall_ResolveNewPath) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+
+  VSSPath newPath = VSSPath::fromVSS("Vehicle/Private/Thruster");
+  BOOST_TEST(db->pathExists(newPath) == false);
+
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {
+      "Private": {"type": "branch", "children": {
+        "Thruster": {"datatype": "uint8", "type": "actuator"}}}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  BOOST_TEST(db->pathExists(newPath) == true);
+  BOOST_TEST(db->pathIsWritable(newPath) == true);
+  BOOST_TEST(db->getDatatypeForPath(newPath) == "uint8");
+  // existing nodes are still resolved after rebuilding the index
+  BOOST_TEST(db->getDatatypeForPath(VSSPath::fromVSS("Vehicle.Speed")) == "float");
+}
+
+BOOST_AUTO_TEST_CASE(pathIndex_When_GetLeafPathsForBranchAndWildcard_Shall_ReturnSameLeaves) {
+  db->initJsonTree(validFilename);
+
+  std::list<VSSPath> branchLeaves = db->getLeafPaths(VSSPath::fromVSSGen1("Vehicle.Acceleration"));
+  std::list<VSSPath> wildcardLeaves = db->getLeafPaths(VSSPath::fromVSSGen1("Vehicle.Acceleration.*"));
+
+  std::list<VSSPath> expectedLeaves{VSSPath::fromVSSGen1("Vehicle.Acceleration.Lateral"),
+                                    VSSPath::fromVSSGen1("Vehicle.Acceleration.Longitudinal"),
+                                    VSSPath::fromVSSGen1("Vehicle.Acceleration.Vertical")};
+  BOOST_CHECK(branchLeaves == expectedLeaves);
+  BOOST_CHECK(wildcardLeaves == expectedLeaves);
+  BOOST_TEST(branchLeaves.front().isGen1Origin() == true);
+}
+
+/** value store tests **/
+BOOST_AUTO_TEST_CASE(valueStore_When_SetSignal_Shall_KeepValueOutOfMetadata) {
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+  jsoncons::json value = 42.5;
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).once().returns(0);
+  db->setSignal(path, "value", value);
+
+  jsoncons::json res = db->getSignal(path, "value");
+  BOOST_TEST(res["dp"]["value"].as<float>() == 42.5f);
+  BOOST_TEST(res["dp"]["ts_s"].as<uint64_t>() > 0);
+  BOOST_TEST(db->getSignal(path, "value", true)["dp"]["value"].as<std::string>() == "42.5");
+
+  jsoncons::json metadata = db->getMetaData(path);
+  jsoncons::json speed = metadata["Vehicle"]["children"]["Speed"];
+  BOOST_TEST(speed.contains("value") == false);
+  BOOST_TEST(speed.contains("ts_s-value") == false);
+}
+
+BOOST_AUTO_TEST_CASE(valueStore_When_TreeUpdated_Shall_KeepValues) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Cabin/Door/Row1/PassengerSide/IsLocked");
+  jsoncons::json value = "true";
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).once().returns(0);
+  db->setSignal(path, "targetValue", value);
+
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {
+      "Speed": {"max": 300}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  BOOST_TEST(db->getSignal(path, "targetValue")["dp"]["targetValue"].as<bool>() == true);
+  BOOST_CHECK_THROW(db->getSignal(path, "value"), notSetException);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_When_MetadataUpdated_Shall_KeepValueAndUseNewMetadata) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+  jsoncons::json value = 100;
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).once().returns(0);
+  db->setSignal(path, "value", value);
+
+  jsoncons::json metadata;
+  metadata["max"] = 90;
+  db->updateMetaData(channel, path, metadata);
+
+  BOOST_TEST(db->getSignal(path, "value")["dp"]["value"].as<float>() == 100.0f);
+  jsoncons::json tooFast = 95;
+  BOOST_CHECK_THROW(db->setSignal(path, "value", tooFast), outOfBoundException);
+}
+
+BOOST_AUTO_TEST_CASE(leafCache_When_TreeUpdated_Shall_ExpandBranchAgain) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  VSSPath branch = VSSPath::fromVSS("Vehicle/Acceleration");
+
+  std::list<VSSPath> leaves = db->getLeafPaths(branch);
+  BOOST_TEST(leaves.size() == 3);
+  // served from cache, must not differ
+  BOOST_CHECK(db->getLeafPaths(branch) == leaves);
+
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {
+      "Acceleration": {"type": "branch", "children": {
+        "Jerk": {"datatype": "float", "type": "sensor"}}}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  leaves = db->getLeafPaths(branch);
+  BOOST_TEST(leaves.size() == 4);
+  BOOST_CHECK(std::find(leaves.begin(), leaves.end(), VSSPath::fromVSS("Vehicle/Acceleration/Jerk")) != leaves.end());
+}
+
+BOOST_AUTO_TEST_CASE(overlay_When_LeafMetadataChanged_Shall_MergeIntoExistingNode) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+  std::list<VSSPath> leaves = db->getLeafPaths(VSSPath::fromVSS("Vehicle"));
+
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"children": {"Speed": {"max": 90}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  // untouched attributes and siblings are kept
+  BOOST_TEST(db->getDatatypeForPath(path) == "float");
+  BOOST_CHECK(db->getLeafPaths(VSSPath::fromVSS("Vehicle")) == leaves);
+  jsoncons::json tooFast = 95;
+  BOOST_CHECK_THROW(db->setSignal(path, "value", tooFast), outOfBoundException);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_When_TreeUpdated_Shall_NotBeRetainedByReadingThread) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  std::weak_ptr<const void> previous = VssDatabaseTestAccess::snapshot(*db);
+
+  // the read keeps the snapshot in the cache of this thread
+  BOOST_TEST(db->pathExists(VSSPath::fromVSS("Vehicle/Speed")) == true);
+  BOOST_TEST(previous.expired() == false);
+
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {
+      "Speed": {"description": "changed"}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  // the update itself read the previous snapshot, which is dropped afterwards
+  BOOST_TEST(previous.expired() == true);
+}
+
+BOOST_AUTO_TEST_CASE(overlay_When_Applied_Shall_OnlyReplaceChangedNodes) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  VSSPath vehicle = VSSPath::fromVSS("Vehicle");
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  VSSPath acceleration = VSSPath::fromVSS("Vehicle/Acceleration");
+  VSSPath lateral = VSSPath::fromVSS("Vehicle/Acceleration/Lateral");
+  auto vehicleNode = VssDatabaseTestAccess::node(*db, vehicle);
+  auto speedNode = VssDatabaseTestAccess::node(*db, speed);
+  auto speedSlot = VssDatabaseTestAccess::slot(*db, speed);
+  auto accelerationNode = VssDatabaseTestAccess::node(*db, acceleration);
+  auto lateralNode = VssDatabaseTestAccess::node(*db, lateral);
+  auto lateralSlot = VssDatabaseTestAccess::slot(*db, lateral);
+
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {"Speed": {"max": 90}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  // the changed leaf is replaced but keeps its slot, everything else is shared
+  BOOST_CHECK(VssDatabaseTestAccess::node(*db, speed) != speedNode);
+  BOOST_CHECK(VssDatabaseTestAccess::slot(*db, speed) == speedSlot);
+  BOOST_CHECK(VssDatabaseTestAccess::node(*db, vehicle) == vehicleNode);
+  BOOST_CHECK(VssDatabaseTestAccess::node(*db, lateral) == lateralNode);
+  BOOST_CHECK(VssDatabaseTestAccess::slot(*db, lateral) == lateralSlot);
+
+  overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"children": {"Acceleration": {"children": {
+      "Jerk": {"datatype": "float", "type": "sensor"}}}}}}
+  )");
+  db->updateJsonTree(channel, overlay);
+
+  // adding a leaf only replaces its parent, which gets a new list of children
+  BOOST_TEST(db->pathExists(VSSPath::fromVSS("Vehicle/Acceleration/Jerk")) == true);
+  BOOST_CHECK(VssDatabaseTestAccess::node(*db, acceleration) != accelerationNode);
+  BOOST_CHECK(VssDatabaseTestAccess::node(*db, vehicle) == vehicleNode);
+  BOOST_CHECK(VssDatabaseTestAccess::node(*db, lateral) == lateralNode);
+  BOOST_CHECK(VssDatabaseTestAccess::slot(*db, lateral) == lateralSlot);
+  BOOST_TEST(db->getLeafPaths(VSSPath::fromVSS("Vehicle/Acceleration/*")).size() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(history_When_MoreValuesThanCapacity_Shall_KeepLatestInOrder) {
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+  BOOST_TEST(db->enableHistory(path, 3) == 1);
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPath).exactly(5).returns(0);
+  for (int speed = 1; speed <= 5; speed++) {
+    jsoncons::json value = speed;
+    db->setSignal(path, "value", value);
+  }
+
+  jsoncons::json history = db->getHistory(path, 0, std::numeric_limits<uint64_t>::max());
+  BOOST_TEST(history["path"].as<std::string>() == "Vehicle.Speed");
+  BOOST_TEST(history["dp"].size() == 3);
+  BOOST_TEST(history["dp"][0]["value"].as<float>() == 3.0f);
+  BOOST_TEST(history["dp"][2]["value"].as<float>() == 5.0f);
+
+  // range is inclusive on both ends
+  uint64_t ts = history["dp"][1]["ts_s"].as<uint64_t>() * 1000000000 + history["dp"][1]["ts_ns"].as<uint64_t>();
+  jsoncons::json range = db->getHistory(path, ts, ts);
+  BOOST_TEST(range["dp"].size() >= 1);
+  BOOST_TEST(range["dp"][0]["value"].as<float>() == 4.0f);
+  BOOST_TEST(db->getHistory(path, 0, 1)["dp"].size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(history_When_AppendedOutOfOrder_Shall_KeepRangesComplete) {
+  auto sample = [](float value, uint64_t ts_s) {
+    VssSample sample;
+    sample.value = VssValue::fromScalar<float>(value);
+    sample.ts_s = ts_s;
+    return sample;
+  };
+  VssSignalHistory history(VssDatatype::FLOAT, 10);
+  history.append(sample(1.0f, 10));
+  history.append(sample(2.0f, 30));
+  // e.g. a concurrent setter storing later or the clock stepping back
+  history.append(sample(3.0f, 20));
+  history.append(sample(4.0f, 40));
+
+  std::vector<VssSample> all = history.query(0, std::numeric_limits<uint64_t>::max());
+  BOOST_TEST_REQUIRE(all.size() == 4u);
+  for (size_t i = 0; i < all.size(); i++) {
+    BOOST_TEST(all[i].value.get<float>() == 1.0f + i);
+  }
+  // the late sample is recorded as of the newest one before
+  BOOST_TEST(all[2].ts_s == 30u);
+
+  std::vector<VssSample> at30 = history.query(30000000000ull, 30000000000ull);
+  BOOST_TEST_REQUIRE(at30.size() == 2u);
+  BOOST_TEST(at30[0].value.get<float>() == 2.0f);
+  BOOST_TEST(at30[1].value.get<float>() == 3.0f);
+  BOOST_TEST(history.query(0, 35000000000ull).size() == 3u);
+  BOOST_TEST(history.query(35000000000ull, std::numeric_limits<uint64_t>::max()).size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(history_When_NotEnabled_Shall_Throw) {
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+  BOOST_CHECK_THROW(db->getHistory(path, 0, std::numeric_limits<uint64_t>::max()), notSetException);
+  BOOST_CHECK_THROW(db->getHistory(VSSPath::fromVSS("Vehicle/Nope"), 0, 1), noPathFoundonTree);
+}
+
+BOOST_AUTO_TEST_CASE(history_When_EnabledForBranch_Shall_RecordAllLeafs) {
+  db->initJsonTree(validFilename);
+  BOOST_TEST(db->enableHistory(VSSPath::fromVSS("Vehicle/Acceleration"), 10) == 3);
+  BOOST_TEST(db->enableHistory(VSSPath::fromVSS("Vehicle/Nope"), 10) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(setSignals_When_AllValid_Shall_SetAllAndPublishOnce) {
+  db->initJsonTree(validFilename);
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  VSSPath lateral = VSSPath::fromVSS("Vehicle/Acceleration/Lateral");
+  VssSetPairs pairs;
+  pairs.push_back(std::make_tuple(speed, jsoncons::json(50)));
+  pairs.push_back(std::make_tuple(lateral, jsoncons::json(1.5)));
+
+  MOCK_EXPECT(subHandlerMock->publishForVSSPaths)
+    .once()
+    .with(mock::call([](const std::vector<VssSignalUpdate> &updates) { return updates.size() == 2; }), "value")
+    .returns(0);
+  jsoncons::json res = db->setSignals(pairs, "value");
+
+  BOOST_TEST(res.size() == 2);
+  BOOST_TEST(db->getSignal(speed, "value")["dp"]["value"].as<float>() == 50.0f);
+  BOOST_TEST(db->getSignal(lateral, "value")["dp"]["value"].as<float>() == 1.5f);
+  // one batch shares one timestamp
+  jsoncons::json speedDp = db->getSignal(speed, "value")["dp"];
+  jsoncons::json lateralDp = db->getSignal(lateral, "value")["dp"];
+  BOOST_TEST(speedDp["ts_s"].as<uint64_t>() == lateralDp["ts_s"].as<uint64_t>());
+  BOOST_TEST(speedDp["ts_ns"].as<uint64_t>() == lateralDp["ts_ns"].as<uint64_t>());
+}
+
+BOOST_AUTO_TEST_CASE(setSignals_When_OneValueInvalid_Shall_SetNothing) {
+  db->initJsonTree(validFilename);
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  VSSPath lateral = VSSPath::fromVSS("Vehicle/Acceleration/Lateral");
+  VssSetPairs pairs;
+  pairs.push_back(std::make_tuple(speed, jsoncons::json(50)));
+  pairs.push_back(std::make_tuple(lateral, jsoncons::json("no number")));
+
+  BOOST_CHECK_THROW(db->setSignals(pairs, "value"), std::exception);
+  BOOST_CHECK_THROW(db->getSignal(speed, "value"), notSetException);
+
+  VssSetPairs unknown;
+  unknown.push_back(std::make_tuple(speed, jsoncons::json(50)));
+  unknown.push_back(std::make_tuple(VSSPath::fromVSS("Vehicle/Nope"), jsoncons::json(1)));
+  BOOST_CHECK_THROW(db->setSignals(unknown, "value"), noPathFoundonTree);
+  BOOST_CHECK_THROW(db->getSignal(speed, "value"), notSetException);
+}
+
+BOOST_AUTO_TEST_CASE(getSignals_When_BatchSet_Shall_ReturnAllInRequestOrder) {
+  db->initJsonTree(validFilename);
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  VSSPath lateral = VSSPath::fromVSS("Vehicle/Acceleration/Lateral");
+  VssSetPairs setPairs;
+  setPairs.push_back(std::make_tuple(speed, jsoncons::json(50)));
+  setPairs.push_back(std::make_tuple(lateral, jsoncons::json(1.5)));
+  MOCK_EXPECT(subHandlerMock->publishForVSSPaths).once().returns(0);
+  db->setSignals(setPairs, "value");
+
+  VssGetPairs getPairs;
+  getPairs.push_back(std::make_tuple(lateral, "value"));
+  getPairs.push_back(std::make_tuple(speed, "value"));
+  jsoncons::json res = db->getSignals(getPairs);
+
+  BOOST_TEST(res.size() == 2);
+  BOOST_TEST(res[0]["path"].as<std::string>() == "Vehicle.Acceleration.Lateral");
+  BOOST_TEST(res[0]["dp"]["value"].as<float>() == 1.5f);
+  BOOST_TEST(res[0]["datatype"].as<std::string>() == "float");
+  BOOST_TEST(res[1]["dp"]["value"].as<float>() == 50.0f);
+  BOOST_TEST(res[0]["dp"]["ts_ns"].as<uint64_t>() == res[1]["dp"]["ts_ns"].as<uint64_t>());
+
+  // string results are meant for clients and do not carry the datatype
+  jsoncons::json strings = db->getSignals(getPairs, true);
+  BOOST_TEST(strings[1]["dp"]["value"].as<std::string>() == "50");
+  BOOST_TEST(strings[1].contains("datatype") == false);
+
+  getPairs.push_back(std::make_tuple(VSSPath::fromVSS("Vehicle/Cabin/Door/Row1/PassengerSide/IsLocked"), "value"));
+  BOOST_CHECK_THROW(db->getSignals(getPairs), notSetException);
+}
+
+BOOST_AUTO_TEST_CASE(getSignals_When_SingleSetsInterleave_Shall_ReturnValuesOfOnePointInTime) {
+  // the mock must not be called from several threads
+  VssDatabase database(logMock, std::make_shared<NullSubscriptionHandler>());
+  database.initJsonTree(validFilename);
+  VSSPath lateral = VSSPath::fromVSS("Vehicle/Acceleration/Lateral");
+  VSSPath longitudinal = VSSPath::fromVSS("Vehicle/Acceleration/Longitudinal");
+  jsoncons::json zero = 0;
+  database.setSignal(lateral, "value", zero);
+  database.setSignal(longitudinal, "value", zero);
+
+  // lateral is always set first, so at any time it equals longitudinal or is one ahead
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    for (int i = 1; !stop; i++) {
+      jsoncons::json value = i % 1000000;
+      database.setSignal(lateral, "value", value);
+      database.setSignal(longitudinal, "value", value);
+    }
+  });
+
+  VssGetPairs getPairs;
+  getPairs.push_back(std::make_tuple(lateral, "value"));
+  getPairs.push_back(std::make_tuple(longitudinal, "value"));
+  int inconsistent = 0;
+  for (int i = 0; i < 20000; i++) {
+    jsoncons::json res = database.getSignals(getPairs);
+    int first = res[0]["dp"]["value"].as<int>();
+    int second = res[1]["dp"]["value"].as<int>();
+    if (first != second && first != (second + 1) % 1000000) {
+      inconsistent++;
+    }
+  }
+  stop = true;
+  writer.join();
+  BOOST_TEST(inconsistent == 0);
+}
+
+BOOST_AUTO_TEST_CASE(getSignals_When_SingleSetsToManySignals_Shall_ReturnValuesOfOnePointInTime) {
+  // the mock must not be called from several threads
+  VssDatabase database(logMock, std::make_shared<NullSubscriptionHandler>());
+  database.initJsonTree(validFilename);
+  // float leafs taking the whole range of values written below
+  std::vector<VSSPath> paths;
+  jsoncons::json zero = 0;
+  for (const auto &path : database.getLeafPaths(VSSPath::fromVSS("Vehicle"))) {
+    if (database.getDatatypeForPath(path) != "float" || paths.size() == 100) {
+      continue;
+    }
+    try {
+      jsoncons::json max = 999999;
+      database.setSignal(path, "value", max);
+      database.setSignal(path, "value", zero);
+      paths.push_back(path);
+    } catch (outOfBoundException &) {
+    }
+  }
+  BOOST_TEST_REQUIRE(paths.size() == 100u);
+
+  // signals are set in request order, so along it values never increase and
+  // the first is at most one ahead of the last. Long reads against a busy
+  // writer also exercise the fallback excluding all sets
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    for (int i = 1; !stop; i++) {
+      jsoncons::json value = i % 1000000;
+      for (const auto &path : paths) {
+        database.setSignal(path, "value", value);
+      }
+    }
+  });
+
+  VssGetPairs getPairs;
+  for (const auto &path : paths) {
+    getPairs.push_back(std::make_tuple(path, "value"));
+  }
+  int inconsistent = 0;
+  for (int i = 0; i < 2000; i++) {
+    jsoncons::json res = database.getSignals(getPairs);
+    int first = res[0]["dp"]["value"].as<int>();
+    int previous = first;
+    for (size_t j = 1; j < paths.size(); j++) {
+      int current = res[j]["dp"]["value"].as<int>();
+      if (current != previous && current != (previous + 999999) % 1000000) {
+        inconsistent++;
+      }
+      previous = current;
+    }
+    if (first != previous && first != (previous + 1) % 1000000) {
+      inconsistent++;
+    }
+  }
+  stop = true;
+  writer.join();
+  BOOST_TEST(inconsistent == 0);
+}
+
+BOOST_AUTO_TEST_CASE(metaData_When_TreeUpdated_Shall_NotReturnCachedResult) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+  VSSPath path = VSSPath::fromVSS("Vehicle/Speed");
+
+  jsoncons::json first = db->getMetaData(path);
+  BOOST_CHECK(db->getMetaData(path) == first);
+  BOOST_TEST(first["Vehicle"]["children"].size() == 1);
+
+  jsoncons::json metadata;
+  metadata["max"] = 90;
+  db->updateMetaData(channel, path, metadata);
+
+  jsoncons::json updated = db->getMetaData(path);
+  BOOST_TEST(updated["Vehicle"]["children"]["Speed"]["max"].as<int>() == 90);
+  BOOST_TEST(updated["Vehicle"]["description"] == first["Vehicle"]["description"]);
+}
+
+BOOST_AUTO_TEST_CASE(metaData_When_TreeDeeperThan16_Shall_ReturnAllAncestors) {
+  KuksaChannel channel;
+  channel.enableModifyTree();
+  db->initJsonTree(validFilename);
+
+  std::string vssPath = "Vehicle";
+  jsoncons::json leaf = jsoncons::json::parse(R"({"datatype": "uint8", "type": "sensor"})");
+  jsoncons::json nested;
+  nested["Leaf"] = leaf;
+  for (int depth = 20; depth > 0; depth--) {
+    jsoncons::json branch;
+    branch["type"] = "branch";
+    branch["children"] = nested;
+    nested = jsoncons::json();
+    nested["Level" + std::to_string(depth)] = branch;
+  }
+  for (int depth = 1; depth <= 20; depth++) {
+    vssPath += "/Level" + std::to_string(depth);
+  }
+  jsoncons::json overlay;
+  jsoncons::json vehicle;
+  vehicle["type"] = "branch";
+  vehicle["children"] = nested;
+  overlay["Vehicle"] = vehicle;
+  db->updateJsonTree(channel, overlay);
+
+  jsoncons::json result = db->getMetaData(VSSPath::fromVSS(vssPath + "/Leaf"));
+  jsoncons::json node = result["Vehicle"];
+  for (int depth = 1; depth <= 20; depth++) {
+    node = node["children"]["Level" + std::to_string(depth)];
+  }
+  BOOST_CHECK(node["children"]["Leaf"] == leaf);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
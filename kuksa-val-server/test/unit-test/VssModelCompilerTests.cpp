@@ -0,0 +1,169 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+
+#include <boost/test/unit_test.hpp>
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <turtle/mock.hpp>
+#undef BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+#include "UnitTestHelpers.hpp"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "ILoggerMock.hpp"
+#include "KuksaChannel.hpp"
+#include "exception.hpp"
+#include "VssDatabase.hpp"
+#include "VssModelCompiler.hpp"
+#include "VssSignalDescriptor.hpp"
+
+namespace {
+  std::string validFilename{"test_vss_release_latest.json"};
+  boost::filesystem::path compiledFile{"test_vss_compiled.bin"};
+
+  jsoncons::json readVss() {
+    std::ifstream is(validFilename);
+    return jsoncons::json::parse(is);
+  }
+
+  /** Node table of tree in pre-order, as the model is expected to hold it */
+  void flatten(const jsoncons::json &tree, const std::string &parentPath, std::vector<VssCompiledNode> &nodes) {
+    for (const auto &member : tree.object_range()) {
+      std::string path = parentPath.empty() ? std::string(member.key()) : parentPath + "/" + std::string(member.key());
+      size_t index = nodes.size();
+      nodes.push_back(VssCompiledNode{path, member.value(), {}, VssCompiledNode::NO_DESCRIPTOR});
+      nodes[index].element.erase("children");
+      if (member.value().contains("children")) {
+        for (const auto &child : member.value()["children"].object_range()) {
+          nodes[index].children.push_back(std::string(child.key()));
+        }
+        flatten(member.value()["children"], path, nodes);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( VssModelCompilerTests )
+
+BOOST_AUTO_TEST_CASE(Given_CompiledModel_When_Loaded_Shall_ReturnNodesOfTree) {
+  jsoncons::json tree = readVss();
+  uint64_t hash = compiledModelHash(validFilename, {});
+  writeCompiledModel(compiledFile, tree, hash);
+
+  VssCompiledModel loaded;
+  BOOST_TEST(loadCompiledModel(compiledFile, hash, loaded) == true);
+  std::vector<VssCompiledNode> expected;
+  flatten(tree, "", expected);
+  BOOST_TEST_REQUIRE(loaded.nodes.size() == expected.size());
+  BOOST_TEST(loaded.roots == std::vector<std::string>{"Vehicle"}, boost::test_tools::per_element());
+
+  size_t leafs = 0;
+  for (size_t i = 0; i < expected.size(); i++) {
+    const VssCompiledNode &node = loaded.nodes[i];
+    BOOST_TEST(node.path == expected[i].path);
+    BOOST_TEST(node.element == expected[i].element);
+    BOOST_TEST(node.children == expected[i].children, boost::test_tools::per_element());
+    if (node.element["type"] == "branch") {
+      BOOST_TEST(node.descriptor == VssCompiledNode::NO_DESCRIPTOR);
+    } else {
+      leafs++;
+      BOOST_TEST_REQUIRE(node.descriptor < loaded.descriptors.size());
+      BOOST_TEST(loaded.descriptors[node.descriptor] == VssSignalDescriptor::definitionOf(node.element));
+    }
+  }
+  // leafs of the same type and limits share their descriptor
+  BOOST_TEST(loaded.descriptors.size() < leafs);
+  boost::filesystem::remove(compiledFile);
+}
+
+BOOST_AUTO_TEST_CASE(Given_JsonTreeWithOverlay_When_StartedFromCompiledModel_Shall_MatchJsonStart) {
+  auto logMock = std::make_shared<ILoggerMock>();
+  MOCK_EXPECT(logMock->Log).at_least(0); // ignore log events
+  auto subHandler = std::make_shared<NullSubscriptionHandler>();
+  KuksaChannel channel;
+  channel.enableModifyTree();
+
+  VssDatabase fromJson(logMock, subHandler);
+  fromJson.initJsonTree(validFilename);
+  jsoncons::json overlay = jsoncons::json::parse(R"(
+    {"Vehicle": {"type": "branch", "children": {
+      "Speed": {"value": 42},
+      "Cabin": {"type": "branch", "children": {
+        "DoorCount": {"value": 2}}},
+      "ADAS": {"type": "branch", "children": {
+        "PowerOptimizeLevel": {"targetValue": 3}}},
+      "Private": {"type": "branch", "children": {
+        "Serial": {"datatype": "string", "type": "attribute", "value": "ABC-123"}}}}}}
+  )");
+  fromJson.updateJsonTree(channel, overlay);
+
+  uint64_t hash = compiledModelHash(validFilename, {});
+  writeCompiledModel(compiledFile, fromJson.getTree(true), hash);
+  VssCompiledModel model;
+  BOOST_TEST_REQUIRE(loadCompiledModel(compiledFile, hash, model) == true);
+  VssDatabase fromModel(logMock, subHandler);
+  fromModel.initCompiledModel(std::move(model));
+
+  BOOST_TEST(fromModel.getTree(true) == fromJson.getTree(true));
+  BOOST_TEST(fromModel.getTree() == fromJson.getTree());
+  // overlay values, overridden and plain defaults survive the compilation
+  BOOST_TEST(fromModel.getSignal(VSSPath::fromVSS("Vehicle/Speed"), "value")["dp"]["value"] == 42.0);
+  BOOST_TEST(fromModel.getSignal(VSSPath::fromVSS("Vehicle/Cabin/DoorCount"), "value")["dp"]["value"] == 2);
+  BOOST_TEST(fromModel.getSignal(VSSPath::fromVSS("Vehicle/Chassis/AxleCount"), "value")["dp"]["value"] == 2);
+  BOOST_TEST(fromModel.getSignal(VSSPath::fromVSS("Vehicle/ADAS/PowerOptimizeLevel"), "targetValue")["dp"]["targetValue"] == 3);
+  BOOST_TEST(fromModel.getSignal(VSSPath::fromVSS("Vehicle/Private/Serial"), "value")["dp"]["value"] == "ABC-123");
+  // limits are still checked with the shared descriptors
+  jsoncons::json tooHigh(11);
+  BOOST_CHECK_THROW(fromModel.setSignal(VSSPath::fromVSS("Vehicle/ADAS/PowerOptimizeLevel"), "targetValue", tooHigh),
+                    outOfBoundException);
+  boost::filesystem::remove(compiledFile);
+}
+
+BOOST_AUTO_TEST_CASE(Given_CompiledModel_When_SourcesChanged_Shall_NotLoad) {
+  jsoncons::json tree = readVss();
+  uint64_t hash = compiledModelHash(validFilename, {});
+  writeCompiledModel(compiledFile, tree, hash);
+
+  VssCompiledModel loaded;
+  BOOST_TEST(loadCompiledModel(compiledFile, hash + 1, loaded) == false);
+  boost::filesystem::remove(compiledFile);
+}
+
+BOOST_AUTO_TEST_CASE(Given_TruncatedCompiledModel_When_Loaded_Shall_NotLoad) {
+  jsoncons::json tree = readVss();
+  uint64_t hash = compiledModelHash(validFilename, {});
+  writeCompiledModel(compiledFile, tree, hash);
+  boost::filesystem::resize_file(compiledFile, boost::filesystem::file_size(compiledFile) / 2);
+
+  VssCompiledModel loaded;
+  BOOST_TEST(loadCompiledModel(compiledFile, hash, loaded) == false);
+  boost::filesystem::remove(compiledFile);
+}
+
+BOOST_AUTO_TEST_CASE(Given_MissingCompiledModel_When_Loaded_Shall_NotLoad) {
+  VssCompiledModel loaded;
+  BOOST_TEST(loadCompiledModel("does_not_exist.bin", 0, loaded) == false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
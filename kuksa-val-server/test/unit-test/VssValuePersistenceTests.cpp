@@ -0,0 +1,170 @@
+/**********************************************************************
+ * Copyright (c) 2022 Robert Bosch GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Contributors:
+ *      Robert Bosch GmbH
+ **********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <turtle/mock.hpp>
+#undef BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ILoggerMock.hpp"
+#include "ISubscriptionHandlerMock.hpp"
+#include "UnitTestHelpers.hpp"
+#include "exception.hpp"
+
+#include "VssDatabase.hpp"
+#include "VssValuePersistence.hpp"
+
+namespace {
+  std::string validFilename{"test_vss_release_latest.json"};
+  boost::filesystem::path persistenceDir{"test_persistence"};
+
+  std::shared_ptr<ILoggerMock> logMock;
+  std::shared_ptr<ISubscriptionHandlerMock> subHandlerMock;
+
+  /** Starts a database with persistence, like the server does after a restart */
+  std::unique_ptr<VssDatabase> startDatabase(VssSyncPolicy policy = VssSyncPolicy::INTERVAL,
+                                             std::shared_ptr<ISubscriptionHandler> subHandler = nullptr) {
+    auto db = std::make_unique<VssDatabase>(logMock, subHandler ? subHandler : subHandlerMock);
+    db->initJsonTree(validFilename);
+    VssPersistenceConfig config;
+    config.directory = persistenceDir;
+    config.syncPolicy = policy;
+    db->enablePersistence(std::make_shared<VssValuePersistence>(logMock, config));
+    return db;
+  }
+
+  struct TestSuiteFixture {
+    TestSuiteFixture() {
+      logMock = std::make_shared<ILoggerMock>();
+      subHandlerMock = std::make_shared<ISubscriptionHandlerMock>();
+      MOCK_EXPECT(logMock->Log).at_least(0);
+      MOCK_EXPECT(subHandlerMock->publishForVSSPath).at_least(0).returns(0);
+      boost::filesystem::remove_all(persistenceDir);
+    }
+    ~TestSuiteFixture() {
+      boost::filesystem::remove_all(persistenceDir);
+      subHandlerMock.reset();
+      logMock.reset();
+    }
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(VssValuePersistenceTests, TestSuiteFixture)
+
+BOOST_AUTO_TEST_CASE(Given_PersistedValues_When_Restarted_Shall_RestoreLastValues) {
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  {
+    auto db = startDatabase();
+    BOOST_CHECK_THROW(db->getSignal(speed, "value"), notSetException);
+    jsoncons::json value = 50;
+    db->setSignal(speed, "value", value);
+    value = 60;
+    db->setSignal(speed, "value", value);
+  }
+
+  auto db = startDatabase();
+  BOOST_TEST(db->getSignal(speed, "value")["dp"]["value"].as<float>() == 60.0f);
+}
+
+BOOST_AUTO_TEST_CASE(Given_SyncAlways_When_Restarted_Shall_RestoreLastValues) {
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  {
+    auto db = startDatabase(VssSyncPolicy::ALWAYS);
+    jsoncons::json value = 70;
+    db->setSignal(speed, "value", value);
+  }
+
+  auto db = startDatabase(VssSyncPolicy::ALWAYS);
+  BOOST_TEST(db->getSignal(speed, "value")["dp"]["value"].as<float>() == 70.0f);
+}
+
+BOOST_AUTO_TEST_CASE(Given_ConcurrentSetsOfOneSignal_When_Restarted_Shall_RestoreLiveValue) {
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  float live;
+  {
+    // the mock must not be called from several threads
+    auto db = startDatabase(VssSyncPolicy::INTERVAL, std::make_shared<NullSubscriptionHandler>());
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+      writers.emplace_back([&db, &speed, t]() {
+        for (int i = 0; i < 500; i++) {
+          jsoncons::json value = t * 1000 + i;
+          db->setSignal(speed, "value", value);
+        }
+      });
+    }
+    for (auto &writer : writers) {
+      writer.join();
+    }
+    live = db->getSignal(speed, "value")["dp"]["value"].as<float>();
+  }
+
+  auto db = startDatabase();
+  BOOST_TEST(db->getSignal(speed, "value")["dp"]["value"].as<float>() == live);
+}
+
+BOOST_AUTO_TEST_CASE(Given_CompactedLog_When_Restarted_Shall_RestoreFromSnapshot) {
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  VssPersistenceConfig config;
+  config.directory = persistenceDir;
+  auto persistence = std::make_shared<VssValuePersistence>(logMock, config);
+  {
+    auto db = std::make_unique<VssDatabase>(logMock, subHandlerMock);
+    db->initJsonTree(validFilename);
+    db->enablePersistence(persistence);
+    jsoncons::json value = 80;
+    db->setSignal(speed, "value", value);
+    persistence->compact();
+    value = 90;
+    db->setSignal(speed, "value", value);
+  }
+  BOOST_TEST(boost::filesystem::exists(persistenceDir / "values.snapshot"));
+  BOOST_TEST(!boost::filesystem::exists(persistenceDir / "values.0.wal"));
+
+  auto db = startDatabase();
+  BOOST_TEST(db->getSignal(speed, "value")["dp"]["value"].as<float>() == 90.0f);
+}
+
+BOOST_AUTO_TEST_CASE(Given_TornRecordAtEndOfLog_When_Restarted_Shall_RestorePreviousRecords) {
+  VSSPath speed = VSSPath::fromVSS("Vehicle/Speed");
+  {
+    auto db = startDatabase();
+    jsoncons::json value = 40;
+    db->setSignal(speed, "value", value);
+  }
+  {
+    std::ofstream wal((persistenceDir / "values.0.wal").string(), std::ios::binary | std::ios::app);
+    // record header announcing more payload than has been written
+    const char torn[] = {0x20, 0x00, 0x00, 0x00, 0x01, 0x02};
+    wal.write(torn, sizeof(torn));
+  }
+
+  auto db = startDatabase();
+  BOOST_TEST(db->getSignal(speed, "value")["dp"]["value"].as<float>() == 40.0f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
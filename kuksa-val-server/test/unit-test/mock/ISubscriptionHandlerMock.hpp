@@ -32,11 +32,12 @@ MOCK_BASE_CLASS( ISubscriptionHandlerMock, ISubscriptionHandler )
   MOCK_METHOD(subscribe, 4)
   MOCK_METHOD(unsubscribe, 1)
   MOCK_METHOD(unsubscribeAll, 1)
+  MOCK_METHOD(unsubscribeExpired, 0)
   MOCK_METHOD(publishForVSSPath, 4)
+  MOCK_METHOD(publishForVSSPaths, 2)
   MOCK_METHOD(getServer, 0)
   MOCK_METHOD(startThread, 0)
   MOCK_METHOD(stopThread, 0)
   MOCK_CONST_METHOD(isThreadRunning, 0, bool(void))
-  MOCK_METHOD(subThreadRunner, 0, void*(void))
   MOCK_METHOD(addPublisher, 1, void(std::shared_ptr<IPublisher>))
 };
@@ -33,7 +33,10 @@ MOCK_BASE_CLASS( IVssDatabaseMock, IVssDatabase )
   MOCK_METHOD(updateMetaData, 3)
   MOCK_METHOD(getMetaData, 1)
   MOCK_METHOD(setSignal, 3)
+  MOCK_METHOD(setSignals, 2)
   MOCK_METHOD(getSignal, 3 )
+  MOCK_METHOD(getSignals, 2)
+  MOCK_METHOD(getHistory, 4)
   MOCK_METHOD(pathExists, 1)
   MOCK_METHOD(pathIsWritable, 1)
   MOCK_METHOD(pathIsReadable, 1)